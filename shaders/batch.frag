@@ -0,0 +1,10 @@
+#version 430 core
+
+in vec3 oClr;
+
+out vec4 FragClr;
+
+void main()
+{
+    FragClr = vec4(oClr.xyz, 1.f);
+}
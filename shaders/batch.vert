@@ -0,0 +1,32 @@
+#version 430 core
+#extension GL_ARB_shader_draw_parameters : enable
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aClr;
+
+struct DrawData
+{
+    vec4 color;
+};
+
+layout (std430, binding = 0) readonly buffer DrawDataBuffer
+{
+    DrawData draws[];
+};
+
+// Added to the draw id, used when the draws are issued one by one
+uniform int draw_offset;
+
+out vec3 oClr;
+
+void main()
+{
+#ifdef GL_ARB_shader_draw_parameters
+    int drawId = gl_DrawIDARB + draw_offset;
+#else
+    int drawId = draw_offset;
+#endif
+    vec4 drawClr = draws[drawId].color;
+
+    gl_Position = vec4(aPos.xyz, 1.f);
+    oClr = mix(aClr, drawClr.rgb, drawClr.a);
+}
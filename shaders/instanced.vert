@@ -0,0 +1,15 @@
+#version 420 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aClr;
+// Per instance
+layout (location = 2) in vec2 iOffset;
+layout (location = 3) in float iScale;
+layout (location = 4) in vec3 iClr;
+
+out vec3 oClr;
+
+void main()
+{
+    gl_Position = vec4(aPos.xy * iScale + iOffset, aPos.z, 1.f);
+    oClr = aClr * iClr;
+}
@@ -0,0 +1,13 @@
+#version 420 core
+
+in vec2 oUv;
+in vec4 oClr;
+
+layout (binding = 0) uniform sampler2D tex;
+
+out vec4 FragClr;
+
+void main()
+{
+    FragClr = texture(tex, oUv) * oClr;
+}
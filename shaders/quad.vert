@@ -0,0 +1,14 @@
+#version 420 core
+layout (location = 0) in vec2 aPos;
+layout (location = 1) in vec2 aUv;
+layout (location = 2) in vec4 aClr;
+
+out vec2 oUv;
+out vec4 oClr;
+
+void main()
+{
+    gl_Position = vec4(aPos, 0.f, 1.f);
+    oUv = aUv;
+    oClr = aClr;
+}
@@ -0,0 +1,17 @@
+#version 420 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aClr;
+
+// Per draw data of the render queue, see Scene.h
+layout (std140, binding = 0) uniform Object
+{
+    mat4 model_view_projection;
+};
+
+out vec3 oClr;
+
+void main()
+{
+    gl_Position = model_view_projection * vec4(aPos.xyz, 1.f);
+    oClr = aClr;
+}
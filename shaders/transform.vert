@@ -0,0 +1,22 @@
+#version 430 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aClr;
+
+// World matrices of a TransformHierarchy, see TransformHierarchy.h
+layout (std430, binding = 1) readonly buffer WorldMatrices
+{
+    mat4 world[];
+};
+
+// Index of the node drawn by instance 0
+uniform int first_transform;
+
+out vec3 oClr;
+
+void main()
+{
+    int node = first_transform + gl_InstanceID;
+
+    gl_Position = world[node] * vec4(aPos.xyz, 1.f);
+    oClr = aClr * (0.4f + 0.6f * fract(vec3(0.37f, 0.61f, 0.83f) * float(node)));
+}
@@ -0,0 +1,170 @@
+#include "BatchRenderer.h"
+
+#include <cassert>
+#include <numeric>
+#include <iostream>
+
+#include "Capabilities.h"
+#include "StateCache.h"
+
+BatchRenderer::BatchRenderer(const Gl::BufferLayout& layout, uint32_t maxVertices, uint32_t maxIndices, uint32_t maxDraws)
+	:
+	m_Layout(layout),
+	m_MaxVertices(maxVertices),
+	m_MaxIndices(maxIndices),
+	m_MaxDraws(maxDraws),
+	m_IndexType(maxVertices <= 0x10000 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT),
+	m_VertexArray(std::make_unique<Gl::VertexArray>()),
+	m_VertexBuffer(Gl::VertexBuffer::Create(layout)),
+	m_IndexBuffer(Gl::IndexBuffer::Create())
+{
+	m_VertexBuffer->EnsureCapacity(static_cast<size_t>(maxVertices) * layout.GetStride());
+	m_IndexBuffer->EnsureCapacity(maxIndices, m_IndexType);
+
+	m_VertexArray->AddVertexBuffer(m_VertexBuffer);
+	m_VertexArray->SetIndexBuffer(m_IndexBuffer);
+
+	glCreateBuffers(1, &m_IndirectBuffer);
+	glNamedBufferData(m_IndirectBuffer, maxDraws * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_DRAW);
+
+	glCreateBuffers(1, &m_DrawDataBuffer);
+	glNamedBufferData(m_DrawDataBuffer, maxDraws * sizeof(BatchDrawData), nullptr, GL_DYNAMIC_DRAW);
+
+	m_Commands.reserve(maxDraws);
+	m_DrawData.reserve(maxDraws);
+}
+
+BatchRenderer::~BatchRenderer()
+{
+	glDeleteBuffers(1, &m_IndirectBuffer);
+	glDeleteBuffers(1, &m_DrawDataBuffer);
+	Gl::StateCache::OnBufferDeleted(m_IndirectBuffer);
+	Gl::StateCache::OnBufferDeleted(m_DrawDataBuffer);
+}
+
+void BatchRenderer::SetShader(const std::shared_ptr<Gl::Shader>& shader)
+{
+	m_Shader = shader;
+	m_DrawOffset = shader->GetUniform<int>("draw_offset");
+}
+
+bool BatchRenderer::SupportsDrawId()
+{
+	// Only the extension, batch.vert is #version 430 and reads gl_DrawIDARB, core 4.6 alone isn't enough
+	static const bool supported = Gl::HasExtension("GL_ARB_shader_draw_parameters");
+	return supported;
+}
+
+int32_t BatchRenderer::AddMesh(const DynamicMesh& mesh)
+{
+	if (mesh.GetLayout().GetStride() != m_Layout.GetStride())
+	{
+		std::cerr << "Mesh layout doesn't match the batch layout\n";
+		return -1;
+	}
+
+	const auto& vertices = mesh.GetVertexData<float>();
+	const uint32_t vertexCount = vertices.size() * sizeof(float) / m_Layout.GetStride();
+
+	if (mesh.GetDrawType() == GL_TRIANGLE_STRIP && mesh.GetIndexData().empty())
+	{
+		// Alternate the winding so every triangle keeps the strip's orientation
+		std::vector<uint32_t> indices;
+		indices.reserve(vertexCount > 2 ? (vertexCount - 2) * 3 : 0);
+		for (uint32_t i = 0; i + 2 < vertexCount; i++)
+		{
+			indices.push_back(i % 2 ? i + 1 : i);
+			indices.push_back(i % 2 ? i : i + 1);
+			indices.push_back(i + 2);
+		}
+		return AddMesh(vertices.data(), vertexCount, indices.data(), indices.size());
+	}
+
+	if (mesh.GetDrawType() != GL_TRIANGLES)
+	{
+		std::cerr << "Only triangle lists and strips can be batched\n";
+		return -1;
+	}
+
+	if (mesh.GetIndexData().empty())
+	{
+		std::vector<uint32_t> indices(vertexCount);
+		std::iota(indices.begin(), indices.end(), 0);
+		return AddMesh(vertices.data(), vertexCount, indices.data(), indices.size());
+	}
+
+	const auto& indices = mesh.GetIndexData();
+	return AddMesh(vertices.data(), vertexCount, indices.data(), indices.size());
+}
+
+int32_t BatchRenderer::AddMesh(const float* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount)
+{
+	if (m_VertexCount + vertexCount > m_MaxVertices || m_IndexCount + indexCount > m_MaxIndices)
+	{
+		std::cerr << "Batch is full, can't add a mesh with " << vertexCount << " vertices\n";
+		return -1;
+	}
+
+	const uint32_t stride = m_Layout.GetStride();
+	m_VertexBuffer->UpdateSubData(vertices, static_cast<size_t>(m_VertexCount) * stride, static_cast<size_t>(vertexCount) * stride);
+	m_IndexBuffer->UpdateSubData(indices, m_IndexCount, indexCount);
+
+	m_Meshes.push_back({ m_IndexCount, indexCount, static_cast<int32_t>(m_VertexCount) });
+	m_VertexCount += vertexCount;
+	m_IndexCount += indexCount;
+
+	return m_Meshes.size() - 1;
+}
+
+void BatchRenderer::Begin()
+{
+	m_Commands.clear();
+	m_DrawData.clear();
+}
+
+void BatchRenderer::Submit(int32_t meshId, const BatchDrawData& data)
+{
+	assert(meshId >= 0 && meshId < static_cast<int32_t>(m_Meshes.size()));
+
+	if (m_Commands.size() == m_MaxDraws)
+	{
+		std::cerr << "Batch draw limit reached, dropping a draw\n";
+		return;
+	}
+
+	const auto& mesh = m_Meshes[meshId];
+	m_Commands.push_back({ mesh.IndexCount, 1, mesh.FirstIndex, mesh.BaseVertex, 0 });
+	m_DrawData.push_back(data);
+}
+
+void BatchRenderer::End()
+{
+	if (m_Commands.empty() || !m_Shader)
+	{
+		return;
+	}
+
+	glNamedBufferSubData(m_IndirectBuffer, 0, m_Commands.size() * sizeof(DrawElementsIndirectCommand), m_Commands.data());
+	glNamedBufferSubData(m_DrawDataBuffer, 0, m_DrawData.size() * sizeof(BatchDrawData), m_DrawData.data());
+
+	m_Shader->Bind();
+	m_VertexArray->Bind();
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_DrawDataBuffer);
+
+	if (SupportsDrawId())
+	{
+		m_Shader->Set(m_DrawOffset, 0);
+		Gl::StateCache::BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_IndirectBuffer);
+		glMultiDrawElementsIndirect(GL_TRIANGLES, m_IndexType, nullptr, m_Commands.size(), 0);
+		return;
+	}
+
+	const uint32_t typeSize = Gl::IndexBuffer::TypeSize(m_IndexType);
+	for (uint32_t i = 0; i < m_Commands.size(); i++)
+	{
+		const auto& command = m_Commands[i];
+		m_Shader->Set(m_DrawOffset, static_cast<int>(i));
+		glDrawElementsBaseVertex(GL_TRIANGLES, command.Count, m_IndexType,
+			reinterpret_cast<const void*>(command.FirstIndex * typeSize), command.BaseVertex);
+	}
+}
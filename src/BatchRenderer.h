@@ -0,0 +1,87 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "VertexArray.h"
+#include "DynamicMesh.h"
+#include "Shader.h"
+
+// Draws many meshes that share a BufferLayout with a single glMultiDrawElementsIndirect
+// Mesh geometry is copied once into shared vertex/index buffers, every frame Submit adds
+// an indirect command for a mesh and its per-draw data (color) goes to an SSBO that the
+// shader reads with gl_DrawID, see shaders/batch.vert.
+// Without GL_ARB_shader_draw_parameters the draws are issued one by one with a draw offset uniform.
+
+struct DrawElementsIndirectCommand
+{
+	uint32_t Count;
+	uint32_t InstanceCount;
+	uint32_t FirstIndex;
+	int32_t BaseVertex;
+	uint32_t BaseInstance;
+};
+
+struct BatchDrawData
+{
+	// rgb replaces the vertex color by a
+	glm::vec4 Color;
+};
+
+class BatchRenderer
+{
+public:
+	BatchRenderer(const Gl::BufferLayout& layout, uint32_t maxVertices, uint32_t maxIndices, uint32_t maxDraws);
+	~BatchRenderer();
+
+	BatchRenderer(const BatchRenderer&) = delete;
+	BatchRenderer& operator=(const BatchRenderer&) = delete;
+
+	void SetShader(const std::shared_ptr<Gl::Shader>& shader);
+
+	// Copies the mesh from its CPU side buffers, triangle strips are converted to triangle lists
+	// Returns the id used with Submit, -1 if the batch is full or the layout doesn't match
+	int32_t AddMesh(const DynamicMesh& mesh);
+	int32_t AddMesh(const float* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount);
+
+	void Begin();
+	void Submit(int32_t meshId, const BatchDrawData& data);
+	// Binds the shader and draws everything submitted since Begin
+	void End();
+
+	uint32_t GetDrawCount() const { return m_Commands.size(); }
+	uint32_t GetMeshCount() const { return m_Meshes.size(); }
+	static bool SupportsDrawId();
+private:
+	struct MeshRange
+	{
+		uint32_t FirstIndex;
+		uint32_t IndexCount;
+		int32_t BaseVertex;
+	};
+
+	Gl::BufferLayout m_Layout;
+	uint32_t m_MaxVertices;
+	uint32_t m_MaxIndices;
+	uint32_t m_MaxDraws;
+	GLenum m_IndexType; // mesh indices are relative to the base vertex, 16 bits when no mesh can exceed them
+	uint32_t m_VertexCount{ 0 };
+	uint32_t m_IndexCount{ 0 };
+
+	std::unique_ptr<Gl::VertexArray> m_VertexArray;
+	std::shared_ptr<Gl::VertexBuffer> m_VertexBuffer;
+	std::shared_ptr<Gl::IndexBuffer> m_IndexBuffer;
+	GLuint m_IndirectBuffer;
+	GLuint m_DrawDataBuffer;
+
+	std::shared_ptr<Gl::Shader> m_Shader;
+	Gl::Uniform<int> m_DrawOffset;
+
+	std::vector<MeshRange> m_Meshes;
+	std::vector<DrawElementsIndirectCommand> m_Commands;
+	std::vector<BatchDrawData> m_DrawData;
+};
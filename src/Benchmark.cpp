@@ -0,0 +1,99 @@
+#include "Benchmark.h"
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <numeric>
+#include <algorithm>
+
+#include <glad/glad.h>
+
+Benchmark::Benchmark(uint32_t frames, uint32_t warmupFrames)
+	:
+	m_Frames(frames > 0 ? frames : 1),
+	m_WarmupFrames(warmupFrames)
+{
+	m_FrameTimes.reserve(m_Frames);
+}
+
+const BenchmarkResult& Benchmark::Run(const std::string& scene, const std::function<void()>& frame)
+{
+	using Clock = std::chrono::steady_clock;
+
+	for (uint32_t i = 0; i < m_WarmupFrames; i++)
+	{
+		frame();
+		glFinish();
+	}
+
+	m_FrameTimes.clear();
+
+	for (uint32_t i = 0; i < m_Frames; i++)
+	{
+		const auto start = Clock::now();
+		frame();
+		glFinish();
+		const auto end = Clock::now();
+
+		m_FrameTimes.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+	}
+
+	std::sort(m_FrameTimes.begin(), m_FrameTimes.end());
+
+	const size_t p99Idx = static_cast<size_t>(std::ceil(0.99 * m_FrameTimes.size())) - 1;
+
+	m_Results.push_back({
+		scene,
+		m_Frames,
+		m_FrameTimes.front(),
+		std::accumulate(m_FrameTimes.begin(), m_FrameTimes.end(), 0.0) / m_FrameTimes.size(),
+		m_FrameTimes[p99Idx]
+	});
+
+	return m_Results.back();
+}
+
+void Benchmark::Print(std::ostream& out) const
+{
+	out << std::left << std::setw(16) << "scene"
+		<< std::right << std::setw(8) << "frames"
+		<< std::setw(12) << "min ms"
+		<< std::setw(12) << "avg ms"
+		<< std::setw(12) << "p99 ms" << "\n";
+
+	out << std::fixed << std::setprecision(4);
+	for (const auto& result : m_Results)
+	{
+		out << std::left << std::setw(16) << result.Scene
+			<< std::right << std::setw(8) << result.Frames
+			<< std::setw(12) << result.MinMs
+			<< std::setw(12) << result.AvgMs
+			<< std::setw(12) << result.P99Ms << "\n";
+	}
+	out << std::defaultfloat;
+}
+
+bool Benchmark::WriteCsv(const std::string& filepath) const
+{
+	std::ofstream file(filepath, std::ios::out | std::ios::trunc);
+
+	if (!file.is_open())
+	{
+		std::cerr << "Error opening file " << filepath << "\n";
+		return false;
+	}
+
+	file << "scene,frames,min_ms,avg_ms,p99_ms\n";
+	file << std::fixed << std::setprecision(6);
+	for (const auto& result : m_Results)
+	{
+		file << result.Scene << ","
+			<< result.Frames << ","
+			<< result.MinMs << ","
+			<< result.AvgMs << ","
+			<< result.P99Ms << "\n";
+	}
+
+	return true;
+}
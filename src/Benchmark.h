@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <iostream>
+#include <functional>
+
+// Runs a frame callback a fixed amount of times and collects frame time statistics
+// Every frame is finished with glFinish so the measured time includes the GPU work
+
+struct BenchmarkResult
+{
+	std::string Scene;
+	uint32_t Frames;
+	double MinMs;
+	double AvgMs;
+	double P99Ms;
+};
+
+class Benchmark
+{
+public:
+	Benchmark(uint32_t frames, uint32_t warmupFrames = 10);
+
+	const BenchmarkResult& Run(const std::string& scene, const std::function<void()>& frame);
+
+	const std::vector<BenchmarkResult>& GetResults() const { return m_Results; }
+
+	void Print(std::ostream& out) const;
+	bool WriteCsv(const std::string& filepath) const;
+private:
+	uint32_t m_Frames;
+	uint32_t m_WarmupFrames;
+	std::vector<double> m_FrameTimes;
+	std::vector<BenchmarkResult> m_Results;
+};
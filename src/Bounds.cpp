@@ -0,0 +1,245 @@
+#include "Bounds.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "VertexEncoding.h"
+
+Aabb Aabb::Infinite()
+{
+	Aabb box;
+	box.Min = glm::vec3(-std::numeric_limits<float>::infinity());
+	box.Max = glm::vec3(std::numeric_limits<float>::infinity());
+	return box;
+}
+
+bool Aabb::IsInfinite() const
+{
+	for (int i = 0; i < 3; i++)
+	{
+		if (std::isinf(Min[i]) || std::isinf(Max[i]))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void Aabb::Extend(const glm::vec3& point)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		Min[i] = std::min(Min[i], point[i]);
+		Max[i] = std::max(Max[i], point[i]);
+	}
+}
+
+void Aabb::Extend(const Aabb& other)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		Min[i] = std::min(Min[i], other.Min[i]);
+		Max[i] = std::max(Max[i], other.Max[i]);
+	}
+}
+
+Aabb Aabb::Expanded(float fraction, float minimum) const
+{
+	Aabb box = *this;
+	for (int i = 0; i < 3; i++)
+	{
+		const float margin = std::max((Max[i] - Min[i]) * fraction, minimum);
+		box.Min[i] -= margin;
+		box.Max[i] += margin;
+	}
+	return box;
+}
+
+bool Aabb::Contains(const Aabb& other) const
+{
+	for (int i = 0; i < 3; i++)
+	{
+		if (other.Min[i] < Min[i] || other.Max[i] > Max[i])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Aabb::Intersects(const Aabb& other) const
+{
+	for (int i = 0; i < 3; i++)
+	{
+		if (other.Min[i] > Max[i] || other.Max[i] < Min[i])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+float Aabb::GetSurfaceArea() const
+{
+	const float x = Max.x - Min.x;
+	const float y = Max.y - Min.y;
+	const float z = Max.z - Min.z;
+	return 2.f * (x * y + y * z + z * x);
+}
+
+Aabb Aabb::Transformed(const glm::mat4& transform) const
+{
+	if (IsEmpty() || IsInfinite())
+	{
+		return *this;
+	}
+
+	// Arvo: every output axis is the translation plus the min/max of each input axis' contribution
+	Aabb box;
+	for (int row = 0; row < 3; row++)
+	{
+		box.Min[row] = box.Max[row] = transform[3][row];
+		for (int column = 0; column < 3; column++)
+		{
+			const float a = transform[column][row] * Min[column];
+			const float b = transform[column][row] * Max[column];
+			box.Min[row] += std::min(a, b);
+			box.Max[row] += std::max(a, b);
+		}
+	}
+	return box;
+}
+
+bool Aabb::operator==(const Aabb& other) const
+{
+	for (int i = 0; i < 3; i++)
+	{
+		if (Min[i] != other.Min[i] || Max[i] != other.Max[i])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+Aabb Merge(const Aabb& a, const Aabb& b)
+{
+	Aabb box = a;
+	box.Extend(b);
+	return box;
+}
+
+Aabb ComputeBounds(const void* vertices, uint32_t vertexCount, const Gl::BufferLayout& layout)
+{
+	const auto& elements = layout.GetElements();
+	if (elements.empty())
+	{
+		return Aabb::Infinite();
+	}
+
+	const auto it = std::find_if(elements.begin(), elements.end(), [](const auto& e) { return e.Name == "position"; });
+	const auto& position = it != elements.end() ? *it : elements.front();
+
+	const auto* bytes = static_cast<const uint8_t*>(vertices);
+	const uint32_t stride = layout.GetStride();
+	Aabb box;
+
+	switch (position.Type)
+	{
+	case Gl::ShaderDataType::Float2:
+	case Gl::ShaderDataType::Float3:
+	case Gl::ShaderDataType::Float4:
+	{
+		const uint32_t components = std::min<uint32_t>(3, position.GetComponentCount());
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			float values[3]{ 0.f, 0.f, 0.f };
+			std::memcpy(values, bytes + static_cast<size_t>(v) * stride + position.Offset, components * sizeof(float));
+			box.Extend(glm::vec3(values[0], values[1], values[2]));
+		}
+		break;
+	}
+	case Gl::ShaderDataType::Half2:
+	case Gl::ShaderDataType::Half4:
+	{
+		const uint32_t components = std::min<uint32_t>(3, position.GetComponentCount());
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			uint16_t halves[3]{ 0, 0, 0 };
+			std::memcpy(halves, bytes + static_cast<size_t>(v) * stride + position.Offset, components * sizeof(uint16_t));
+			box.Extend(glm::vec3(DecodeHalf(halves[0]), DecodeHalf(halves[1]), DecodeHalf(halves[2])));
+		}
+		break;
+	}
+	default:
+		return Aabb::Infinite();
+	}
+
+	return box;
+}
+
+Frustum Frustum::FromMatrix(const glm::mat4& m)
+{
+	// Rows of the matrix, glm is column major
+	glm::vec4 rows[4];
+	for (int row = 0; row < 4; row++)
+	{
+		rows[row] = glm::vec4(m[0][row], m[1][row], m[2][row], m[3][row]);
+	}
+
+	Frustum frustum;
+	frustum.Planes[0] = rows[3] + rows[0];
+	frustum.Planes[1] = rows[3] - rows[0];
+	frustum.Planes[2] = rows[3] + rows[1];
+	frustum.Planes[3] = rows[3] - rows[1];
+	frustum.Planes[4] = rows[3] + rows[2];
+	frustum.Planes[5] = rows[3] - rows[2];
+	return frustum;
+}
+
+Frustum Frustum::FromRect(const glm::vec2& min, const glm::vec2& max)
+{
+	Frustum frustum;
+	frustum.Planes[0] = glm::vec4(1.f, 0.f, 0.f, -min.x);
+	frustum.Planes[1] = glm::vec4(-1.f, 0.f, 0.f, max.x);
+	frustum.Planes[2] = glm::vec4(0.f, 1.f, 0.f, -min.y);
+	frustum.Planes[3] = glm::vec4(0.f, -1.f, 0.f, max.y);
+	// Always satisfied
+	frustum.Planes[4] = glm::vec4(0.f, 0.f, 0.f, 1.f);
+	frustum.Planes[5] = glm::vec4(0.f, 0.f, 0.f, 1.f);
+	return frustum;
+}
+
+Containment Frustum::Classify(const Aabb& box) const
+{
+	if (box.IsInfinite())
+	{
+		return Containment::Intersects;
+	}
+
+	Containment result = Containment::Inside;
+	for (const auto& plane : Planes)
+	{
+		// The corners furthest along and against the plane normal
+		float farthest = plane.w;
+		float nearest = plane.w;
+		for (int i = 0; i < 3; i++)
+		{
+			const float a = plane[i] * box.Min[i];
+			const float b = plane[i] * box.Max[i];
+			farthest += std::max(a, b);
+			nearest += std::min(a, b);
+		}
+
+		if (farthest < 0.f)
+		{
+			return Containment::Outside;
+		}
+		if (nearest < 0.f)
+		{
+			result = Containment::Intersects;
+		}
+	}
+	return result;
+}
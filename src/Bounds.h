@@ -0,0 +1,61 @@
+#pragma once
+
+#include <limits>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "Buffer.h"
+
+// Axis aligned bounding box, empty (Min > Max) when default constructed
+struct Aabb
+{
+	glm::vec3 Min{ std::numeric_limits<float>::max() };
+	glm::vec3 Max{ -std::numeric_limits<float>::max() };
+
+	static Aabb Infinite();
+
+	bool IsEmpty() const { return Min.x > Max.x || Min.y > Max.y || Min.z > Max.z; }
+	bool IsInfinite() const;
+
+	void Extend(const glm::vec3& point);
+	void Extend(const Aabb& other);
+	// Grows every side by fraction of the box's size (at least minimum)
+	Aabb Expanded(float fraction, float minimum) const;
+
+	bool Contains(const Aabb& other) const;
+	bool Intersects(const Aabb& other) const;
+	float GetSurfaceArea() const;
+
+	// Box around the transformed box
+	Aabb Transformed(const glm::mat4& transform) const;
+
+	bool operator==(const Aabb& other) const;
+	bool operator!=(const Aabb& other) const { return !(*this == other); }
+};
+
+Aabb Merge(const Aabb& a, const Aabb& b);
+
+// Bounds of the "position" element (the first element if none is named so) of interleaved vertices
+// Float2/3/4 and Half2/4 positions are read, other types give an infinite box that's never culled
+Aabb ComputeBounds(const void* vertices, uint32_t vertexCount, const Gl::BufferLayout& layout);
+
+enum class Containment
+{
+	Outside,
+	Intersects,
+	Inside
+};
+
+// Inward facing planes, a point p is inside when dot(plane.xyz, p) + plane.w >= 0 for all of them
+struct Frustum
+{
+	glm::vec4 Planes[6];
+
+	// Planes of GL clip space (-w <= x, y, z <= w) pulled back through the matrix
+	static Frustum FromMatrix(const glm::mat4& viewProjection);
+	// 2D view rectangle, unbounded in z
+	static Frustum FromRect(const glm::vec2& min, const glm::vec2& max);
+
+	Containment Classify(const Aabb& box) const;
+};
@@ -23,7 +23,20 @@ namespace Gl
 		Float4,
 		Mat3,
 		Mat4,
-		Bool
+		Bool,
+		// Compact formats, see VertexEncoding.h for the CPU side encoders
+		// The integer ones reach the shader as floats when the element is normalized, as ints/uints otherwise
+		Half2,
+		Half4,
+		Byte4,
+		UByte4,
+		Short2,
+		Short4,
+		UShort2,
+		UShort4,
+		// Always floats, normalized or converted as they are
+		Int2_10_10_10,
+		UInt2_10_10_10
 	};
 
 	static uint32_t ShaderDataTypeSize(ShaderDataType type)
@@ -41,6 +54,16 @@ namespace Gl
 			4 * 3 * 3,	//	Mat3, 3 * float3
 			4 * 4 * 4,	//	Mat4, 4 * float4
 			1,			//	Bool
+			2 * 2,		//	Half2
+			2 * 4,		//	Half4
+			4,			//	Byte4
+			4,			//	UByte4
+			2 * 2,		//	Short2
+			2 * 4,		//	Short4
+			2 * 2,		//	UShort2
+			2 * 4,		//	UShort4
+			4,			//	Int2_10_10_10
+			4,			//	UInt2_10_10_10
 		};
 
 		if (type == ShaderDataType::None)
@@ -59,11 +82,13 @@ namespace Gl
 		uint32_t Size;
 		size_t Offset;
 		bool Normalized;
+		// 0 advances per vertex, N advances once every N instances
+		uint32_t Divisor;
 
 		BufferElement() = default;
 
-		BufferElement(ShaderDataType type, const std::string& name, bool normalized = false)
-			: Name(name), Type(type), Size(ShaderDataTypeSize(type)), Offset(0), Normalized(normalized)
+		BufferElement(ShaderDataType type, const std::string& name, bool normalized = false, uint32_t divisor = 0)
+			: Name(name), Type(type), Size(ShaderDataTypeSize(type)), Offset(0), Normalized(normalized), Divisor(divisor)
 		{
 		}
 
@@ -82,6 +107,16 @@ namespace Gl
 				3, //	Mat3, 3 * float3
 				4, //	Mat4, 4 * float4
 				1, //	Bool
+				2, //	Half2
+				4, //	Half4
+				4, //	Byte4
+				4, //	UByte4
+				2, //	Short2
+				4, //	Short4
+				2, //	UShort2
+				4, //	UShort4
+				4, //	Int2_10_10_10
+				4, //	UInt2_10_10_10
 			};
 
 			if (Type == ShaderDataType::None)
@@ -92,6 +127,28 @@ namespace Gl
 
 			return componentCount[static_cast<int>(Type)];
 		}
+
+		// Integer attributes go through glVertexAttribIPointer and are read as ivec/uvec in the shader
+		bool IsInteger() const
+		{
+			switch (Type)
+			{
+			case ShaderDataType::Int:
+			case ShaderDataType::Int2:
+			case ShaderDataType::Int3:
+			case ShaderDataType::Int4:
+				return true;
+			case ShaderDataType::Byte4:
+			case ShaderDataType::UByte4:
+			case ShaderDataType::Short2:
+			case ShaderDataType::Short4:
+			case ShaderDataType::UShort2:
+			case ShaderDataType::UShort4:
+				return !Normalized;
+			default:
+				return false;
+			}
+		}
 	};
 
 	class BufferLayout
@@ -105,6 +162,23 @@ namespace Gl
 			CalculateOffsetsAndStride();
 		}
 
+		BufferLayout(const std::vector<BufferElement>& elements)
+			: m_Elements(elements)
+		{
+			CalculateOffsetsAndStride();
+		}
+
+		// Sets the same divisor on every element, for buffers that hold only per instance data
+		BufferLayout(const std::initializer_list<BufferElement>& elements, uint32_t divisor)
+			: m_Elements(elements)
+		{
+			for (auto& el : m_Elements)
+			{
+				el.Divisor = divisor;
+			}
+			CalculateOffsetsAndStride();
+		}
+
 		uint32_t GetStride() const { return m_Stride; }
 		const auto& GetElements() const { return m_Elements; }
 		uint32_t GetLength() const
@@ -0,0 +1,39 @@
+#include "Capabilities.h"
+
+#include <string>
+#include <unordered_set>
+
+namespace Gl
+{
+	bool HasExtension(const char* name)
+	{
+		static const auto extensions = []()
+		{
+			std::unordered_set<std::string> set;
+
+			GLint count = 0;
+			glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+			for (GLint i = 0; i < count; i++)
+			{
+				set.emplace(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i)));
+			}
+
+			return set;
+		}();
+
+		return extensions.count(name) > 0;
+	}
+
+	bool HasVersion(int major, int minor)
+	{
+		static const auto version = []()
+		{
+			GLint major = 0, minor = 0;
+			glGetIntegerv(GL_MAJOR_VERSION, &major);
+			glGetIntegerv(GL_MINOR_VERSION, &minor);
+			return major * 10 + minor;
+		}();
+
+		return version >= major * 10 + minor;
+	}
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// Queries about the current context, results are cached on first use so a context has to be current
+
+namespace Gl
+{
+	bool HasExtension(const char* name);
+	bool HasVersion(int major, int minor);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+// Byte ranges of a CPU side buffer that changed since the last upload
+// Ranges closer than the coalesce gap are merged, one bigger upload is cheaper than many small ones
+
+struct ByteRange
+{
+	size_t Begin;
+	size_t End;
+};
+
+class DirtyRanges
+{
+public:
+	static constexpr size_t DefaultCoalesceGap = 256;
+
+	void Add(size_t begin, size_t end)
+	{
+		if (begin >= end)
+		{
+			return;
+		}
+
+		// Appends and sequential writes extend the last range
+		if (!m_Ranges.empty())
+		{
+			auto& last = m_Ranges.back();
+			if (begin >= last.Begin && begin <= last.End + DefaultCoalesceGap)
+			{
+				last.End = std::max(last.End, end);
+				return;
+			}
+		}
+
+		m_Ranges.push_back({ begin, end });
+	}
+
+	// Sorted, merged ranges clamped to size
+	const std::vector<ByteRange>& Coalesce(size_t size, size_t gap = DefaultCoalesceGap)
+	{
+		std::sort(m_Ranges.begin(), m_Ranges.end(), [](const ByteRange& a, const ByteRange& b) { return a.Begin < b.Begin; });
+
+		size_t count = 0;
+		for (const auto& range : m_Ranges)
+		{
+			const ByteRange clamped{ range.Begin, std::min(range.End, size) };
+			if (clamped.Begin >= clamped.End)
+			{
+				continue;
+			}
+
+			if (count > 0 && clamped.Begin <= m_Ranges[count - 1].End + gap)
+			{
+				m_Ranges[count - 1].End = std::max(m_Ranges[count - 1].End, clamped.End);
+			}
+			else
+			{
+				m_Ranges[count++] = clamped;
+			}
+		}
+		m_Ranges.resize(count);
+
+		return m_Ranges;
+	}
+
+	void Clear() { m_Ranges.clear(); }
+	bool Empty() const { return m_Ranges.empty(); }
+private:
+	std::vector<ByteRange> m_Ranges;
+};
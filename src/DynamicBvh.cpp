@@ -0,0 +1,234 @@
+#include "DynamicBvh.h"
+
+#include <cassert>
+#include <algorithm>
+
+DynamicBvh::DynamicBvh(float fraction, float minimum)
+	:
+	m_Fraction(fraction),
+	m_Minimum(minimum)
+{
+}
+
+int32_t DynamicBvh::AllocateNode()
+{
+	if (m_FreeList == Null)
+	{
+		m_Nodes.emplace_back();
+		return static_cast<int32_t>(m_Nodes.size() - 1);
+	}
+
+	const int32_t index = m_FreeList;
+	m_FreeList = m_Nodes[index].Parent;
+	m_Nodes[index] = Node();
+	return index;
+}
+
+void DynamicBvh::FreeNode(int32_t index)
+{
+	m_Nodes[index].Parent = m_FreeList;
+	m_Nodes[index].Children[0] = Null;
+	m_FreeList = index;
+}
+
+int32_t DynamicBvh::Insert(const Aabb& box, uint32_t userData)
+{
+	assert(!box.IsEmpty() && !box.IsInfinite());
+
+	const int32_t leaf = AllocateNode();
+	m_Nodes[leaf].Box = box.Expanded(m_Fraction, m_Minimum);
+	m_Nodes[leaf].Inserted = m_Nodes[leaf].Box;
+	m_Nodes[leaf].UserData = userData;
+
+	InsertLeaf(leaf);
+	m_LeafCount++;
+	return leaf;
+}
+
+void DynamicBvh::Remove(int32_t leaf)
+{
+	assert(leaf >= 0 && leaf < static_cast<int32_t>(m_Nodes.size()) && m_Nodes[leaf].IsLeaf());
+
+	RemoveLeaf(leaf);
+	FreeNode(leaf);
+	m_LeafCount--;
+}
+
+bool DynamicBvh::Move(int32_t leaf, const Aabb& box)
+{
+	Node& node = m_Nodes[leaf];
+	if (node.Box.Contains(box))
+	{
+		return false;
+	}
+
+	const Aabb fat = box.Expanded(m_Fraction, m_Minimum);
+
+	// Still overlapping where it was inserted, the subtree it's in is still a fair place for it
+	if (fat.Intersects(node.Inserted))
+	{
+		node.Box = fat;
+		Refit(node.Parent);
+		return true;
+	}
+
+	RemoveLeaf(leaf);
+	m_Nodes[leaf].Box = fat;
+	m_Nodes[leaf].Inserted = fat;
+	InsertLeaf(leaf);
+	return true;
+}
+
+void DynamicBvh::InsertLeaf(int32_t leaf)
+{
+	if (m_Root == Null)
+	{
+		m_Root = leaf;
+		m_Nodes[leaf].Parent = Null;
+		return;
+	}
+
+	// Walk down while splitting a child is cheaper than pairing with the whole node
+	const Aabb leafBox = m_Nodes[leaf].Box;
+	int32_t index = m_Root;
+	while (!m_Nodes[index].IsLeaf())
+	{
+		const Node& node = m_Nodes[index];
+		const float area = node.Box.GetSurfaceArea();
+		const float combinedArea = Merge(node.Box, leafBox).GetSurfaceArea();
+
+		// New parent for this node and the leaf
+		const float cost = 2.f * combinedArea;
+		// Every ancestor below grows by at least this much
+		const float inheritance = 2.f * (combinedArea - area);
+
+		float childCosts[2];
+		for (int i = 0; i < 2; i++)
+		{
+			const Node& child = m_Nodes[node.Children[i]];
+			const float merged = Merge(child.Box, leafBox).GetSurfaceArea();
+			childCosts[i] = (child.IsLeaf() ? merged : merged - child.Box.GetSurfaceArea()) + inheritance;
+		}
+
+		if (cost < childCosts[0] && cost < childCosts[1])
+		{
+			break;
+		}
+		index = node.Children[childCosts[0] <= childCosts[1] ? 0 : 1];
+	}
+
+	const int32_t sibling = index;
+	const int32_t oldParent = m_Nodes[sibling].Parent;
+	const int32_t newParent = AllocateNode();
+
+	m_Nodes[newParent].Parent = oldParent;
+	m_Nodes[newParent].Box = Merge(leafBox, m_Nodes[sibling].Box);
+	m_Nodes[newParent].Children[0] = sibling;
+	m_Nodes[newParent].Children[1] = leaf;
+	m_Nodes[sibling].Parent = newParent;
+	m_Nodes[leaf].Parent = newParent;
+
+	if (oldParent == Null)
+	{
+		m_Root = newParent;
+		return;
+	}
+
+	auto& children = m_Nodes[oldParent].Children;
+	children[children[0] == sibling ? 0 : 1] = newParent;
+	Refit(oldParent);
+}
+
+void DynamicBvh::RemoveLeaf(int32_t leaf)
+{
+	if (leaf == m_Root)
+	{
+		m_Root = Null;
+		return;
+	}
+
+	// The parent goes away, the sibling takes its place
+	const int32_t parent = m_Nodes[leaf].Parent;
+	const int32_t grandParent = m_Nodes[parent].Parent;
+	const auto& parentChildren = m_Nodes[parent].Children;
+	const int32_t sibling = parentChildren[0] == leaf ? parentChildren[1] : parentChildren[0];
+
+	m_Nodes[sibling].Parent = grandParent;
+	FreeNode(parent);
+
+	if (grandParent == Null)
+	{
+		m_Root = sibling;
+		return;
+	}
+
+	auto& children = m_Nodes[grandParent].Children;
+	children[children[0] == parent ? 0 : 1] = sibling;
+	Refit(grandParent);
+}
+
+void DynamicBvh::Refit(int32_t index)
+{
+	while (index != Null)
+	{
+		Node& node = m_Nodes[index];
+		const Aabb box = Merge(m_Nodes[node.Children[0]].Box, m_Nodes[node.Children[1]].Box);
+		if (box == node.Box)
+		{
+			return;
+		}
+
+		node.Box = box;
+		index = node.Parent;
+	}
+}
+
+uint32_t DynamicBvh::GetHeight() const
+{
+	if (m_Root == Null)
+	{
+		return 0;
+	}
+
+	uint32_t height = 0;
+	std::vector<std::pair<int32_t, uint32_t>> stack{ { m_Root, 1 } };
+	while (!stack.empty())
+	{
+		const auto [index, depth] = stack.back();
+		stack.pop_back();
+		height = std::max(height, depth);
+
+		if (!m_Nodes[index].IsLeaf())
+		{
+			stack.push_back({ m_Nodes[index].Children[0], depth + 1 });
+			stack.push_back({ m_Nodes[index].Children[1], depth + 1 });
+		}
+	}
+	return height;
+}
+
+float DynamicBvh::GetAreaRatio() const
+{
+	if (m_Root == Null)
+	{
+		return 0.f;
+	}
+
+	float total = 0.f;
+	std::vector<int32_t> stack{ m_Root };
+	while (!stack.empty())
+	{
+		const int32_t index = stack.back();
+		stack.pop_back();
+
+		if (!m_Nodes[index].IsLeaf())
+		{
+			total += m_Nodes[index].Box.GetSurfaceArea();
+			stack.push_back(m_Nodes[index].Children[0]);
+			stack.push_back(m_Nodes[index].Children[1]);
+		}
+	}
+
+	const float rootArea = m_Nodes[m_Root].Box.GetSurfaceArea();
+	return rootArea > 0.f ? total / rootArea : 0.f;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "Bounds.h"
+
+// Incrementally updated bounding volume hierarchy over boxes (Box2D style dynamic tree)
+// Leaves store a fattened box so small moves don't touch the tree at all. Moves that leave the fat
+// box refit the leaf's ancestors in place; once a leaf has drifted away from where it was inserted
+// it's removed and reinserted, which keeps the tree from degrading under continuous motion.
+// Insertion walks down to the sibling with the lowest surface area cost.
+
+class DynamicBvh
+{
+public:
+	static constexpr int32_t Null = -1;
+
+	// Leaf boxes grow by fraction of their size on every side, at least by minimum
+	DynamicBvh(float fraction = 0.1f, float minimum = 0.f);
+
+	int32_t Insert(const Aabb& box, uint32_t userData);
+	void Remove(int32_t leaf);
+	// Returns true if the tree changed
+	bool Move(int32_t leaf, const Aabb& box);
+
+	// Calls visit(userData) for every leaf whose fat box isn't outside the frustum
+	// Subtrees completely inside are reported without testing them. Returns the nodes tested.
+	template<typename Func>
+	uint32_t Query(const Frustum& frustum, Func&& visit) const
+	{
+		if (m_Root == Null)
+		{
+			return 0;
+		}
+
+		uint32_t tested = 0;
+		m_Stack.clear();
+		m_Stack.push_back({ m_Root, false });
+
+		while (!m_Stack.empty())
+		{
+			const auto [index, inside] = m_Stack.back();
+			m_Stack.pop_back();
+			const Node& node = m_Nodes[index];
+
+			bool nodeInside = inside;
+			if (!inside)
+			{
+				tested++;
+				const Containment containment = frustum.Classify(node.Box);
+				if (containment == Containment::Outside)
+				{
+					continue;
+				}
+				nodeInside = containment == Containment::Inside;
+			}
+
+			if (node.IsLeaf())
+			{
+				visit(node.UserData);
+				continue;
+			}
+
+			m_Stack.push_back({ node.Children[0], nodeInside });
+			m_Stack.push_back({ node.Children[1], nodeInside });
+		}
+
+		return tested;
+	}
+
+	uint32_t GetUserData(int32_t leaf) const { return m_Nodes[leaf].UserData; }
+	const Aabb& GetFatBox(int32_t leaf) const { return m_Nodes[leaf].Box; }
+	uint32_t GetLeafCount() const { return m_LeafCount; }
+	uint32_t GetHeight() const;
+	// Sum of the internal nodes' surface areas over the root's, lower is a better tree
+	float GetAreaRatio() const;
+private:
+	struct Node
+	{
+		Aabb Box;
+		Aabb Inserted; // leaves: fat box at insertion
+		int32_t Parent{ Null }; // next free node while on the free list
+		int32_t Children[2]{ Null, Null };
+		uint32_t UserData{ 0 };
+
+		bool IsLeaf() const { return Children[0] == Null; }
+	};
+
+	struct StackEntry
+	{
+		int32_t Index;
+		bool Inside;
+	};
+
+	int32_t AllocateNode();
+	void FreeNode(int32_t index);
+
+	void InsertLeaf(int32_t leaf);
+	void RemoveLeaf(int32_t leaf);
+	// Recomputes the boxes from index up to the root, stops at the first one that doesn't change
+	void Refit(int32_t index);
+
+	float m_Fraction;
+	float m_Minimum;
+
+	std::vector<Node> m_Nodes;
+	int32_t m_Root{ Null };
+	int32_t m_FreeList{ Null };
+	uint32_t m_LeafCount{ 0 };
+
+	mutable std::vector<StackEntry> m_Stack;
+};
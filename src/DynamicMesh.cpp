@@ -2,6 +2,7 @@
 #include "DynamicMesh.h"
 
 #include <cassert>
+#include <algorithm>
 
 DynamicMesh::DynamicMesh()
 	:
@@ -33,9 +34,11 @@ DynamicMesh::DynamicMesh(const DynamicMesh& o)
 	m_DrawType = o.m_DrawType;
 	m_VertCount = o.m_VertCount;
 	m_ElementCount = o.m_ElementCount;
+	m_Bounds = o.m_Bounds;
 
 	m_VertexBuffers.clear();
 	m_VertexData.clear();
+	m_VertexDirty.clear();
 }
 
 
@@ -44,6 +47,7 @@ uint32_t DynamicMesh::CreateNewVertexBuffer(const Gl::BufferLayout& layout)
 	auto buff = Gl::VertexBuffer::Create(layout);
 
 	m_VertexData.emplace_back();
+	m_VertexDirty.emplace_back();
 
 	m_VertArray->AddVertexBuffer(buff);
 	m_VertexBuffers.push_back(buff);
@@ -61,6 +65,17 @@ void DynamicMesh::AllocateIndexBuffer(size_t size)
 	m_IndexData.reserve(size);
 }
 
+void DynamicMesh::ReserveVertices(uint32_t vertIdx, uint32_t count)
+{
+	assert(vertIdx < m_VertexData.size());
+	m_VertexData[vertIdx].reserve(m_VertexData[vertIdx].size() + count * m_VertexBuffers[vertIdx]->GetLayout().GetStride() / sizeof(float));
+}
+
+void DynamicMesh::ReserveIndices(uint32_t count)
+{
+	m_IndexData.reserve(m_IndexData.size() + count);
+}
+
 void DynamicMesh::SetDrawType(GLint drawType)
 {
 	m_DrawType = drawType;
@@ -68,9 +83,10 @@ void DynamicMesh::SetDrawType(GLint drawType)
 
 void DynamicMesh::AddVertexData(uint32_t vertIdx, std::vector<float>& data)
 {
+	m_VertexDirty[vertIdx].Add(m_VertexData[vertIdx].size() * sizeof(float), (m_VertexData[vertIdx].size() + data.size()) * sizeof(float));
 	m_VertexData[vertIdx].insert(m_VertexData[vertIdx].end(), data.begin(), data.end());
 
-	m_VertCount += data.size() / m_VertexBuffers[vertIdx]->GetLayout().GetLength();
+	m_VertCount += data.size() * sizeof(float) / m_VertexBuffers[vertIdx]->GetLayout().GetStride();
 }
 
 void DynamicMesh::AddVertexData(std::vector<float>& data)
@@ -80,12 +96,110 @@ void DynamicMesh::AddVertexData(std::vector<float>& data)
 
 void DynamicMesh::ConnectVertices(uint32_t idx1, uint32_t idx2, uint32_t idx3)
 {
+	m_IndexDirty.Add(m_IndexData.size() * sizeof(uint32_t), (m_IndexData.size() + 3) * sizeof(uint32_t));
 	m_IndexData.push_back(idx1);
 	m_IndexData.push_back(idx2);
 	m_IndexData.push_back(idx3);
+	m_MaxIndex = std::max({ m_MaxIndex, idx1, idx2, idx3 });
 	m_ElementCount += 3;
 }
 
+void DynamicMesh::AddIndices(uint32_t baseIndex, const uint32_t* indices, uint32_t count)
+{
+	const size_t offset = m_IndexData.size();
+	m_IndexData.resize(offset + count);
+	m_IndexDirty.Add(offset * sizeof(uint32_t), m_IndexData.size() * sizeof(uint32_t));
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		m_IndexData[offset + i] = baseIndex + indices[i];
+		m_MaxIndex = std::max(m_MaxIndex, m_IndexData[offset + i]);
+	}
+	m_ElementCount += count;
+}
+
+void DynamicMesh::SetMeshData(MeshData&& data)
+{
+	assert(m_VertBufferParamCount == 0);
+
+	SetVertexData(0, std::move(data.Vertices));
+
+	m_IndexData = std::move(data.Indices);
+	m_ElementCount = m_IndexData.size();
+	m_MaxIndex = m_IndexData.empty() ? 0 : *std::max_element(m_IndexData.begin(), m_IndexData.end());
+	m_IndexDirty.Clear();
+	m_IndexDirty.Add(0, m_IndexData.size() * sizeof(uint32_t));
+
+	m_DrawType = data.DrawType;
+}
+
+void DynamicMesh::SetVertexData(uint32_t vertIdx, std::vector<float>&& data)
+{
+	assert(vertIdx < m_VertexData.size());
+
+	const uint32_t vertexLength = m_VertexBuffers[vertIdx]->GetLayout().GetStride() / sizeof(float);
+	assert(data.size() % vertexLength == 0);
+
+	m_VertexData[vertIdx] = std::move(data);
+	m_VertexDirty[vertIdx].Clear();
+	m_VertexDirty[vertIdx].Add(0, m_VertexData[vertIdx].size() * sizeof(float));
+
+	if (vertIdx == 0)
+	{
+		m_VertCount = m_VertexData[0].size() / vertexLength;
+	}
+}
+
+WeldReport DynamicMesh::Weld(const std::vector<std::vector<float>>& epsilons)
+{
+	assert(m_VertBufferParamCount == 0);
+
+	std::vector<uint32_t> buffers;
+	std::vector<WeldStream> streams;
+	for (uint32_t i = 0; i < m_VertexBuffers.size(); i++)
+	{
+		const auto& layout = m_VertexBuffers[i]->GetLayout();
+		const auto& elements = layout.GetElements();
+		if (std::any_of(elements.begin(), elements.end(), [](const auto& el) { return el.Divisor > 0; }))
+		{
+			continue;
+		}
+
+		const uint32_t vertexLength = layout.GetStride() / sizeof(float);
+		assert(m_VertexData[i].size() == static_cast<size_t>(m_VertCount) * vertexLength);
+
+		buffers.push_back(i);
+		streams.push_back({
+			m_VertexData[i].data(),
+			vertexLength,
+			i < epsilons.size() ? VertexWelder::LayoutEpsilons(layout, epsilons[i]) : std::vector<float>()
+		});
+	}
+
+	const auto report = VertexWelder::Weld(streams, m_VertCount, m_IndexData);
+
+	for (uint32_t i = 0; i < buffers.size(); i++)
+	{
+		auto& data = m_VertexData[buffers[i]];
+		data.resize(static_cast<size_t>(report.WeldedCount) * streams[i].VertexLength);
+		m_VertexDirty[buffers[i]].Clear();
+		m_VertexDirty[buffers[i]].Add(0, data.size() * sizeof(float));
+	}
+
+	m_VertCount = report.WeldedCount;
+	m_ElementCount = m_IndexData.size();
+	m_MaxIndex = report.WeldedCount > 0 ? report.WeldedCount - 1 : 0;
+	m_IndexDirty.Clear();
+	m_IndexDirty.Add(0, m_IndexData.size() * sizeof(uint32_t));
+
+	return report;
+}
+
+void DynamicMesh::EnableStreaming(const std::shared_ptr<Gl::StreamBuffer>& stream)
+{
+	m_Stream = stream;
+}
+
 void DynamicMesh::FlushVertexData(uint32_t vertIdx)
 {
 	assert(m_VertexBuffers.size() > vertIdx);
@@ -94,7 +208,50 @@ void DynamicMesh::FlushVertexData(uint32_t vertIdx)
 	{
 		std::cout << "Flushing a vertex buffer that's empty";
 	}
-	m_VertexBuffers[vertIdx]->SetData(m_VertexData[vertIdx], m_VertexData[vertIdx].size());
+
+	if (vertIdx == 0 && !m_VertexDirty[0].Empty())
+	{
+		m_Bounds = ComputeBounds(m_VertexData[0].data(), m_VertCount, GetLayout(0));
+	}
+
+	if (m_Stream)
+	{
+		const size_t size = m_VertexData[vertIdx].size() * sizeof(float);
+		auto allocation = m_Stream->Allocate(size, sizeof(float));
+
+		if (allocation.IsValid())
+		{
+			std::memcpy(allocation.Data, m_VertexData[vertIdx].data(), size);
+			m_Stream->Commit(allocation);
+			m_VertArray->SetVertexBufferStorage(vertIdx, m_Stream->GetID(), allocation.Offset);
+			m_VertexDirty[vertIdx].Clear();
+			return;
+		}
+
+		std::cerr << "Stream buffer region is full, uploading to the mesh vertex buffer\n";
+		m_VertArray->SetVertexBufferStorage(vertIdx, m_VertexBuffers[vertIdx]->GetID(), 0);
+		// The own buffer wasn't kept up to date while streaming
+		m_VertexDirty[vertIdx].Add(0, m_VertexData[vertIdx].size() * sizeof(float));
+	}
+
+	const auto& data = m_VertexData[vertIdx];
+	const auto& buffer = m_VertexBuffers[vertIdx];
+	auto& dirty = m_VertexDirty[vertIdx];
+	const size_t size = data.size() * sizeof(float);
+	const auto* bytes = reinterpret_cast<const uint8_t*>(data.data());
+
+	if (buffer->EnsureCapacity(size))
+	{
+		buffer->UpdateSubData(bytes, 0, size);
+	}
+	else
+	{
+		for (const auto& range : dirty.Coalesce(size))
+		{
+			buffer->UpdateSubData(bytes + range.Begin, range.Begin, range.End - range.Begin);
+		}
+	}
+	dirty.Clear();
 }
 
 void DynamicMesh::FlushIndexData()
@@ -103,7 +260,58 @@ void DynamicMesh::FlushIndexData()
 	{
 		return; 
 	}
-	m_IdxBuffer->SetData(m_IndexData, m_ElementCount);
+
+	const GLenum type = Gl::IndexBuffer::TypeFor(m_MaxIndex);
+	const uint32_t typeSize = Gl::IndexBuffer::TypeSize(type);
+
+	if (m_Stream)
+	{
+		auto allocation = m_Stream->Allocate(m_ElementCount * typeSize, typeSize);
+
+		if (allocation.IsValid())
+		{
+			Gl::IndexBuffer::WriteIndices(m_IndexData.data(), m_ElementCount, type, allocation.Data);
+			m_Stream->Commit(allocation);
+			m_VertArray->SetElementBuffer(m_Stream->GetID());
+			m_IndexOffset = allocation.Offset;
+			m_IndexType = type;
+			m_IndexChunked = false;
+			m_IndexDirty.Clear();
+			return;
+		}
+
+		std::cerr << "Stream buffer region is full, uploading to the mesh index buffer\n";
+		m_VertArray->SetIndexBuffer(m_IdxBuffer);
+		m_IndexDirty.Add(0, m_ElementCount * sizeof(uint32_t));
+	}
+
+	m_IndexOffset = 0;
+
+	if (m_IndexChunking && type == GL_UNSIGNED_INT && m_DrawType == GL_TRIANGLES)
+	{
+		m_IndexChunked = m_IdxBuffer->SetDataChunked(m_IndexData.data(), m_ElementCount);
+		m_IndexType = m_IdxBuffer->GetType();
+		m_IndexDirty.Clear();
+		return;
+	}
+
+	m_IndexChunked = false;
+	m_IndexType = type;
+
+	if (m_IdxBuffer->EnsureCapacity(m_ElementCount, type))
+	{
+		m_IdxBuffer->UpdateSubData(m_IndexData.data(), 0, m_ElementCount);
+	}
+	else
+	{
+		for (const auto& range : m_IndexDirty.Coalesce(m_ElementCount * sizeof(uint32_t)))
+		{
+			const size_t first = range.Begin / sizeof(uint32_t);
+			const size_t last = (range.End + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+			m_IdxBuffer->UpdateSubData(m_IndexData.data() + first, first, last - first);
+		}
+	}
+	m_IndexDirty.Clear();
 }
 
 void DynamicMesh::Flush()
@@ -116,10 +324,28 @@ void DynamicMesh::Flush()
 	}
 }
 
+const std::vector<Gl::IndexChunk>& DynamicMesh::GetIndexChunks() const
+{
+	static const std::vector<Gl::IndexChunk> none;
+	return m_IndexChunked ? m_IdxBuffer->GetChunks() : none;
+}
+
 void DynamicMesh::DrawIndexed() const
 {
 	m_VertArray->Bind();
-	glDrawElements(m_DrawType, m_ElementCount, GL_UNSIGNED_INT, 0);
+
+	if (m_IndexChunked)
+	{
+		const uint32_t typeSize = Gl::IndexBuffer::TypeSize(m_IndexType);
+		for (const auto& chunk : m_IdxBuffer->GetChunks())
+		{
+			glDrawElementsBaseVertex(m_DrawType, chunk.Count, m_IndexType,
+				reinterpret_cast<const void*>(m_IndexOffset + chunk.First * typeSize), chunk.BaseVertex);
+		}
+		return;
+	}
+
+	glDrawElements(m_DrawType, m_ElementCount, m_IndexType, reinterpret_cast<const void*>(m_IndexOffset));
 }
 
 void DynamicMesh::DrawArrays() const
@@ -135,12 +361,40 @@ void DynamicMesh::DrawArrays(GLint type) const
 	glDrawArrays(type, 0, m_VertCount);
 }
 
+void DynamicMesh::DrawIndexedInstanced(uint32_t instanceCount, uint32_t baseInstance) const
+{
+	m_VertArray->Bind();
+
+	if (m_IndexChunked)
+	{
+		const uint32_t typeSize = Gl::IndexBuffer::TypeSize(m_IndexType);
+		for (const auto& chunk : m_IdxBuffer->GetChunks())
+		{
+			glDrawElementsInstancedBaseVertexBaseInstance(m_DrawType, chunk.Count, m_IndexType,
+				reinterpret_cast<const void*>(m_IndexOffset + chunk.First * typeSize), instanceCount, chunk.BaseVertex, baseInstance);
+		}
+		return;
+	}
+
+	glDrawElementsInstancedBaseInstance(m_DrawType, m_ElementCount, m_IndexType,
+		reinterpret_cast<const void*>(m_IndexOffset), instanceCount, baseInstance);
+}
+
+void DynamicMesh::DrawArraysInstanced(uint32_t instanceCount, uint32_t baseInstance) const
+{
+	m_VertArray->Bind();
+	glDrawArraysInstancedBaseInstance(m_DrawType, 0, m_VertCount, instanceCount, baseInstance);
+}
+
 void DynamicMesh::NewMesh()
 {
 	ClearBuffers();
 	ClearGpuBuffers();
 	m_ElementCount = 0;
 	m_VertCount = 0;
+	m_Bounds = {};
+	m_MaxIndex = 0;
+	m_IndexChunked = false;
 }
 
 void DynamicMesh::ClearBuffers()
@@ -150,6 +404,12 @@ void DynamicMesh::ClearBuffers()
 		vec.clear();
 	}
 	m_IndexData.clear();
+
+	for (auto& dirty : m_VertexDirty)
+	{
+		dirty.Clear();
+	}
+	m_IndexDirty.Clear();
 }
 
 void DynamicMesh::ClearGpuBuffers()
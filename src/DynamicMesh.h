@@ -1,15 +1,25 @@
 #pragma once
 
+#include <cassert>
+#include <cstring>
+#include <type_traits>
+
 #include <glm/glm.hpp>
 
 #include "VertexArray.h"
 #include "VertexBuffer.h"
+#include "StreamBuffer.h"
+#include "DirtyRanges.h"
+#include "MeshData.h"
+#include "VertexWelder.h"
 #include "Vertex.h"
+#include "Bounds.h"
 
 // Will render only triangles
 // The first vertex buffer will always be the positions buffer
 // If not passed a layout, assumed layout is a vec3 float positions
-// Supports only floating point vertices
+// Vertex data is kept as 32 bit words, AddVertex writes floats and compact formats
+// (see VertexEncoding.h) are written as whole vertices with AppendVertices
 // TODO: Test Indexed Draw
 
 class DynamicMesh
@@ -23,21 +33,93 @@ public:
 	void AllocateVertexBuffer(uint32_t vertIdx, size_t size);
 	void AllocateIndexBuffer(size_t size);
 	void SetDrawType(GLint drawType);
+	GLint GetDrawType() const { return m_DrawType; }
+	GLuint GetVertexArrayID() const { return m_VertArray->GetID(); }
+	uint32_t GetVertexCount() const { return m_VertCount; }
+	uint32_t GetElementCount() const { return m_ElementCount; }
+	// Local space bounds of the first vertex buffer, recomputed when it's flushed with changes
+	const Aabb& GetBounds() const { return m_Bounds; }
+	// Narrowest type that fits the largest index, as of the last flush
+	GLenum GetIndexType() const { return m_IndexType; }
+	// Non empty when the indices were split into 16 bit chunks on the last flush
+	const std::vector<Gl::IndexChunk>& GetIndexChunks() const;
+	// Triangle lists with more than 65536 vertices get 16 bit indices split into base vertex chunks
+	// instead of 32 bit indices, uploads of chunked indices always replace the whole buffer
+	void SetIndexChunking(bool enable) { m_IndexChunking = enable; }
+	// Byte offset of the first index in the element buffer, non zero when streaming
+	size_t GetIndexOffset() const { return m_IndexOffset; }
+	const Gl::BufferLayout& GetLayout(uint32_t vertIdx = 0) const { return m_VertexBuffers[vertIdx]->GetLayout(); }
+	uint32_t GetVertexBufferCount() const { return m_VertexBuffers.size(); }
 	void AddVertexData(uint32_t vertIdx, std::vector<float>& data);
 	void AddVertexData(std::vector<float>& data);
 
 	template<typename T>
-	const std::vector<T>& GetVertexData(uint32_t vertIdx = 0)
+	const std::vector<T>& GetVertexData(uint32_t vertIdx = 0) const
 	{
 		assert(vertIdx < m_VertexData.size());
 		return m_VertexData[vertIdx];
 	}
 
-	const std::vector<uint32_t>& GetIndexData()
+	const std::vector<uint32_t>& GetIndexData() const
 	{
 		return m_IndexData;
 	}
 
+	// Grows the vertex buffer once by count vertices, V has to match the buffer layout
+	// Vertices added to the first buffer count towards the drawn vertices
+	template<typename V>
+	VertexWriter<V> AppendVertices(uint32_t vertIdx, uint32_t count)
+	{
+		static_assert(std::is_trivially_copyable_v<V> && sizeof(V) % sizeof(float) == 0);
+		assert(vertIdx < m_VertexData.size());
+		assert(sizeof(V) == m_VertexBuffers[vertIdx]->GetLayout().GetStride());
+		// Can't start in the middle of a vertex written with AddVertex
+		assert(m_VertBufferParamCount == 0);
+
+		auto& data = m_VertexData[vertIdx];
+		const size_t offset = data.size();
+		data.resize(offset + count * VertexWriter<V>::VertexLength);
+		m_VertexDirty[vertIdx].Add(offset * sizeof(float), data.size() * sizeof(float));
+
+		if (vertIdx == 0)
+		{
+			m_VertCount += count;
+		}
+
+		return VertexWriter<V>(data.data() + offset, count, offset / VertexWriter<V>::VertexLength);
+	}
+
+	// Copies whole vertices, returns the index of the first one
+	template<typename V>
+	uint32_t AddVertices(uint32_t vertIdx, const V* verts, uint32_t count)
+	{
+		auto writer = AppendVertices<V>(vertIdx, count);
+		writer.Set(0, verts, count);
+		return writer.GetBaseIndex();
+	}
+
+	template<typename V>
+	uint32_t AddVertices(const V* verts, uint32_t count)
+	{
+		return AddVertices<V>(0, verts, count);
+	}
+
+	// Replaces the first vertex buffer, the indices and the draw type with geometry built off the render thread
+	// The data is moved in and uploaded on the next flush
+	void SetMeshData(MeshData&& data);
+	// Replaces the data of any vertex buffer, e.g. per instance data built with MeshData::AppendVertices
+	void SetVertexData(uint32_t vertIdx, std::vector<float>&& data);
+
+	// Merges duplicated vertices across all per vertex buffers (per instance buffers are left alone) and
+	// rewrites the indices, a mesh drawn with DrawArrays gets indices and has to be drawn with DrawIndexed
+	// epsilons has one entry per vertex buffer with one epsilon per layout element, see VertexWelder
+	WeldReport Weld(const std::vector<std::vector<float>>& epsilons = {});
+
+	void ReserveVertices(uint32_t vertIdx, uint32_t count);
+	void ReserveIndices(uint32_t count);
+	// Adds baseIndex to every index, used with the base index of AppendVertices
+	void AddIndices(uint32_t baseIndex, const uint32_t* indices, uint32_t count);
+
 	template<typename T>
 	uint32_t AddVertex(uint32_t idx, const T& vert)
 	{
@@ -45,6 +127,8 @@ public:
 		static constexpr int VertSize = GetVertexSize<T>();
 		assert(idx < m_VertexData.size());
 
+		m_VertexDirty[idx].Add(m_VertexData[idx].size() * sizeof(float), (m_VertexData[idx].size() + VertSize) * sizeof(float));
+
 		if constexpr (VertSize == 1)
 		{
 			m_VertexData[idx].push_back(vert);
@@ -90,6 +174,9 @@ public:
 		constexpr int VertSize = GetVertexSize<T>();
 		assert(vertBufferIdx < m_VertexData.size());
 
+		// Only the changed floats get uploaded on the next flush
+		m_VertexDirty[vertBufferIdx].Add(vertIdx * sizeof(float), (vertIdx + VertSize) * sizeof(float));
+
 		if constexpr (VertSize == 1)
 		{
 			m_VertexData[vertBufferIdx][vertIdx] = vert;
@@ -154,8 +241,15 @@ public:
 	{
 		return GetVertex<glm::vec3>(vertBufferIdx, vertIdx);
 	}
+	// Flushes write into the stream buffer instead of the mesh's own buffers, for meshes rebuilt every frame
+	// The data lives only for the stream buffer frame it was flushed in, so flush every frame between
+	// StreamBuffer::BeginFrame and EndFrame. Falls back to the own buffers when the stream region is full.
+	void EnableStreaming(const std::shared_ptr<Gl::StreamBuffer>& stream);
+	bool IsStreaming() const { return m_Stream != nullptr; }
+
 	void ClearGpuBuffers();
 	void ConnectVertices(uint32_t idx1, uint32_t idx2, uint32_t idx3);
+	// Uploads only the changed ranges, the GPU buffers grow geometrically
 	void FlushVertexData(uint32_t vertIdx = 0);
 	void FlushIndexData();
 	void Flush();
@@ -163,6 +257,10 @@ public:
 	void DrawIndexed() const;
 	void DrawArrays() const;
 	void DrawArrays(GLint type) const;
+	// Per instance data goes in a vertex buffer whose layout elements have a divisor,
+	// fill it with AppendVertices. baseInstance offsets only the attributes with a divisor
+	void DrawIndexedInstanced(uint32_t instanceCount, uint32_t baseInstance = 0) const;
+	void DrawArraysInstanced(uint32_t instanceCount, uint32_t baseInstance = 0) const;
 	void NewMesh();
 	void ClearBuffers();
 private:
@@ -172,6 +270,7 @@ private:
 	GLint m_DrawType{ GL_TRIANGLES };
 	uint32_t m_VertCount{ 0 };
 	uint32_t m_ElementCount{ 0 }; // Store element count in case we destroy the buffer data
+	Aabb m_Bounds;
 
 	std::vector<std::shared_ptr<Gl::VertexBuffer>> m_VertexBuffers;
 	std::shared_ptr<Gl::IndexBuffer> m_IdxBuffer;
@@ -179,4 +278,16 @@ private:
 
 	std::vector<std::vector<float>> m_VertexData;
 	std::vector<uint32_t> m_IndexData;
+
+	// Byte ranges changed since the last flush, only those are uploaded
+	std::vector<DirtyRanges> m_VertexDirty;
+	DirtyRanges m_IndexDirty;
+
+	std::shared_ptr<Gl::StreamBuffer> m_Stream;
+	size_t m_IndexOffset{ 0 }; // byte offset of the indices in the bound element buffer
+
+	uint32_t m_MaxIndex{ 0 };
+	GLenum m_IndexType{ GL_UNSIGNED_INT };
+	bool m_IndexChunking{ false };
+	bool m_IndexChunked{ false };
 };
\ No newline at end of file
@@ -0,0 +1,159 @@
+#include "FramePipeline.h"
+
+#include <chrono>
+#include <cassert>
+#include <algorithm>
+
+FramePipeline::FramePipeline(float timestep, uint32_t maxSteps)
+	:
+	m_Timestep(timestep),
+	m_MaxSteps(maxSteps)
+{
+	assert(timestep > 0.f && maxSteps > 0);
+	m_Thread = std::thread(&FramePipeline::Run, this);
+}
+
+FramePipeline::~FramePipeline()
+{
+	Finish();
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stop = true;
+	}
+	m_Start.notify_one();
+	m_Thread.join();
+}
+
+void FramePipeline::SetScene(IScene* scene)
+{
+	Finish();
+
+	m_Scene = scene;
+	m_Accumulator = 0.f;
+	m_Alpha = 0.f;
+	m_Updated = false;
+	m_Events.clear();
+}
+
+void FramePipeline::SetPipelined(bool pipelined)
+{
+	Finish();
+	m_Pipelined = pipelined;
+}
+
+void FramePipeline::PostEvent(const Event& e)
+{
+	m_Events.push_back(e);
+}
+
+void FramePipeline::Finish()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_Done.wait(lock, [this]() { return !m_Busy; });
+}
+
+void FramePipeline::Frame(float frameTime)
+{
+	if (!m_Scene)
+	{
+		return;
+	}
+
+	const auto waitStart = std::chrono::steady_clock::now();
+	Finish();
+	const std::chrono::duration<double, std::milli> waitTime = std::chrono::steady_clock::now() - waitStart;
+
+	m_Stats = {};
+	m_Stats.WaitMs = waitTime.count();
+
+	// Neither thread is in the scene until the next update starts
+	for (const auto& e : m_Events)
+	{
+		m_Scene->OnEvent(e);
+	}
+	m_Events.clear();
+
+	if (m_Updated)
+	{
+		m_Scene->Present();
+		m_Alpha = m_PendingAlpha;
+		m_Stats.Steps = m_LastSteps;
+		m_Stats.UpdateMs = m_LastUpdateMs;
+		m_Updated = false;
+	}
+
+	m_Accumulator = std::min(m_Accumulator + frameTime, m_MaxSteps * m_Timestep);
+	const uint32_t steps = static_cast<uint32_t>(m_Accumulator / m_Timestep);
+	m_Accumulator -= steps * m_Timestep;
+
+	if (steps == 0)
+	{
+		// The snapshot stays, the frame only moves further past it
+		m_Alpha = m_Accumulator / m_Timestep;
+	}
+	else if (m_Pipelined)
+	{
+		// The front snapshot stays until the update finishes, its time moves on by the frame
+		m_Alpha = std::min(m_Alpha + frameTime / m_Timestep, 1.f);
+		m_PendingAlpha = m_Accumulator / m_Timestep;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_PendingSteps = steps;
+			m_Busy = true;
+		}
+		m_Start.notify_one();
+	}
+	else
+	{
+		RunUpdate(steps);
+		m_Scene->Present();
+		m_Alpha = m_Accumulator / m_Timestep;
+		m_Stats.Steps = m_LastSteps;
+		m_Stats.UpdateMs = m_LastUpdateMs;
+		m_Updated = false;
+	}
+
+	const auto renderStart = std::chrono::steady_clock::now();
+	m_Scene->Render(m_Alpha);
+	const std::chrono::duration<double, std::milli> renderTime = std::chrono::steady_clock::now() - renderStart;
+	m_Stats.RenderMs = renderTime.count();
+}
+
+void FramePipeline::Run()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	while (true)
+	{
+		m_Start.wait(lock, [this]() { return m_Stop || m_PendingSteps > 0; });
+		if (m_Stop)
+		{
+			return;
+		}
+
+		const uint32_t steps = m_PendingSteps;
+		m_PendingSteps = 0;
+
+		lock.unlock();
+		RunUpdate(steps);
+		lock.lock();
+
+		m_Busy = false;
+		m_Done.notify_all();
+	}
+}
+
+void FramePipeline::RunUpdate(uint32_t steps)
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	for (uint32_t i = 0; i < steps; i++)
+	{
+		m_Scene->Update(m_Timestep);
+	}
+	m_Scene->Snapshot();
+
+	const std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+	m_LastUpdateMs = time.count();
+	m_LastSteps = steps;
+	m_Updated = true;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <condition_variable>
+
+#include "IScene.h"
+
+// Runs a scene's simulation for the next frame on an update thread while the render thread draws
+// the current one, a CPU heavy frame costs about max(update, render) instead of their sum
+// Frame waits for the update started by the previous Frame, presents its snapshot, starts the next
+// update and renders. Updates run at a fixed timestep independent of the frame rate, the time the
+// frame is past the last update goes to Render as alpha. The drawn snapshot is one frame behind.
+// Without pipelining the update runs on the calling thread right before the render.
+
+// Two copies of what the render thread reads, the update thread writes the back one
+template<typename T>
+class DoubleBuffered
+{
+public:
+	T& GetBack() { return m_Buffers[m_Front ^ 1]; }
+	const T& GetFront() const { return m_Buffers[m_Front]; }
+	void Swap() { m_Front ^= 1; }
+private:
+	std::array<T, 2> m_Buffers{};
+	uint32_t m_Front{ 0 };
+};
+
+struct FramePipelineStats
+{
+	// Of the last frame
+	uint32_t Steps{ 0 };
+	double UpdateMs{ 0.0 };
+	double RenderMs{ 0.0 };
+	// Render thread waiting for the update to finish
+	double WaitMs{ 0.0 };
+};
+
+class FramePipeline
+{
+public:
+	// At most maxSteps updates per frame, time beyond that is dropped
+	FramePipeline(float timestep = 1.f / 60.f, uint32_t maxSteps = 5);
+	~FramePipeline();
+
+	FramePipeline(const FramePipeline&) = delete;
+	FramePipeline& operator=(const FramePipeline&) = delete;
+
+	// Finishes the update in flight first, the scene has to outlive the pipeline or be replaced
+	void SetScene(IScene* scene);
+	void SetPipelined(bool pipelined);
+	bool IsPipelined() const { return m_Pipelined; }
+
+	// Delivered at the start of the next frame
+	void PostEvent(const Event& e);
+
+	// Render thread, frameTime in seconds since the last frame
+	void Frame(float frameTime);
+	// Waits for the update in flight
+	void Finish();
+
+	float GetTimestep() const { return m_Timestep; }
+	const FramePipelineStats& GetStats() const { return m_Stats; }
+private:
+	void Run();
+	void RunUpdate(uint32_t steps);
+
+	IScene* m_Scene{ nullptr };
+	float m_Timestep;
+	uint32_t m_MaxSteps;
+	bool m_Pipelined{ true };
+
+	float m_Accumulator{ 0.f };
+	float m_Alpha{ 0.f };
+	float m_PendingAlpha{ 0.f };
+
+	std::vector<Event> m_Events;
+
+	std::thread m_Thread;
+	std::mutex m_Mutex;
+	std::condition_variable m_Start;
+	std::condition_variable m_Done;
+	uint32_t m_PendingSteps{ 0 };
+	bool m_Busy{ false };
+	bool m_Stop{ false };
+
+	// Written by the update, read after Finish
+	bool m_Updated{ false };
+	uint32_t m_LastSteps{ 0 };
+	double m_LastUpdateMs{ 0.0 };
+
+	FramePipelineStats m_Stats;
+};
@@ -0,0 +1,43 @@
+#include "Framebuffer.h"
+
+namespace Gl
+{
+	Framebuffer::Framebuffer(uint32_t width, uint32_t height)
+		:
+		m_Width(width),
+		m_Height(height)
+	{
+		glCreateRenderbuffers(1, &m_ColorAttachment);
+		glNamedRenderbufferStorage(m_ColorAttachment, GL_RGBA8, width, height);
+
+		glCreateFramebuffers(1, &m_ID);
+		glNamedFramebufferRenderbuffer(m_ID, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_ColorAttachment);
+	}
+
+	Framebuffer::~Framebuffer()
+	{
+		glDeleteFramebuffers(1, &m_ID);
+		glDeleteRenderbuffers(1, &m_ColorAttachment);
+	}
+
+	std::shared_ptr<Framebuffer> Framebuffer::Create(uint32_t width, uint32_t height)
+	{
+		return std::make_shared<Framebuffer>(width, height);
+	}
+
+	bool Framebuffer::IsComplete() const
+	{
+		return glCheckNamedFramebufferStatus(m_ID, GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	}
+
+	void Framebuffer::Bind() const
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, m_ID);
+		glViewport(0, 0, m_Width, m_Height);
+	}
+
+	void Framebuffer::Unbind() const
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <memory>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+namespace Gl
+{
+	// Single RGBA8 color attachment, used as the render target when there is no window
+	class Framebuffer
+	{
+	public:
+		Framebuffer(uint32_t width, uint32_t height);
+		~Framebuffer();
+
+		static std::shared_ptr<Framebuffer> Create(uint32_t width, uint32_t height);
+
+		bool IsComplete() const;
+
+		uint32_t GetWidth() const { return m_Width; }
+		uint32_t GetHeight() const { return m_Height; }
+
+		void Bind() const;
+		void Unbind() const;
+	private:
+		uint32_t m_Width;
+		uint32_t m_Height;
+		GLuint m_ID;
+		GLuint m_ColorAttachment;
+	};
+}
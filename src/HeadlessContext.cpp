@@ -0,0 +1,104 @@
+#include "HeadlessContext.h"
+
+#include <iostream>
+
+#include <EGL/eglext.h>
+#include <glad/glad.h>
+
+HeadlessContext::~HeadlessContext()
+{
+	Destroy();
+}
+
+bool HeadlessContext::Create(int major, int minor)
+{
+	auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+	if (getPlatformDisplay)
+	{
+		m_Display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	}
+	if (m_Display == EGL_NO_DISPLAY)
+	{
+		m_Display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	EGLint eglMajor, eglMinor;
+	if (m_Display == EGL_NO_DISPLAY || !eglInitialize(m_Display, &eglMajor, &eglMinor))
+	{
+		std::cerr << "Failed to initialize an EGL display\n";
+		return false;
+	}
+
+	if (!eglBindAPI(EGL_OPENGL_API))
+	{
+		std::cerr << "EGL implementation does not support desktop OpenGL\n";
+		Destroy();
+		return false;
+	}
+
+	static constexpr EGLint configAttribs[] = {
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+
+	EGLConfig config;
+	EGLint configCount = 0;
+	if (!eglChooseConfig(m_Display, configAttribs, &config, 1, &configCount) || configCount == 0)
+	{
+		std::cerr << "No EGL config with OpenGL support\n";
+		Destroy();
+		return false;
+	}
+
+	const EGLint contextAttribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION_KHR, major,
+		EGL_CONTEXT_MINOR_VERSION_KHR, minor,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+		EGL_NONE
+	};
+
+	m_Context = eglCreateContext(m_Display, config, EGL_NO_CONTEXT, contextAttribs);
+	if (m_Context == EGL_NO_CONTEXT)
+	{
+		std::cerr << "Failed to create an OpenGL " << major << "." << minor << " core context\n";
+		Destroy();
+		return false;
+	}
+
+	// No surface, everything is drawn into framebuffer objects
+	if (!eglMakeCurrent(m_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, m_Context))
+	{
+		std::cerr << "Failed to make the surfaceless context current\n";
+		Destroy();
+		return false;
+	}
+
+	if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress)))
+	{
+		std::cerr << "Failed to load OpenGL functions\n";
+		Destroy();
+		return false;
+	}
+
+	return true;
+}
+
+void HeadlessContext::Destroy()
+{
+	if (m_Display == EGL_NO_DISPLAY)
+	{
+		return;
+	}
+
+	eglMakeCurrent(m_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+	if (m_Context != EGL_NO_CONTEXT)
+	{
+		eglDestroyContext(m_Display, m_Context);
+		m_Context = EGL_NO_CONTEXT;
+	}
+
+	eglTerminate(m_Display);
+	m_Display = EGL_NO_DISPLAY;
+}
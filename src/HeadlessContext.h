@@ -0,0 +1,25 @@
+#pragma once
+
+#include <EGL/egl.h>
+
+// Window-less OpenGL context on top of EGL
+// Prefers the Mesa surfaceless platform so it works without X/Wayland (llvmpipe on build boxes),
+// falls back to the default display. Rendering has to go into a Gl::Framebuffer.
+
+class HeadlessContext
+{
+public:
+	HeadlessContext() = default;
+	~HeadlessContext();
+
+	HeadlessContext(const HeadlessContext&) = delete;
+	HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+	bool Create(int major, int minor);
+	void Destroy();
+
+	bool IsValid() const { return m_Context != EGL_NO_CONTEXT; }
+private:
+	EGLDisplay m_Display{ EGL_NO_DISPLAY };
+	EGLContext m_Context{ EGL_NO_CONTEXT };
+};
@@ -1,15 +1,33 @@
 #pragma once
 
-#include <iostream>
+#include <string>
+
+#include "Event.h"
+
+// A scene driven by FramePipeline, Update and Snapshot run on the update thread while Render draws
+// the previous snapshot on the render thread (the one with the GL context)
+// Everything Render reads goes through a double buffered snapshot that Snapshot fills and Present
+// swaps, the rest of the scene's state belongs to the update thread. OnEvent and Present are
+// called while neither thread is in the scene.
 
 class IScene
 {
 public:
+	IScene(const std::string& name) : m_Name(name) {}
+	virtual ~IScene() = default;
 
-	void OnEvent(const Event& e) = 0;
-	void Update(float dt) = 0;
-	void Render() = 0;
+	virtual void OnEvent(const Event& e) = 0;
+	// Called at the fixed timestep, possibly several times per frame
+	virtual void Update(float dt) = 0;
+	// After the frame's updates, writes the back snapshot
+	virtual void Snapshot() = 0;
+	// Makes the last written snapshot the one Render reads
+	virtual void Present() = 0;
+	// alpha is how far the frame is past the snapshot's update, in timesteps [0, 1). Scenes draw a
+	// timestep behind, interpolated by alpha from the state before the snapshot's update to it
+	virtual void Render(float alpha) = 0;
 
+	const std::string& GetName() const { return m_Name; }
 private:
 	std::string m_Name;
-}
\ No newline at end of file
+};
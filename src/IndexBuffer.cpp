@@ -1,32 +1,48 @@
 #include "IndexBuffer.h"
 
 #include <assert.h>
+#include <limits>
+#include <algorithm>
+
+#include "StateCache.h"
 
 namespace Gl
 {
+	namespace
+	{
+		template<typename T>
+		void Narrow(const uint32_t* indices, size_t count, uint32_t bias, T* dst)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				assert(indices[i] - bias <= std::numeric_limits<T>::max());
+				dst[i] = static_cast<T>(indices[i] - bias);
+			}
+		}
+	}
+
+	// Uploads go through the DSA functions, binding GL_ELEMENT_ARRAY_BUFFER would change the bound VAO
 	IndexBuffer::IndexBuffer()
 	{
 		glCreateBuffers(1, &m_BufferID);
-		glBindBuffer(GL_ARRAY_BUFFER, m_BufferID);
 	}
 
 	IndexBuffer::IndexBuffer(uint32_t* indices, uint32_t count)
 	{
 		glCreateBuffers(1, &m_BufferID);
-		glBindBuffer(GL_ARRAY_BUFFER, m_BufferID);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(uint32_t), indices, GL_DYNAMIC_DRAW);
+		SetData(indices, count);
 	}
 
 	IndexBuffer::IndexBuffer(std::vector<uint32_t>& indices)
 	{
 		glCreateBuffers(1, &m_BufferID);
-		glBindBuffer(GL_ARRAY_BUFFER, m_BufferID);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), &indices[0], GL_DYNAMIC_DRAW);
+		SetData(indices.data(), indices.size());
 	}
 
 	IndexBuffer::~IndexBuffer()
 	{
 		glDeleteBuffers(1, &m_BufferID);
+		StateCache::OnBufferDeleted(m_BufferID);
 	}
 
 	std::shared_ptr<IndexBuffer> IndexBuffer::Create(uint32_t* indices, uint32_t count)
@@ -39,32 +55,177 @@ namespace Gl
 		return std::make_shared<IndexBuffer>();
 	}
 
-	void IndexBuffer::SetData(uint32_t* indices, uint32_t count) const
+	GLenum IndexBuffer::TypeFor(uint32_t maxIndex)
+	{
+		if (maxIndex <= 0xff)
+		{
+			return GL_UNSIGNED_BYTE;
+		}
+		if (maxIndex <= 0xffff)
+		{
+			return GL_UNSIGNED_SHORT;
+		}
+		return GL_UNSIGNED_INT;
+	}
+
+	uint32_t IndexBuffer::TypeSize(GLenum type)
+	{
+		switch (type)
+		{
+		case GL_UNSIGNED_BYTE: return 1;
+		case GL_UNSIGNED_SHORT: return 2;
+		default: return 4;
+		}
+	}
+
+	void IndexBuffer::WriteIndices(const uint32_t* indices, size_t count, GLenum type, void* dst, uint32_t bias)
+	{
+		switch (type)
+		{
+		case GL_UNSIGNED_BYTE:
+			Narrow(indices, count, bias, static_cast<uint8_t*>(dst));
+			break;
+		case GL_UNSIGNED_SHORT:
+			Narrow(indices, count, bias, static_cast<uint16_t*>(dst));
+			break;
+		default:
+			Narrow(indices, count, bias, static_cast<uint32_t*>(dst));
+			break;
+		}
+	}
+
+	const void* IndexBuffer::Convert(const uint32_t* indices, size_t count, GLenum type, uint32_t bias)
+	{
+		if (type == GL_UNSIGNED_INT && bias == 0)
+		{
+			return indices;
+		}
+
+		m_Staging.resize(count * TypeSize(type));
+		WriteIndices(indices, count, type, m_Staging.data(), bias);
+		return m_Staging.data();
+	}
+
+	void IndexBuffer::SetData(const uint32_t* indices, uint32_t count)
 	{
-		Bind();
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(uint32_t), &indices[0], GL_DYNAMIC_DRAW);
+		const uint32_t maxIndex = count ? *std::max_element(indices, indices + count) : 0;
+
+		m_Type = TypeFor(maxIndex);
+		m_Chunks.clear();
+		glNamedBufferData(m_BufferID, count * TypeSize(m_Type), Convert(indices, count, m_Type), GL_DYNAMIC_DRAW);
+		m_Capacity = count;
+	}
+
+	void IndexBuffer::SetRawData(const void* indices, uint32_t count, GLenum type)
+	{
+		assert(type == GL_UNSIGNED_BYTE || type == GL_UNSIGNED_SHORT || type == GL_UNSIGNED_INT);
+
+		m_Type = type;
+		m_Chunks.clear();
+		glNamedBufferData(m_BufferID, count * TypeSize(m_Type), indices, GL_DYNAMIC_DRAW);
+		m_Capacity = count;
 	}
 
-	void IndexBuffer::SetData(std::vector<uint32_t>& indices, uint32_t count) const
+	void IndexBuffer::SetData(std::vector<uint32_t>& indices, uint32_t count)
 	{
 		//if (indices.size() == 0) return;
 		assert(indices.size());
-		Bind();
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(uint32_t), &indices[0], GL_DYNAMIC_DRAW);
+		SetData(indices.data(), count);
+	}
+
+	bool IndexBuffer::SetDataChunked(const uint32_t* indices, uint32_t count)
+	{
+		assert(count % 3 == 0);
+
+		std::vector<IndexChunk> chunks;
+		uint32_t chunkMin = UINT32_MAX;
+		uint32_t chunkMax = 0;
+		uint32_t chunkFirst = 0;
+
+		for (uint32_t i = 0; i < count; i += 3)
+		{
+			const uint32_t triMin = std::min({ indices[i], indices[i + 1], indices[i + 2] });
+			const uint32_t triMax = std::max({ indices[i], indices[i + 1], indices[i + 2] });
+
+			if (triMax - triMin > 0xffff)
+			{
+				SetData(indices, count);
+				return false;
+			}
+
+			const uint32_t newMin = std::min(chunkMin, triMin);
+			const uint32_t newMax = std::max(chunkMax, triMax);
+			if (i > chunkFirst && newMax - newMin > 0xffff)
+			{
+				chunks.push_back({ chunkFirst, i - chunkFirst, static_cast<int32_t>(chunkMin) });
+				chunkFirst = i;
+				chunkMin = triMin;
+				chunkMax = triMax;
+				continue;
+			}
+
+			chunkMin = newMin;
+			chunkMax = newMax;
+		}
+		if (count > chunkFirst)
+		{
+			chunks.push_back({ chunkFirst, count - chunkFirst, static_cast<int32_t>(chunkMin) });
+		}
+
+		m_Type = GL_UNSIGNED_SHORT;
+		m_Capacity = count;
+		glNamedBufferData(m_BufferID, count * sizeof(uint16_t), nullptr, GL_DYNAMIC_DRAW);
+
+		for (const auto& chunk : chunks)
+		{
+			const void* data = Convert(indices + chunk.First, chunk.Count, GL_UNSIGNED_SHORT, chunk.BaseVertex);
+			glNamedBufferSubData(m_BufferID, chunk.First * sizeof(uint16_t), chunk.Count * sizeof(uint16_t), data);
+		}
+
+		m_Chunks = std::move(chunks);
+		return true;
+	}
+
+	void IndexBuffer::UpdateSubData(const uint32_t* indices, size_t offset, size_t count)
+	{
+		assert(offset + count <= m_Capacity);
+		assert(m_Chunks.empty());
+
+		const uint32_t size = TypeSize(m_Type);
+		glNamedBufferSubData(m_BufferID, offset * size, count * size, Convert(indices, count, m_Type));
+	}
+
+	bool IndexBuffer::EnsureCapacity(size_t count, GLenum type)
+	{
+		// Chunked contents are relative to the chunk base vertices, they can't be updated in place
+		if (count <= m_Capacity && type == m_Type && m_Chunks.empty())
+		{
+			return false;
+		}
+
+		m_Chunks.clear();
+
+		m_Capacity = std::max(count, type == m_Type ? m_Capacity * 2 : 0);
+		m_Type = type;
+		glNamedBufferData(m_BufferID, m_Capacity * TypeSize(m_Type), nullptr, GL_DYNAMIC_DRAW);
+		return true;
 	}
 
 	void IndexBuffer::Bind() const
 	{
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_BufferID);
+		StateCache::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_BufferID);
 	}
 
 	void IndexBuffer::Unbind() const
 	{
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		StateCache::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 	}
 
-	void IndexBuffer::Clear() const
+	// Releases the storage, the buffer object stays valid for new data
+	void IndexBuffer::Clear()
 	{
-		glDeleteBuffers(1, &m_BufferID);
+		glNamedBufferData(m_BufferID, 0, nullptr, GL_DYNAMIC_DRAW);
+		m_Capacity = 0;
+		m_Chunks.clear();
 	}
-}
\ No newline at end of file
+}
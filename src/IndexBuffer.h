@@ -1,12 +1,24 @@
 #pragma once
 
 #include <memory>
+#include <vector>
+#include <cstdint>
 
 #include <glad/glad.h>
 #include "Buffer.h"
 
 namespace Gl
 {
+	// Part of a chunked index buffer, indices are relative to BaseVertex
+	struct IndexChunk
+	{
+		uint32_t First; // in indices
+		uint32_t Count;
+		int32_t BaseVertex;
+	};
+
+	// Indices are always passed as uint32_t and stored as the narrowest type that fits the
+	// largest index (GL_UNSIGNED_BYTE/SHORT/INT), draw with GetType and GetTypeSize
 	class IndexBuffer : public Buffer
 	{
 	public:
@@ -19,21 +31,44 @@ namespace Gl
 		static std::shared_ptr<IndexBuffer> Create(uint32_t* indices, uint32_t count);
 		static std::shared_ptr<IndexBuffer> Create();
 
-		void SetData(uint32_t* indices, uint32_t count) const;
-		void SetData(std::vector<uint32_t>& indices, uint32_t count) const;
+		static GLenum TypeFor(uint32_t maxIndex);
+		static uint32_t TypeSize(GLenum type);
+		// Narrows count indices into dst as type, bias is subtracted from every index
+		static void WriteIndices(const uint32_t* indices, size_t count, GLenum type, void* dst, uint32_t bias = 0);
+
+		void SetData(const uint32_t* indices, uint32_t count);
+		void SetData(std::vector<uint32_t>& indices, uint32_t count);
+		// Indices that are already stored as type, e.g. straight from a mapped mesh file
+		void SetRawData(const void* indices, uint32_t count, GLenum type);
+		// Triangle lists only, splits indices that don't fit 16 bits into chunks that each span
+		// less than 65536 vertices and are drawn with a base vertex. Falls back to SetData and
+		// returns false if a single triangle spans more than that.
+		bool SetDataChunked(const uint32_t* indices, uint32_t count);
+		// offset and count in indices, the range has to fit in the current capacity and type
+		void UpdateSubData(const uint32_t* indices, size_t offset, size_t count);
+		// Grows the storage geometrically or changes the type, returns true if it was reallocated
+		// (previous contents are lost)
+		bool EnsureCapacity(size_t count, GLenum type = GL_UNSIGNED_INT);
+		size_t GetCapacity() const { return m_Capacity; }
+
+		GLenum GetType() const { return m_Type; }
+		uint32_t GetTypeSize() const { return TypeSize(m_Type); }
+		// Empty unless the last upload was chunked
+		const std::vector<IndexChunk>& GetChunks() const { return m_Chunks; }
+
+		unsigned GetID() const { return m_BufferID; }
 
 		void Bind() const override;
 		void Unbind() const override;
-		void Clear() const;
+		void Clear();
 	private:
-		void CreateBuffer()
-		{
-			glCreateBuffers(1, &m_BufferID);
-			// Used GL_ARRAY_BUFFER so i can load data without an active VAO
-			glBindBuffer(GL_ARRAY_BUFFER, m_BufferID);
-		}
+		// Converts into m_Staging unless the indices can be uploaded as they are
+		const void* Convert(const uint32_t* indices, size_t count, GLenum type, uint32_t bias = 0);
 
 		unsigned m_BufferID;
-		uint32_t m_Count;
+		GLenum m_Type{ GL_UNSIGNED_INT };
+		size_t m_Capacity{ 0 }; // in indices
+		std::vector<IndexChunk> m_Chunks;
+		std::vector<uint8_t> m_Staging;
 	};
 }
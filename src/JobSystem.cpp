@@ -0,0 +1,152 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+namespace
+{
+	// Queue of the worker running on this thread, -1 on threads outside the pool
+	thread_local int32_t s_WorkerIndex = -1;
+	thread_local const void* s_WorkerPool = nullptr;
+}
+
+JobSystem::JobSystem(uint32_t workers)
+{
+	if (workers == 0)
+	{
+		const uint32_t hardware = std::thread::hardware_concurrency();
+		workers = hardware > 1 ? hardware - 1 : 1;
+	}
+
+	for (uint32_t i = 0; i < workers; i++)
+	{
+		m_Queues.push_back(std::make_unique<Queue>());
+	}
+
+	for (uint32_t i = 0; i < workers; i++)
+	{
+		m_Threads.emplace_back(&JobSystem::WorkerLoop, this, i);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard lock(m_SleepMutex);
+		m_Stop = true;
+	}
+	m_WakeUp.notify_all();
+
+	for (auto& thread : m_Threads)
+	{
+		thread.join();
+	}
+}
+
+void JobSystem::Run(Job job, JobCounter& counter)
+{
+	counter.m_Pending.fetch_add(1, std::memory_order_relaxed);
+
+	const bool isWorker = s_WorkerPool == this;
+	const uint32_t index = isWorker ? s_WorkerIndex : m_NextQueue.fetch_add(1, std::memory_order_relaxed) % m_Queues.size();
+
+	{
+		// Counted before it's visible so a thief can't take it first and wrap the count,
+		// under the sleep mutex so a worker about to sleep can't miss the notify
+		std::lock_guard lock(m_SleepMutex);
+		m_Queued.fetch_add(1, std::memory_order_release);
+	}
+
+	{
+		std::lock_guard lock(m_Queues[index]->Mutex);
+		m_Queues[index]->Jobs.emplace_back(std::move(job), &counter);
+	}
+	m_WakeUp.notify_one();
+}
+
+bool JobSystem::RunOne(uint32_t index)
+{
+	std::pair<Job, JobCounter*> job;
+	bool found = false;
+
+	{
+		auto& own = *m_Queues[index];
+		std::lock_guard lock(own.Mutex);
+		if (!own.Jobs.empty())
+		{
+			job = std::move(own.Jobs.back());
+			own.Jobs.pop_back();
+			found = true;
+		}
+	}
+
+	for (uint32_t i = 1; !found && i < m_Queues.size(); i++)
+	{
+		auto& victim = *m_Queues[(index + i) % m_Queues.size()];
+		std::lock_guard lock(victim.Mutex);
+		if (!victim.Jobs.empty())
+		{
+			job = std::move(victim.Jobs.front());
+			victim.Jobs.pop_front();
+			found = true;
+		}
+	}
+
+	if (!found)
+	{
+		return false;
+	}
+
+	m_Queued.fetch_sub(1, std::memory_order_relaxed);
+	job.first();
+	job.second->m_Pending.fetch_sub(1, std::memory_order_acq_rel);
+	return true;
+}
+
+void JobSystem::WorkerLoop(uint32_t index)
+{
+	s_WorkerIndex = index;
+	s_WorkerPool = this;
+
+	while (true)
+	{
+		if (RunOne(index))
+		{
+			continue;
+		}
+
+		std::unique_lock lock(m_SleepMutex);
+		m_WakeUp.wait(lock, [this]() { return m_Stop || m_Queued.load(std::memory_order_acquire) > 0; });
+
+		if (m_Stop)
+		{
+			return;
+		}
+	}
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+	const uint32_t index = s_WorkerPool == this ? s_WorkerIndex : 0;
+
+	while (!counter.IsDone())
+	{
+		// Nothing left to steal, the remaining jobs are running on other threads
+		if (!RunOne(index))
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+void JobSystem::ParallelFor(uint32_t count, uint32_t grain, const std::function<void(uint32_t begin, uint32_t end)>& func)
+{
+	grain = std::max(grain, 1u);
+
+	JobCounter counter;
+	for (uint32_t begin = 0; begin < count; begin += grain)
+	{
+		const uint32_t end = std::min(count, begin + grain);
+		Run([&func, begin, end]() { func(begin, end); }, counter);
+	}
+	Wait(counter);
+}
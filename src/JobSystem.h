@@ -0,0 +1,67 @@
+#pragma once
+
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <condition_variable>
+
+// Work stealing thread pool for CPU only work (no GL calls in jobs)
+// Every worker owns a queue, it pushes and pops at the back and idle workers steal from the front
+// of the others. Jobs submitted from outside the pool are spread round robin over the queues.
+// Wait runs queued jobs on the calling thread until the counter drops to zero, so the main thread
+// helps instead of blocking and jobs can wait on jobs they spawned.
+
+class JobCounter
+{
+public:
+	bool IsDone() const { return m_Pending.load(std::memory_order_acquire) == 0; }
+private:
+	friend class JobSystem;
+	std::atomic<uint32_t> m_Pending{ 0 };
+};
+
+class JobSystem
+{
+public:
+	using Job = std::function<void()>;
+
+	// 0 uses one worker per hardware thread minus the caller's
+	JobSystem(uint32_t workers = 0);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	void Run(Job job, JobCounter& counter);
+	void Wait(JobCounter& counter);
+
+	// Splits [0, count) into chunks of at most grain items and blocks until all of them ran
+	void ParallelFor(uint32_t count, uint32_t grain, const std::function<void(uint32_t begin, uint32_t end)>& func);
+
+	uint32_t GetWorkerCount() const { return m_Queues.size(); }
+private:
+	struct Queue
+	{
+		std::mutex Mutex;
+		std::deque<std::pair<Job, JobCounter*>> Jobs;
+	};
+
+	void WorkerLoop(uint32_t index);
+	// Runs one job from the own queue or stolen from another, false if every queue was empty
+	bool RunOne(uint32_t index);
+
+	std::vector<std::unique_ptr<Queue>> m_Queues;
+	std::vector<std::thread> m_Threads;
+	std::atomic<uint32_t> m_NextQueue{ 0 };
+
+	// Queued (not yet started) jobs, workers sleep while it's zero
+	std::atomic<uint32_t> m_Queued{ 0 };
+	std::mutex m_SleepMutex;
+	std::condition_variable m_WakeUp;
+	bool m_Stop{ false };
+};
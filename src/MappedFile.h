@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// Read only memory mapping of a whole file
+// Pages are read from disk the first time they're touched, the mapping is hinted as sequential
+// since its users walk it front to back.
+
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const std::string& path);
+	void Close();
+
+	bool IsOpen() const { return m_Data != nullptr; }
+	const uint8_t* GetData() const { return m_Data; }
+	size_t GetSize() const { return m_Size; }
+private:
+	const uint8_t* m_Data{ nullptr };
+	size_t m_Size{ 0 };
+#ifdef _WIN32
+	void* m_File{ nullptr };
+	void* m_Mapping{ nullptr };
+#endif
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vector>
+#include <cassert>
+#include <cstring>
+#include <cstdint>
+#include <type_traits>
+
+#include <glad/glad.h>
+
+// Writes whole vertices into a float array that was grown up front, see DynamicMesh::AppendVertices
+// Only valid until that array grows again. Disjoint ranges can be written from different threads.
+template<typename V>
+class VertexWriter
+{
+public:
+	static constexpr size_t VertexLength = sizeof(V) / sizeof(float);
+
+	VertexWriter(float* data, uint32_t count, uint32_t baseIndex)
+		: m_Data(data), m_Count(count), m_BaseIndex(baseIndex)
+	{
+	}
+
+	void Set(uint32_t i, const V& vert)
+	{
+		assert(i < m_Count);
+		std::memcpy(m_Data + i * VertexLength, &vert, sizeof(V));
+	}
+
+	void Set(uint32_t first, const V* verts, uint32_t count)
+	{
+		assert(first + count <= m_Count);
+		std::memcpy(m_Data + first * VertexLength, verts, count * sizeof(V));
+	}
+
+	// For kernels that write whole vertices themselves
+	V* GetData() const { return reinterpret_cast<V*>(m_Data); }
+
+	// Index of the first written vertex in the mesh, offset for AddIndices
+	uint32_t GetBaseIndex() const { return m_BaseIndex; }
+	uint32_t GetCount() const { return m_Count; }
+private:
+	float* m_Data;
+	uint32_t m_Count;
+	uint32_t m_BaseIndex;
+};
+
+// Geometry of one vertex buffer and its indices built without touching GL, so it can be
+// generated on any thread and handed to DynamicMesh::SetMeshData on the render thread
+struct MeshData
+{
+	std::vector<float> Vertices;
+	std::vector<uint32_t> Indices;
+	GLint DrawType{ GL_TRIANGLES };
+
+	template<typename V>
+	VertexWriter<V> AppendVertices(uint32_t count)
+	{
+		static_assert(std::is_trivially_copyable_v<V> && sizeof(V) % sizeof(float) == 0);
+
+		const size_t offset = Vertices.size();
+		Vertices.resize(offset + count * VertexWriter<V>::VertexLength);
+
+		return VertexWriter<V>(Vertices.data() + offset, count, offset / VertexWriter<V>::VertexLength);
+	}
+
+	// Adds baseIndex to every index, used with the base index of AppendVertices
+	void AddIndices(uint32_t baseIndex, const uint32_t* indices, uint32_t count)
+	{
+		const size_t offset = Indices.size();
+		Indices.resize(offset + count);
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			Indices[offset + i] = baseIndex + indices[i];
+		}
+	}
+};
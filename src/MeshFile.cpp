@@ -0,0 +1,376 @@
+#include "MeshFile.h"
+
+#include <cstring>
+#include <limits>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+#include "IndexBuffer.h"
+
+namespace
+{
+	constexpr uint32_t MaxNameLength = 51;
+	constexpr uint32_t LastDataType = static_cast<uint32_t>(Gl::ShaderDataType::UInt2_10_10_10);
+
+	struct FileHeader
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		uint32_t DrawType;
+		uint32_t IndexType;
+		uint32_t IndexCount;
+		uint32_t StreamCount;
+		uint64_t IndexOffset;
+		uint64_t IndexSize;
+	};
+
+	struct StreamRecord
+	{
+		uint32_t ElementCount;
+		uint32_t Stride;
+		uint32_t VertexCount;
+		uint32_t Reserved;
+		uint64_t DataOffset;
+		uint64_t DataSize;
+	};
+
+	struct ElementRecord
+	{
+		uint32_t Type;
+		uint32_t Normalized;
+		uint32_t Divisor;
+		char Name[MaxNameLength + 1];
+	};
+
+	uint64_t Align(uint64_t offset)
+	{
+		return (offset + MeshFile::BlobAlignment - 1) / MeshFile::BlobAlignment * MeshFile::BlobAlignment;
+	}
+
+	bool InFile(uint64_t offset, uint64_t size, size_t fileSize)
+	{
+		return offset <= fileSize && size <= fileSize - offset;
+	}
+
+	bool IsDrawType(uint32_t drawType)
+	{
+		switch (drawType)
+		{
+		case GL_POINTS:
+		case GL_LINES:
+		case GL_LINE_STRIP:
+		case GL_LINE_LOOP:
+		case GL_TRIANGLES:
+		case GL_TRIANGLE_STRIP:
+		case GL_TRIANGLE_FAN:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	template<typename T>
+	uint32_t MaxIndex(const uint8_t* data, uint32_t count)
+	{
+		T max = 0;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			T index;
+			std::memcpy(&index, data + static_cast<size_t>(i) * sizeof(T), sizeof(T));
+			max = std::max(max, index);
+		}
+		return max;
+	}
+
+	uint32_t MaxIndex(const uint8_t* data, uint32_t count, GLenum type)
+	{
+		switch (type)
+		{
+		case GL_UNSIGNED_BYTE: return MaxIndex<uint8_t>(data, count);
+		case GL_UNSIGNED_SHORT: return MaxIndex<uint16_t>(data, count);
+		default: return MaxIndex<uint32_t>(data, count);
+		}
+	}
+}
+
+bool MeshFile::Write(const std::string& path, const std::vector<MeshFileStream>& streams, GLint drawType,
+	const void* indices, uint32_t indexCount, GLenum indexType)
+{
+	FileHeader header{ Magic, Version, static_cast<uint32_t>(drawType), indexType, indexCount, static_cast<uint32_t>(streams.size()), 0, 0 };
+
+	std::vector<StreamRecord> records;
+	std::vector<ElementRecord> elements;
+	for (const auto& stream : streams)
+	{
+		const auto& layoutElements = stream.Layout.GetElements();
+		records.push_back({
+			static_cast<uint32_t>(layoutElements.size()),
+			stream.Layout.GetStride(),
+			stream.VertexCount,
+			0, 0,
+			static_cast<uint64_t>(stream.VertexCount) * stream.Layout.GetStride()
+		});
+
+		for (const auto& element : layoutElements)
+		{
+			ElementRecord record{ static_cast<uint32_t>(element.Type), element.Normalized, element.Divisor, {} };
+			std::strncpy(record.Name, element.Name.c_str(), MaxNameLength);
+			elements.push_back(record);
+		}
+	}
+
+	// Blobs follow the records, each one aligned
+	uint64_t offset = sizeof(FileHeader) + records.size() * sizeof(StreamRecord) + elements.size() * sizeof(ElementRecord);
+	for (auto& record : records)
+	{
+		record.DataOffset = Align(offset);
+		offset = record.DataOffset + record.DataSize;
+	}
+	header.IndexOffset = Align(offset);
+	header.IndexSize = static_cast<uint64_t>(indexCount) * Gl::IndexBuffer::TypeSize(indexType);
+
+	std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cerr << "Error opening file " << path << "\n";
+		return false;
+	}
+
+	static const char padding[BlobAlignment]{};
+	const auto pad = [&file](uint64_t to)
+	{
+		file.write(padding, to - static_cast<uint64_t>(file.tellp()));
+	};
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(StreamRecord));
+	file.write(reinterpret_cast<const char*>(elements.data()), elements.size() * sizeof(ElementRecord));
+
+	for (size_t i = 0; i < streams.size(); i++)
+	{
+		pad(records[i].DataOffset);
+		file.write(static_cast<const char*>(streams[i].Data), records[i].DataSize);
+	}
+
+	pad(header.IndexOffset);
+	if (header.IndexSize > 0)
+	{
+		file.write(static_cast<const char*>(indices), header.IndexSize);
+	}
+
+	if (!file)
+	{
+		std::cerr << "Error writing file " << path << "\n";
+		return false;
+	}
+
+	return true;
+}
+
+bool MeshFile::Write(const std::string& path, const MeshData& mesh, const Gl::BufferLayout& layout)
+{
+	const uint32_t vertexCount = mesh.Vertices.size() * sizeof(float) / layout.GetStride();
+	const uint32_t maxIndex = mesh.Indices.empty() ? 0 : *std::max_element(mesh.Indices.begin(), mesh.Indices.end());
+	const GLenum indexType = Gl::IndexBuffer::TypeFor(maxIndex);
+
+	std::vector<uint8_t> indices(mesh.Indices.size() * Gl::IndexBuffer::TypeSize(indexType));
+	Gl::IndexBuffer::WriteIndices(mesh.Indices.data(), mesh.Indices.size(), indexType, indices.data());
+
+	return Write(path, { { layout, mesh.Vertices.data(), vertexCount } }, mesh.DrawType, indices.data(), mesh.Indices.size(), indexType);
+}
+
+bool MeshFile::Write(const std::string& path, const DynamicMesh& mesh)
+{
+	std::vector<MeshFileStream> streams;
+	for (uint32_t i = 0; i < mesh.GetVertexBufferCount(); i++)
+	{
+		const auto& layout = mesh.GetLayout(i);
+		const auto& data = mesh.GetVertexData<float>(i);
+		streams.push_back({ layout, data.data(), static_cast<uint32_t>(data.size() * sizeof(float) / layout.GetStride()) });
+	}
+
+	const auto& indexData = mesh.GetIndexData();
+	const uint32_t maxIndex = indexData.empty() ? 0 : *std::max_element(indexData.begin(), indexData.end());
+	const GLenum indexType = Gl::IndexBuffer::TypeFor(maxIndex);
+
+	std::vector<uint8_t> indices(indexData.size() * Gl::IndexBuffer::TypeSize(indexType));
+	Gl::IndexBuffer::WriteIndices(indexData.data(), indexData.size(), indexType, indices.data());
+
+	return Write(path, streams, mesh.GetDrawType(), indices.data(), indexData.size(), indexType);
+}
+
+bool MeshFile::Write(const std::string& path, const StaticMesh& mesh)
+{
+	const auto& indexBuffer = mesh.GetIndexBuffer();
+	if (!indexBuffer.GetChunks().empty())
+	{
+		std::cerr << "Chunked index buffers can't be written to " << path << "\n";
+		return false;
+	}
+
+	std::vector<std::vector<uint8_t>> vertexData(mesh.GetVertexBufferCount());
+	std::vector<MeshFileStream> streams;
+	for (uint32_t i = 0; i < mesh.GetVertexBufferCount(); i++)
+	{
+		const auto& buffer = mesh.GetVertexBuffer(i);
+		vertexData[i].resize(buffer.GetCapacity());
+		glGetNamedBufferSubData(buffer.GetID(), 0, vertexData[i].size(), vertexData[i].data());
+		streams.push_back({ buffer.GetLayout(), vertexData[i].data(), static_cast<uint32_t>(vertexData[i].size() / buffer.GetLayout().GetStride()) });
+	}
+
+	std::vector<uint8_t> indices(static_cast<size_t>(mesh.GetIndexCount()) * indexBuffer.GetTypeSize());
+	if (!indices.empty())
+	{
+		glGetNamedBufferSubData(indexBuffer.GetID(), 0, indices.size(), indices.data());
+	}
+
+	return Write(path, streams, mesh.GetDrawType(), indices.data(), mesh.GetIndexCount(), indexBuffer.GetType());
+}
+
+std::unique_ptr<MeshFile> MeshFile::Open(const std::string& path)
+{
+	auto mesh = std::make_unique<MeshFile>();
+	if (!mesh->m_File.Open(path))
+	{
+		return nullptr;
+	}
+
+	const uint8_t* data = mesh->m_File.GetData();
+	const size_t size = mesh->m_File.GetSize();
+
+	const auto invalid = [&path](const char* reason)
+	{
+		std::cerr << "Invalid mesh file " << path << ": " << reason << "\n";
+		return nullptr;
+	};
+
+	FileHeader header;
+	if (size < sizeof(header))
+	{
+		return invalid("truncated header");
+	}
+	std::memcpy(&header, data, sizeof(header));
+
+	if (header.Magic != Magic)
+	{
+		return invalid("not a mesh file");
+	}
+	if (header.Version != Version)
+	{
+		return invalid("unsupported version");
+	}
+	if (!IsDrawType(header.DrawType))
+	{
+		return invalid("unknown draw type");
+	}
+	if (header.IndexType != GL_UNSIGNED_BYTE && header.IndexType != GL_UNSIGNED_SHORT && header.IndexType != GL_UNSIGNED_INT)
+	{
+		return invalid("unknown index type");
+	}
+	if (header.IndexSize != static_cast<uint64_t>(header.IndexCount) * Gl::IndexBuffer::TypeSize(header.IndexType)
+		|| !InFile(header.IndexOffset, header.IndexSize, size))
+	{
+		return invalid("index data out of bounds");
+	}
+
+	if (header.StreamCount == 0)
+	{
+		return invalid("no vertex streams");
+	}
+
+	uint64_t offset = sizeof(header);
+	if (!InFile(offset, static_cast<uint64_t>(header.StreamCount) * sizeof(StreamRecord), size))
+	{
+		return invalid("truncated stream records");
+	}
+
+	std::vector<StreamRecord> records(header.StreamCount);
+	std::memcpy(records.data(), data + offset, records.size() * sizeof(StreamRecord));
+	offset += records.size() * sizeof(StreamRecord);
+
+	// Indices reach into every per vertex stream, per instance ones are sized by the instance count
+	uint64_t vertexCount = std::numeric_limits<uint64_t>::max();
+	for (const auto& record : records)
+	{
+		if (record.ElementCount == 0 || record.Stride == 0)
+		{
+			return invalid("empty vertex layout");
+		}
+		if (!InFile(offset, static_cast<uint64_t>(record.ElementCount) * sizeof(ElementRecord), size))
+		{
+			return invalid("truncated layout");
+		}
+
+		std::vector<Gl::BufferElement> elements;
+		for (uint32_t i = 0; i < record.ElementCount; i++, offset += sizeof(ElementRecord))
+		{
+			ElementRecord element;
+			std::memcpy(&element, data + offset, sizeof(element));
+			element.Name[MaxNameLength] = '\0';
+
+			if (element.Type == 0 || element.Type > LastDataType)
+			{
+				return invalid("unknown attribute type");
+			}
+			elements.emplace_back(static_cast<Gl::ShaderDataType>(element.Type), element.Name, element.Normalized != 0, element.Divisor);
+		}
+
+		Gl::BufferLayout layout(elements);
+		if (layout.GetStride() != record.Stride
+			|| record.DataSize != static_cast<uint64_t>(record.VertexCount) * record.Stride
+			|| !InFile(record.DataOffset, record.DataSize, size))
+		{
+			return invalid("vertex data out of bounds");
+		}
+
+		const auto& layoutElements = layout.GetElements();
+		if (std::none_of(layoutElements.begin(), layoutElements.end(), [](const auto& el) { return el.Divisor > 0; }))
+		{
+			vertexCount = std::min<uint64_t>(vertexCount, record.VertexCount);
+		}
+
+		mesh->m_Streams.push_back({ layout, data + record.DataOffset, record.VertexCount });
+	}
+
+	// Checked once here so a bad file can't make the GPU read past the vertex buffers
+	if (header.IndexCount > 0 && MaxIndex(data + header.IndexOffset, header.IndexCount, header.IndexType) >= vertexCount)
+	{
+		return invalid("index out of range");
+	}
+
+	mesh->m_DrawType = header.DrawType;
+	mesh->m_IndexType = header.IndexType;
+	mesh->m_IndexCount = header.IndexCount;
+	mesh->m_IndexData = data + header.IndexOffset;
+
+	return mesh;
+}
+
+std::unique_ptr<StaticMesh> MeshFile::CreateStaticMesh() const
+{
+	if (m_Streams.empty())
+	{
+		return nullptr;
+	}
+
+	auto mesh = std::make_unique<StaticMesh>(m_Streams[0].Layout);
+	for (size_t i = 1; i < m_Streams.size(); i++)
+	{
+		mesh->CreateNewVertexBuffer(m_Streams[i].Layout);
+	}
+
+	mesh->SetDrawType(m_DrawType);
+	for (uint32_t i = 0; i < m_Streams.size(); i++)
+	{
+		const auto& stream = m_Streams[i];
+		mesh->UploadVertexData(i, stream.Data, static_cast<size_t>(stream.VertexCount) * stream.Layout.GetStride());
+	}
+
+	if (m_IndexCount > 0)
+	{
+		mesh->UploadIndexData(m_IndexData, m_IndexCount, m_IndexType);
+	}
+
+	return mesh;
+}
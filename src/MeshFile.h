@@ -0,0 +1,64 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+#include "Buffer.h"
+#include "MappedFile.h"
+#include "StaticMesh.h"
+#include "DynamicMesh.h"
+
+// Versioned binary mesh container that's loaded by mapping the file
+// A fixed header is followed by one record per vertex stream (stride, count, blob location), the
+// layout elements of every stream and then the vertex and index blobs, each aligned to BlobAlignment.
+// Nothing is converted on load, Open only validates the records, the draw/index types and the largest
+// index, then the mapped blobs are handed to the GL buffer uploads as they are.
+// Stored little endian, the index type is the narrowest one that fits.
+
+struct MeshFileStream
+{
+	Gl::BufferLayout Layout;
+	const void* Data;
+	uint32_t VertexCount;
+};
+
+class MeshFile
+{
+public:
+	static constexpr uint32_t Magic = 0x4d504c47; // "GLPM"
+	static constexpr uint32_t Version = 1;
+	static constexpr uint32_t BlobAlignment = 64;
+
+	static bool Write(const std::string& path, const std::vector<MeshFileStream>& streams, GLint drawType,
+		const void* indices, uint32_t indexCount, GLenum indexType);
+	static bool Write(const std::string& path, const MeshData& mesh, const Gl::BufferLayout& layout);
+	static bool Write(const std::string& path, const DynamicMesh& mesh);
+	// Reads the vertex and index buffers back from the GPU, chunked index buffers aren't supported
+	static bool Write(const std::string& path, const StaticMesh& mesh);
+
+	// Maps the file and validates every record against its size and the indices against the vertex count, nullptr on error
+	static std::unique_ptr<MeshFile> Open(const std::string& path);
+
+	GLint GetDrawType() const { return m_DrawType; }
+	GLenum GetIndexType() const { return m_IndexType; }
+	uint32_t GetIndexCount() const { return m_IndexCount; }
+	const void* GetIndexData() const { return m_IndexData; }
+
+	uint32_t GetStreamCount() const { return m_Streams.size(); }
+	const MeshFileStream& GetStream(uint32_t stream) const { return m_Streams[stream]; }
+	size_t GetFileSize() const { return m_File.GetSize(); }
+
+	// Uploads straight from the mapped pages
+	std::unique_ptr<StaticMesh> CreateStaticMesh() const;
+private:
+	MappedFile m_File;
+	GLint m_DrawType{ GL_TRIANGLES };
+	GLenum m_IndexType{ GL_UNSIGNED_INT };
+	uint32_t m_IndexCount{ 0 };
+	const void* m_IndexData{ nullptr };
+	std::vector<MeshFileStream> m_Streams;
+};
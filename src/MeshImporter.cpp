@@ -0,0 +1,1435 @@
+#include "MeshImporter.h"
+
+#include <deque>
+#include <cmath>
+#include <chrono>
+#include <limits>
+#include <sstream>
+#include <memory>
+#include <cstring>
+#include <fstream>
+#include <charconv>
+#include <iostream>
+#include <algorithm>
+#include <type_traits>
+
+#include "VertexEncoding.h"
+
+namespace
+{
+	constexpr uint32_t Missing = 0xffffffff;
+
+	// Attribute arrays every format parses into, empty when the file doesn't have them
+	struct SourceData
+	{
+		std::vector<float> Positions; // 3 per vertex
+		std::vector<float> Normals; // 3 per vertex
+		std::vector<float> Uvs; // 2 per vertex
+		std::vector<float> Colors; // 4 per position
+	};
+
+	struct VertexKey
+	{
+		uint32_t Position;
+		uint32_t Uv;
+		uint32_t Normal;
+
+		bool operator==(const VertexKey& o) const { return Position == o.Position && Uv == o.Uv && Normal == o.Normal; }
+	};
+
+	enum class Source
+	{
+		None,
+		Position,
+		Normal,
+		Uv,
+		Color
+	};
+
+	Source SourceFor(const std::string& name)
+	{
+		if (name == "position")
+		{
+			return Source::Position;
+		}
+		if (name == "normal")
+		{
+			return Source::Normal;
+		}
+		if (name == "uv" || name == "texcoord")
+		{
+			return Source::Uv;
+		}
+		if (name == "color")
+		{
+			return Source::Color;
+		}
+		return Source::None;
+	}
+
+	template<typename T>
+	void StoreComponents(const float* values, uint32_t count, bool normalized, uint8_t* dst)
+	{
+		constexpr uint32_t bits = sizeof(T) * 8;
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			T value;
+			if (normalized)
+			{
+				value = static_cast<T>(std::is_signed_v<T> ? EncodeSnorm(values[i], bits) : EncodeUnorm(values[i], bits));
+			}
+			else
+			{
+				const float min = static_cast<float>(std::numeric_limits<T>::min());
+				const float max = static_cast<float>(std::numeric_limits<T>::max());
+				value = static_cast<T>(std::lround(std::clamp(values[i], min, max)));
+			}
+			std::memcpy(dst + i * sizeof(T), &value, sizeof(T));
+		}
+	}
+
+	// values always has 4 components, the element takes as many as it has
+	void EncodeAttribute(const Gl::BufferElement& element, const float* values, uint8_t* dst)
+	{
+		const uint32_t count = element.GetComponentCount();
+
+		switch (element.Type)
+		{
+		case Gl::ShaderDataType::Float:
+		case Gl::ShaderDataType::Float2:
+		case Gl::ShaderDataType::Float3:
+		case Gl::ShaderDataType::Float4:
+			std::memcpy(dst, values, count * sizeof(float));
+			break;
+		case Gl::ShaderDataType::Half2:
+		case Gl::ShaderDataType::Half4:
+			for (uint32_t i = 0; i < count; i++)
+			{
+				const uint16_t half = EncodeHalf(values[i]);
+				std::memcpy(dst + i * sizeof(half), &half, sizeof(half));
+			}
+			break;
+		case Gl::ShaderDataType::Byte4:
+			StoreComponents<int8_t>(values, count, element.Normalized, dst);
+			break;
+		case Gl::ShaderDataType::UByte4:
+			StoreComponents<uint8_t>(values, count, element.Normalized, dst);
+			break;
+		case Gl::ShaderDataType::Short2:
+		case Gl::ShaderDataType::Short4:
+			StoreComponents<int16_t>(values, count, element.Normalized, dst);
+			break;
+		case Gl::ShaderDataType::UShort2:
+		case Gl::ShaderDataType::UShort4:
+			StoreComponents<uint16_t>(values, count, element.Normalized, dst);
+			break;
+		case Gl::ShaderDataType::Int2_10_10_10:
+		{
+			const uint32_t packed = PackSnorm1010102(glm::vec4(values[0], values[1], values[2], values[3]));
+			std::memcpy(dst, &packed, sizeof(packed));
+			break;
+		}
+		case Gl::ShaderDataType::UInt2_10_10_10:
+		{
+			const uint32_t packed = PackUnorm1010102(glm::vec4(values[0], values[1], values[2], values[3]));
+			std::memcpy(dst, &packed, sizeof(packed));
+			break;
+		}
+		default:
+			// Integer, matrix and bool elements aren't filled from mesh files
+			std::memset(dst, 0, element.Size);
+			break;
+		}
+	}
+
+	void FetchAttribute(Source source, const SourceData& data, const VertexKey& key, float* values)
+	{
+		switch (source)
+		{
+		case Source::Position:
+			values[0] = data.Positions[key.Position * 3];
+			values[1] = data.Positions[key.Position * 3 + 1];
+			values[2] = data.Positions[key.Position * 3 + 2];
+			values[3] = 1.f;
+			return;
+		case Source::Normal:
+			if (key.Normal != Missing && !data.Normals.empty())
+			{
+				values[0] = data.Normals[key.Normal * 3];
+				values[1] = data.Normals[key.Normal * 3 + 1];
+				values[2] = data.Normals[key.Normal * 3 + 2];
+				values[3] = 0.f;
+				return;
+			}
+			break;
+		case Source::Uv:
+			if (key.Uv != Missing && !data.Uvs.empty())
+			{
+				values[0] = data.Uvs[key.Uv * 2];
+				values[1] = data.Uvs[key.Uv * 2 + 1];
+				values[2] = 0.f;
+				values[3] = 0.f;
+				return;
+			}
+			break;
+		case Source::Color:
+			if (!data.Colors.empty())
+			{
+				std::memcpy(values, &data.Colors[key.Position * 4], 4 * sizeof(float));
+			}
+			else
+			{
+				std::fill_n(values, 4, 1.f);
+			}
+			return;
+		default:
+			break;
+		}
+
+		std::fill_n(values, 4, 0.f);
+	}
+
+	// Builds the interleaved vertices in parallel, key(i) gives the attribute indices of vertex i
+	template<typename KeyFunc>
+	void WriteVertices(JobSystem& jobs, const Gl::BufferLayout& layout, const SourceData& data, uint32_t count, KeyFunc key, MeshData& mesh)
+	{
+		struct Target
+		{
+			const Gl::BufferElement* Element;
+			Source From;
+		};
+
+		std::vector<Target> targets;
+		for (const auto& element : layout.GetElements())
+		{
+			targets.push_back({ &element, SourceFor(element.Name) });
+		}
+
+		const uint32_t stride = layout.GetStride();
+		mesh.Vertices.assign(static_cast<size_t>(count) * stride / sizeof(float), 0.f);
+		auto* bytes = reinterpret_cast<uint8_t*>(mesh.Vertices.data());
+
+		jobs.ParallelFor(count, 16384, [&](uint32_t begin, uint32_t end)
+		{
+			float values[4];
+			for (uint32_t v = begin; v < end; v++)
+			{
+				const VertexKey vertexKey = key(v);
+				uint8_t* vertex = bytes + static_cast<size_t>(v) * stride;
+				for (const auto& target : targets)
+				{
+					FetchAttribute(target.From, data, vertexKey, values);
+					EncodeAttribute(*target.Element, values, vertex + target.Element->Offset);
+				}
+			}
+		});
+	}
+
+	// Reads text in blocks cut at line ends, parses each block as a job and merges them in file order
+	// Memory is bounded by the blocks in flight, not by the file size
+	template<typename Chunk, typename Parse, typename Merge>
+	bool StreamTextBlocks(std::istream& file, size_t blockSize, JobSystem& jobs, Parse parse, Merge merge, size_t& bytes)
+	{
+		struct Pending
+		{
+			JobCounter Counter;
+			Chunk Data;
+		};
+
+		const size_t maxInFlight = jobs.GetWorkerCount() + 2;
+		std::deque<std::unique_ptr<Pending>> pending;
+		std::string carry;
+		bool ok = true;
+
+		while (true)
+		{
+			std::string text = std::move(carry);
+			carry.clear();
+
+			const size_t start = text.size();
+			text.resize(start + blockSize);
+			file.read(&text[start], blockSize);
+			const size_t read = static_cast<size_t>(file.gcount());
+			text.resize(start + read);
+			bytes += read;
+
+			const bool eof = read < blockSize;
+			if (!eof)
+			{
+				const size_t cut = text.rfind('\n');
+				if (cut == std::string::npos)
+				{
+					// A line longer than a block, keep reading
+					carry = std::move(text);
+					continue;
+				}
+				carry.assign(text, cut + 1, std::string::npos);
+				text.resize(cut + 1);
+			}
+
+			if (!text.empty())
+			{
+				auto chunk = std::make_unique<Pending>();
+				chunk->Data.Text = std::move(text);
+				Chunk* data = &chunk->Data;
+				jobs.Run([data, &parse]() { parse(*data); }, chunk->Counter);
+				pending.push_back(std::move(chunk));
+			}
+
+			while (!pending.empty() && (pending.size() >= maxInFlight || eof))
+			{
+				jobs.Wait(pending.front()->Counter);
+				ok = merge(pending.front()->Data) && ok;
+				pending.pop_front();
+			}
+
+			if (eof)
+			{
+				break;
+			}
+		}
+
+		return ok;
+	}
+
+	const char* SkipSpaces(const char* p, const char* end)
+	{
+		while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+		{
+			p++;
+		}
+		return p;
+	}
+
+	template<typename T>
+	bool ParseNumber(const char*& p, const char* end, T& value)
+	{
+		p = SkipSpaces(p, end);
+		if (p < end && *p == '+')
+		{
+			p++;
+		}
+
+		const auto result = std::from_chars(p, end, value);
+		if (result.ec != std::errc())
+		{
+			return false;
+		}
+		p = result.ptr;
+		return true;
+	}
+
+	// OBJ
+
+	// Indices as written in the file, relative ones are resolved when the chunk is merged
+	struct ObjCorner
+	{
+		int32_t Index[3]; // position, uv, normal, -1 when missing
+		uint8_t Relative; // bit per index that's relative to the chunk's first element
+	};
+
+	struct ObjChunk
+	{
+		std::string Text;
+		SourceData Data;
+		bool HasColors{ false };
+		std::vector<ObjCorner> Corners; // three per triangle
+		uint32_t BadLines{ 0 };
+	};
+
+	bool ParseObjCorner(const char*& p, const char* end, const uint32_t localCounts[3], ObjCorner& corner)
+	{
+		int32_t raw[3]{ 0, 0, 0 };
+
+		if (!ParseNumber(p, end, raw[0]))
+		{
+			return false;
+		}
+		if (p < end && *p == '/')
+		{
+			p++;
+			if (p < end && *p != '/' && !ParseNumber(p, end, raw[1]))
+			{
+				return false;
+			}
+			if (p < end && *p == '/')
+			{
+				p++;
+				if (!ParseNumber(p, end, raw[2]))
+				{
+					return false;
+				}
+			}
+		}
+
+		corner.Relative = 0;
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			if (raw[i] > 0)
+			{
+				corner.Index[i] = raw[i] - 1;
+			}
+			else if (raw[i] < 0)
+			{
+				corner.Index[i] = static_cast<int32_t>(localCounts[i]) + raw[i];
+				corner.Relative |= 1 << i;
+			}
+			else
+			{
+				corner.Index[i] = -1;
+			}
+		}
+
+		return raw[0] != 0;
+	}
+
+	void ParseObjChunk(ObjChunk& chunk)
+	{
+		const char* p = chunk.Text.data();
+		const char* end = p + chunk.Text.size();
+		auto& data = chunk.Data;
+		std::vector<ObjCorner> polygon;
+
+		while (p < end)
+		{
+			const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', end - p));
+			lineEnd = lineEnd ? lineEnd : end;
+
+			p = SkipSpaces(p, lineEnd);
+			const size_t length = lineEnd - p;
+
+			if (length > 2 && p[0] == 'v' && (p[1] == ' ' || p[1] == '\t'))
+			{
+				p += 2;
+				float values[6];
+				uint32_t count = 0;
+				while (count < 6 && ParseNumber(p, lineEnd, values[count]))
+				{
+					count++;
+				}
+
+				if (count < 3)
+				{
+					chunk.BadLines++;
+				}
+				else
+				{
+					data.Positions.insert(data.Positions.end(), values, values + 3);
+
+					// "v x y z r g b" is a common extension
+					if (count == 6 && !chunk.HasColors)
+					{
+						chunk.HasColors = true;
+						data.Colors.assign(data.Positions.size() / 3 * 4 - 4, 1.f);
+					}
+					if (chunk.HasColors)
+					{
+						data.Colors.insert(data.Colors.end(), { count == 6 ? values[3] : 1.f, count == 6 ? values[4] : 1.f, count == 6 ? values[5] : 1.f, 1.f });
+					}
+				}
+			}
+			else if (length > 3 && p[0] == 'v' && p[1] == 't' && (p[2] == ' ' || p[2] == '\t'))
+			{
+				p += 3;
+				float u = 0.f, v = 0.f;
+				if (!ParseNumber(p, lineEnd, u))
+				{
+					chunk.BadLines++;
+				}
+				ParseNumber(p, lineEnd, v);
+				data.Uvs.push_back(u);
+				data.Uvs.push_back(v);
+			}
+			else if (length > 3 && p[0] == 'v' && p[1] == 'n' && (p[2] == ' ' || p[2] == '\t'))
+			{
+				p += 3;
+				float n[3]{ 0.f, 0.f, 0.f };
+				if (!ParseNumber(p, lineEnd, n[0]) || !ParseNumber(p, lineEnd, n[1]) || !ParseNumber(p, lineEnd, n[2]))
+				{
+					chunk.BadLines++;
+				}
+				data.Normals.insert(data.Normals.end(), n, n + 3);
+			}
+			else if (length > 2 && p[0] == 'f' && (p[1] == ' ' || p[1] == '\t'))
+			{
+				p += 2;
+				const uint32_t localCounts[3]{
+					static_cast<uint32_t>(data.Positions.size() / 3),
+					static_cast<uint32_t>(data.Uvs.size() / 2),
+					static_cast<uint32_t>(data.Normals.size() / 3)
+				};
+
+				polygon.clear();
+				ObjCorner corner;
+				while (ParseObjCorner(p, lineEnd, localCounts, corner))
+				{
+					polygon.push_back(corner);
+				}
+
+				if (polygon.size() < 3)
+				{
+					chunk.BadLines++;
+				}
+
+				for (size_t i = 2; i < polygon.size(); i++)
+				{
+					chunk.Corners.push_back(polygon[0]);
+					chunk.Corners.push_back(polygon[i - 1]);
+					chunk.Corners.push_back(polygon[i]);
+				}
+			}
+
+			// Comments, groups, materials, smoothing groups, lines and points are skipped
+			p = lineEnd + 1;
+		}
+
+		chunk.Text.clear();
+		chunk.Text.shrink_to_fit();
+	}
+
+	// Open addressing map from corner indices to vertex index, grows at half full
+	class VertexKeyMap
+	{
+	public:
+		VertexKeyMap() : m_Slots(1024, { { Missing, Missing, Missing }, Missing }) {}
+
+		// Returns the vertex of key, adding it as nextIndex if it's new
+		uint32_t Insert(const VertexKey& key, uint32_t nextIndex)
+		{
+			if ((m_Count + 1) * 2 > m_Slots.size())
+			{
+				Grow();
+			}
+
+			const size_t mask = m_Slots.size() - 1;
+			for (size_t slot = Hash(key) & mask; ; slot = (slot + 1) & mask)
+			{
+				auto& entry = m_Slots[slot];
+				if (entry.Index == Missing)
+				{
+					entry = { key, nextIndex };
+					m_Count++;
+					return nextIndex;
+				}
+				if (entry.Key == key)
+				{
+					return entry.Index;
+				}
+			}
+		}
+	private:
+		struct Slot
+		{
+			VertexKey Key;
+			uint32_t Index;
+		};
+
+		static size_t Hash(const VertexKey& key)
+		{
+			uint64_t hash = (static_cast<uint64_t>(key.Position) << 32 | key.Uv) * 0x9e3779b97f4a7c15ull;
+			hash ^= key.Normal * 0xbf58476d1ce4e5b9ull;
+			return static_cast<size_t>(hash ^ (hash >> 31));
+		}
+
+		void Grow()
+		{
+			std::vector<Slot> old(m_Slots.size() * 2, { { Missing, Missing, Missing }, Missing });
+			old.swap(m_Slots);
+
+			const size_t mask = m_Slots.size() - 1;
+			for (const auto& entry : old)
+			{
+				if (entry.Index == Missing)
+				{
+					continue;
+				}
+
+				size_t slot = Hash(entry.Key) & mask;
+				while (m_Slots[slot].Index != Missing)
+				{
+					slot = (slot + 1) & mask;
+				}
+				m_Slots[slot] = entry;
+			}
+		}
+
+		std::vector<Slot> m_Slots;
+		size_t m_Count{ 0 };
+	};
+
+	bool ImportObj(std::istream& file, size_t blockSize, JobSystem& jobs, const Gl::BufferLayout& layout, MeshData& mesh, size_t& bytes)
+	{
+		SourceData data;
+		VertexKeyMap keyMap;
+		std::vector<VertexKey> keys;
+		uint32_t badLines = 0;
+		bool badIndices = false;
+
+		mesh.Indices.clear();
+
+		const auto merge = [&](ObjChunk& chunk)
+		{
+			const uint32_t bases[3]{
+				static_cast<uint32_t>(data.Positions.size() / 3),
+				static_cast<uint32_t>(data.Uvs.size() / 2),
+				static_cast<uint32_t>(data.Normals.size() / 3)
+			};
+
+			// Colors are kept for every position once any vertex had one
+			if (chunk.HasColors && data.Colors.empty())
+			{
+				data.Colors.assign(static_cast<size_t>(bases[0]) * 4, 1.f);
+			}
+			if (!chunk.HasColors && !data.Colors.empty())
+			{
+				chunk.Data.Colors.assign(chunk.Data.Positions.size() / 3 * 4, 1.f);
+			}
+
+			data.Positions.insert(data.Positions.end(), chunk.Data.Positions.begin(), chunk.Data.Positions.end());
+			data.Uvs.insert(data.Uvs.end(), chunk.Data.Uvs.begin(), chunk.Data.Uvs.end());
+			data.Normals.insert(data.Normals.end(), chunk.Data.Normals.begin(), chunk.Data.Normals.end());
+			data.Colors.insert(data.Colors.end(), chunk.Data.Colors.begin(), chunk.Data.Colors.end());
+
+			for (const auto& corner : chunk.Corners)
+			{
+				uint32_t resolved[3];
+				for (uint32_t i = 0; i < 3; i++)
+				{
+					const int64_t index = (corner.Relative & (1 << i)) ? static_cast<int64_t>(bases[i]) + corner.Index[i] : corner.Index[i];
+					resolved[i] = index >= 0 ? static_cast<uint32_t>(index) : Missing;
+				}
+				badIndices |= resolved[0] == Missing;
+
+				const VertexKey key{ resolved[0], resolved[1], resolved[2] };
+				const uint32_t index = keyMap.Insert(key, keys.size());
+				if (index == keys.size())
+				{
+					keys.push_back(key);
+				}
+				mesh.Indices.push_back(index);
+			}
+
+			badLines += chunk.BadLines;
+			chunk = ObjChunk();
+			return true;
+		};
+
+		StreamTextBlocks<ObjChunk>(file, blockSize, jobs, ParseObjChunk, merge, bytes);
+
+		if (badLines > 0)
+		{
+			std::cerr << "Skipped " << badLines << " malformed OBJ lines\n";
+		}
+
+		// Indices may point forward in the file, they can only be checked once everything is read
+		const uint32_t counts[3]{
+			static_cast<uint32_t>(data.Positions.size() / 3),
+			static_cast<uint32_t>(data.Uvs.size() / 2),
+			static_cast<uint32_t>(data.Normals.size() / 3)
+		};
+		for (auto& key : keys)
+		{
+			badIndices |= key.Position >= counts[0];
+			key.Uv = key.Uv < counts[1] ? key.Uv : Missing;
+			key.Normal = key.Normal < counts[2] ? key.Normal : Missing;
+		}
+
+		if (badIndices)
+		{
+			std::cerr << "OBJ face references a missing position\n";
+			return false;
+		}
+
+		WriteVertices(jobs, layout, data, keys.size(), [&keys](uint32_t v) { return keys[v]; }, mesh);
+		return true;
+	}
+
+	// PLY
+
+	enum class PlyType
+	{
+		Int8,
+		UInt8,
+		Int16,
+		UInt16,
+		Int32,
+		UInt32,
+		Float32,
+		Float64,
+		Invalid
+	};
+
+	PlyType ParsePlyType(const std::string& name)
+	{
+		static const std::pair<const char*, PlyType> types[]{
+			{ "char", PlyType::Int8 }, { "int8", PlyType::Int8 },
+			{ "uchar", PlyType::UInt8 }, { "uint8", PlyType::UInt8 },
+			{ "short", PlyType::Int16 }, { "int16", PlyType::Int16 },
+			{ "ushort", PlyType::UInt16 }, { "uint16", PlyType::UInt16 },
+			{ "int", PlyType::Int32 }, { "int32", PlyType::Int32 },
+			{ "uint", PlyType::UInt32 }, { "uint32", PlyType::UInt32 },
+			{ "float", PlyType::Float32 }, { "float32", PlyType::Float32 },
+			{ "double", PlyType::Float64 }, { "float64", PlyType::Float64 },
+		};
+
+		for (const auto& type : types)
+		{
+			if (name == type.first)
+			{
+				return type.second;
+			}
+		}
+		return PlyType::Invalid;
+	}
+
+	uint32_t PlyTypeSize(PlyType type)
+	{
+		static constexpr uint32_t sizes[]{ 1, 1, 2, 2, 4, 4, 4, 8, 0 };
+		return sizes[static_cast<int>(type)];
+	}
+
+	double DecodePlyValue(const uint8_t* src, PlyType type, bool swap)
+	{
+		uint8_t bytes[8];
+		const uint32_t size = PlyTypeSize(type);
+		std::memcpy(bytes, src, size);
+		if (swap)
+		{
+			std::reverse(bytes, bytes + size);
+		}
+
+		const auto as = [&bytes](auto value)
+		{
+			std::memcpy(&value, bytes, sizeof(value));
+			return static_cast<double>(value);
+		};
+
+		switch (type)
+		{
+		case PlyType::Int8: return as(int8_t());
+		case PlyType::UInt8: return as(uint8_t());
+		case PlyType::Int16: return as(int16_t());
+		case PlyType::UInt16: return as(uint16_t());
+		case PlyType::Int32: return as(int32_t());
+		case PlyType::UInt32: return as(uint32_t());
+		case PlyType::Float32: return as(float());
+		case PlyType::Float64: return as(double());
+		default: return 0.0;
+		}
+	}
+
+	struct PlyProperty
+	{
+		std::string Name;
+		PlyType Type;
+		bool IsList{ false };
+		PlyType CountType{ PlyType::Invalid };
+	};
+
+	struct PlyElement
+	{
+		std::string Name;
+		uint32_t Count{ 0 };
+		std::vector<PlyProperty> Properties;
+
+		bool HasLists() const
+		{
+			return std::any_of(Properties.begin(), Properties.end(), [](const auto& p) { return p.IsList; });
+		}
+
+		uint32_t RecordSize() const
+		{
+			uint32_t size = 0;
+			for (const auto& property : Properties)
+			{
+				size += PlyTypeSize(property.Type);
+			}
+			return size;
+		}
+
+		// Smallest a row can be, a digit and a separator per ascii value, empty lists in binary
+		uint32_t MinRecordSize(bool ascii) const
+		{
+			uint32_t size = 0;
+			for (const auto& property : Properties)
+			{
+				size += ascii ? 2 : PlyTypeSize(property.IsList ? property.CountType : property.Type);
+			}
+			return size;
+		}
+	};
+
+	// Bytes from the read position to the end, the maximum when the stream can't seek
+	uint64_t RemainingBytes(std::istream& file)
+	{
+		const auto position = file.tellg();
+		if (position < 0 || !file.seekg(0, std::ios::end))
+		{
+			file.clear();
+			return std::numeric_limits<uint64_t>::max();
+		}
+		const auto end = file.tellg();
+		file.seekg(position);
+		return static_cast<uint64_t>(end - position);
+	}
+
+	enum class PlyFormat
+	{
+		Ascii,
+		BinaryLittleEndian,
+		BinaryBigEndian
+	};
+
+	bool ParsePlyHeader(std::istream& file, PlyFormat& format, std::vector<PlyElement>& elements, size_t& bytes)
+	{
+		std::string line;
+		bool first = true;
+		bool hasFormat = false;
+
+		while (std::getline(file, line))
+		{
+			bytes += line.size() + 1;
+			if (!line.empty() && line.back() == '\r')
+			{
+				line.pop_back();
+			}
+
+			if (first)
+			{
+				if (line != "ply")
+				{
+					std::cerr << "Not a PLY file\n";
+					return false;
+				}
+				first = false;
+				continue;
+			}
+
+			std::istringstream words(line);
+			std::string keyword;
+			words >> keyword;
+
+			if (keyword == "format")
+			{
+				std::string name;
+				words >> name;
+				hasFormat = true;
+				if (name == "ascii")
+				{
+					format = PlyFormat::Ascii;
+				}
+				else if (name == "binary_little_endian")
+				{
+					format = PlyFormat::BinaryLittleEndian;
+				}
+				else if (name == "binary_big_endian")
+				{
+					format = PlyFormat::BinaryBigEndian;
+				}
+				else
+				{
+					std::cerr << "Unknown PLY format " << name << "\n";
+					return false;
+				}
+			}
+			else if (keyword == "element")
+			{
+				PlyElement element;
+				words >> element.Name >> element.Count;
+				elements.push_back(element);
+			}
+			else if (keyword == "property")
+			{
+				if (elements.empty())
+				{
+					std::cerr << "PLY property outside of an element\n";
+					return false;
+				}
+
+				PlyProperty property;
+				std::string type;
+				words >> type;
+				if (type == "list")
+				{
+					std::string countType;
+					words >> countType >> type;
+					property.IsList = true;
+					property.CountType = ParsePlyType(countType);
+				}
+				property.Type = ParsePlyType(type);
+				words >> property.Name;
+
+				if (property.Type == PlyType::Invalid || (property.IsList && property.CountType == PlyType::Invalid))
+				{
+					std::cerr << "Unknown PLY property type in \"" << line << "\"\n";
+					return false;
+				}
+				elements.back().Properties.push_back(property);
+			}
+			else if (keyword == "end_header")
+			{
+				return hasFormat;
+			}
+		}
+
+		std::cerr << "PLY header without end_header\n";
+		return false;
+	}
+
+	// Where a scalar vertex property goes
+	struct PlyTarget
+	{
+		std::vector<float>* Array{ nullptr };
+		uint32_t Components{ 0 };
+		uint32_t Component{ 0 };
+		float Scale{ 1.f };
+	};
+
+	std::vector<PlyTarget> PlyVertexTargets(const PlyElement& element, SourceData& data)
+	{
+		struct Mapping
+		{
+			const char* Name;
+			std::vector<float> SourceData::* Array;
+			uint32_t Components;
+			uint32_t Component;
+		};
+
+		static const Mapping mappings[]{
+			{ "x", &SourceData::Positions, 3, 0 }, { "y", &SourceData::Positions, 3, 1 }, { "z", &SourceData::Positions, 3, 2 },
+			{ "nx", &SourceData::Normals, 3, 0 }, { "ny", &SourceData::Normals, 3, 1 }, { "nz", &SourceData::Normals, 3, 2 },
+			{ "u", &SourceData::Uvs, 2, 0 }, { "s", &SourceData::Uvs, 2, 0 }, { "texture_u", &SourceData::Uvs, 2, 0 }, { "texture_s", &SourceData::Uvs, 2, 0 },
+			{ "v", &SourceData::Uvs, 2, 1 }, { "t", &SourceData::Uvs, 2, 1 }, { "texture_v", &SourceData::Uvs, 2, 1 }, { "texture_t", &SourceData::Uvs, 2, 1 },
+			{ "red", &SourceData::Colors, 4, 0 }, { "green", &SourceData::Colors, 4, 1 }, { "blue", &SourceData::Colors, 4, 2 }, { "alpha", &SourceData::Colors, 4, 3 },
+		};
+
+		std::vector<PlyTarget> targets(element.Properties.size());
+		for (size_t i = 0; i < element.Properties.size(); i++)
+		{
+			const auto& property = element.Properties[i];
+			for (const auto& mapping : mappings)
+			{
+				if (property.Name != mapping.Name)
+				{
+					continue;
+				}
+
+				auto& array = data.*mapping.Array;
+				if (array.empty())
+				{
+					// Alpha defaults to opaque when only rgb is given
+					array.assign(static_cast<size_t>(element.Count) * mapping.Components, mapping.Array == &SourceData::Colors ? 1.f : 0.f);
+				}
+
+				// Integer colors are normalized to their range
+				float scale = 1.f;
+				if (mapping.Array == &SourceData::Colors && property.Type != PlyType::Float32 && property.Type != PlyType::Float64)
+				{
+					scale = 1.f / ((1ull << (PlyTypeSize(property.Type) * 8)) - 1);
+				}
+
+				targets[i] = { &array, mapping.Components, mapping.Component, scale };
+				break;
+			}
+		}
+
+		return targets;
+	}
+
+	void StorePlyValue(const PlyTarget& target, uint32_t vertex, double value)
+	{
+		if (target.Array)
+		{
+			(*target.Array)[static_cast<size_t>(vertex) * target.Components + target.Component] = static_cast<float>(value) * target.Scale;
+		}
+	}
+
+	// Face lists are triangulated as fans, returns false on an index out of range
+	bool AddPlyFace(const uint32_t* polygon, uint32_t count, uint32_t vertexCount, std::vector<uint32_t>& indices)
+	{
+		for (uint32_t i = 0; i < count; i++)
+		{
+			if (polygon[i] >= vertexCount)
+			{
+				return false;
+			}
+		}
+
+		for (uint32_t i = 2; i < count; i++)
+		{
+			indices.push_back(polygon[0]);
+			indices.push_back(polygon[i - 1]);
+			indices.push_back(polygon[i]);
+		}
+		return true;
+	}
+
+	// List counts and indices come in as any numeric type, only whole numbers that fit are valid
+	bool ToPlyIndex(double value, uint32_t& index)
+	{
+		if (!(value >= 0.0 && value <= std::numeric_limits<uint32_t>::max()) || std::floor(value) != value)
+		{
+			return false;
+		}
+		index = static_cast<uint32_t>(value);
+		return true;
+	}
+
+	bool IsFaceList(const PlyProperty& property)
+	{
+		return property.IsList && (property.Name == "vertex_indices" || property.Name == "vertex_index");
+	}
+
+	// Every non empty line of an ascii block as a row of numbers
+	struct PlyTextChunk
+	{
+		std::string Text;
+		std::vector<double> Values;
+		std::vector<uint32_t> RowEnds;
+		bool Error{ false };
+	};
+
+	void ParsePlyTextChunk(PlyTextChunk& chunk)
+	{
+		const char* p = chunk.Text.data();
+		const char* end = p + chunk.Text.size();
+
+		while (p < end)
+		{
+			const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', end - p));
+			lineEnd = lineEnd ? lineEnd : end;
+
+			const size_t rowStart = chunk.Values.size();
+			double value;
+			while (ParseNumber(p, lineEnd, value))
+			{
+				chunk.Values.push_back(value);
+			}
+			if (SkipSpaces(p, lineEnd) != lineEnd)
+			{
+				chunk.Error = true;
+			}
+			if (chunk.Values.size() > rowStart)
+			{
+				chunk.RowEnds.push_back(chunk.Values.size());
+			}
+
+			p = lineEnd + 1;
+		}
+
+		chunk.Text.clear();
+		chunk.Text.shrink_to_fit();
+	}
+
+	bool ImportPlyAscii(std::istream& file, size_t blockSize, JobSystem& jobs, const std::vector<PlyElement>& elements,
+		const PlyElement* vertices, std::vector<PlyTarget>& targets, MeshData& mesh, size_t& bytes)
+	{
+		size_t elementIdx = 0;
+		uint32_t row = 0;
+		std::vector<uint32_t> polygon;
+
+		const auto merge = [&](PlyTextChunk& chunk)
+		{
+			if (chunk.Error)
+			{
+				std::cerr << "PLY body has non numeric values\n";
+				return false;
+			}
+
+			uint32_t rowStart = 0;
+			for (uint32_t rowEnd : chunk.RowEnds)
+			{
+				const double* values = chunk.Values.data() + rowStart;
+				const uint32_t count = rowEnd - rowStart;
+				rowStart = rowEnd;
+
+				while (elementIdx < elements.size() && row == elements[elementIdx].Count)
+				{
+					elementIdx++;
+					row = 0;
+				}
+				if (elementIdx == elements.size())
+				{
+					break;
+				}
+
+				const auto& element = elements[elementIdx];
+				uint32_t value = 0;
+				for (size_t i = 0; i < element.Properties.size(); i++)
+				{
+					const auto& property = element.Properties[i];
+					if (value >= count)
+					{
+						std::cerr << "PLY row " << row << " of " << element.Name << " is too short\n";
+						return false;
+					}
+
+					if (!property.IsList)
+					{
+						if (&element == vertices)
+						{
+							StorePlyValue(targets[i], row, values[value]);
+						}
+						value++;
+						continue;
+					}
+
+					uint32_t listCount = 0;
+					if (!ToPlyIndex(values[value], listCount))
+					{
+						std::cerr << "PLY row " << row << " of " << element.Name << " has an invalid list count\n";
+						return false;
+					}
+					if (static_cast<size_t>(value) + 1 + listCount > count)
+					{
+						std::cerr << "PLY row " << row << " of " << element.Name << " is too short\n";
+						return false;
+					}
+
+					if (element.Name == "face" && IsFaceList(property))
+					{
+						polygon.resize(listCount);
+						bool valid = true;
+						for (uint32_t j = 0; j < listCount; j++)
+						{
+							valid &= ToPlyIndex(values[value + 1 + j], polygon[j]);
+						}
+						if (!valid || !AddPlyFace(polygon.data(), listCount, vertices->Count, mesh.Indices))
+						{
+							std::cerr << "PLY face index out of range\n";
+							return false;
+						}
+					}
+					value += 1 + listCount;
+				}
+				row++;
+			}
+
+			chunk = PlyTextChunk();
+			return true;
+		};
+
+		if (!StreamTextBlocks<PlyTextChunk>(file, blockSize, jobs, ParsePlyTextChunk, merge, bytes))
+		{
+			return false;
+		}
+
+		// Every element has to reach the row count its header declared
+		while (elementIdx < elements.size() && row == elements[elementIdx].Count)
+		{
+			elementIdx++;
+			row = 0;
+		}
+		if (elementIdx < elements.size())
+		{
+			std::cerr << "PLY file ends inside " << elements[elementIdx].Name << "\n";
+			return false;
+		}
+		return true;
+	}
+
+	// Buffered reads of the binary body
+	class BlockReader
+	{
+	public:
+		BlockReader(std::istream& file, size_t blockSize) : m_File(file), m_BlockSize(blockSize), m_Left(RemainingBytes(file)) {}
+
+		// Pointer to the next size bytes, nullptr at the end of the file
+		const uint8_t* Next(size_t size)
+		{
+			if (m_Pos + size > m_Buffer.size())
+			{
+				// Sizes come from the file, don't grow the buffer past what's left of it
+				if (size - (m_Buffer.size() - m_Pos) > m_Left)
+				{
+					return nullptr;
+				}
+
+				m_Buffer.erase(m_Buffer.begin(), m_Buffer.begin() + m_Pos);
+				m_Pos = 0;
+
+				const size_t start = m_Buffer.size();
+				m_Buffer.resize(start + std::max(m_BlockSize, size));
+				m_File.read(reinterpret_cast<char*>(m_Buffer.data() + start), m_Buffer.size() - start);
+				m_Buffer.resize(start + static_cast<size_t>(m_File.gcount()));
+				m_Bytes += static_cast<size_t>(m_File.gcount());
+				m_Left -= std::min<uint64_t>(m_Left, m_File.gcount());
+
+				if (size > m_Buffer.size())
+				{
+					return nullptr;
+				}
+			}
+
+			const uint8_t* data = m_Buffer.data() + m_Pos;
+			m_Pos += size;
+			return data;
+		}
+
+		size_t GetBytes() const { return m_Bytes; }
+	private:
+		std::istream& m_File;
+		size_t m_BlockSize;
+		std::vector<uint8_t> m_Buffer;
+		size_t m_Pos{ 0 };
+		size_t m_Bytes{ 0 };
+		uint64_t m_Left;
+	};
+
+	bool ImportPlyBinary(std::istream& file, size_t blockSize, JobSystem& jobs, bool swap, const std::vector<PlyElement>& elements,
+		const PlyElement* vertices, std::vector<PlyTarget>& targets, MeshData& mesh, size_t& bytes)
+	{
+		BlockReader reader(file, blockSize);
+		std::vector<uint32_t> polygon;
+
+		for (const auto& element : elements)
+		{
+			// Fixed size vertex records are decoded in parallel, straight into their place
+			if (&element == vertices && !element.HasLists())
+			{
+				const uint32_t recordSize = element.RecordSize();
+				const uint32_t recordsPerJob = std::max<uint32_t>(1, blockSize / 4 / recordSize);
+
+				struct Pending
+				{
+					JobCounter Counter;
+					std::vector<uint8_t> Data;
+				};
+				std::deque<std::unique_ptr<Pending>> pending;
+				const size_t maxInFlight = jobs.GetWorkerCount() + 2;
+
+				for (uint32_t first = 0; first < element.Count; first += recordsPerJob)
+				{
+					const uint32_t count = std::min(recordsPerJob, element.Count - first);
+					const uint8_t* records = reader.Next(static_cast<size_t>(count) * recordSize);
+					if (!records)
+					{
+						std::cerr << "PLY file ends inside the vertex data\n";
+						return false;
+					}
+
+					auto job = std::make_unique<Pending>();
+					job->Data.assign(records, records + static_cast<size_t>(count) * recordSize);
+					const uint8_t* data = job->Data.data();
+
+					jobs.Run([&element, &targets, swap, data, first, count, recordSize]()
+					{
+						for (uint32_t r = 0; r < count; r++)
+						{
+							const uint8_t* record = data + static_cast<size_t>(r) * recordSize;
+							for (size_t i = 0; i < element.Properties.size(); i++)
+							{
+								const PlyType type = element.Properties[i].Type;
+								StorePlyValue(targets[i], first + r, DecodePlyValue(record, type, swap));
+								record += PlyTypeSize(type);
+							}
+						}
+					}, job->Counter);
+					pending.push_back(std::move(job));
+
+					while (pending.size() >= maxInFlight)
+					{
+						jobs.Wait(pending.front()->Counter);
+						pending.pop_front();
+					}
+				}
+
+				for (auto& job : pending)
+				{
+					jobs.Wait(job->Counter);
+				}
+				continue;
+			}
+
+			// Records with lists have to be walked one by one
+			for (uint32_t row = 0; row < element.Count; row++)
+			{
+				for (size_t i = 0; i < element.Properties.size(); i++)
+				{
+					const auto& property = element.Properties[i];
+
+					if (!property.IsList)
+					{
+						const uint8_t* value = reader.Next(PlyTypeSize(property.Type));
+						if (!value)
+						{
+							std::cerr << "PLY file ends inside " << element.Name << "\n";
+							return false;
+						}
+						if (&element == vertices)
+						{
+							StorePlyValue(targets[i], row, DecodePlyValue(value, property.Type, swap));
+						}
+						continue;
+					}
+
+					const uint8_t* countValue = reader.Next(PlyTypeSize(property.CountType));
+					uint32_t count = 0;
+					if (countValue && !ToPlyIndex(DecodePlyValue(countValue, property.CountType, swap), count))
+					{
+						std::cerr << "PLY row " << row << " of " << element.Name << " has an invalid list count\n";
+						return false;
+					}
+					const uint32_t itemSize = PlyTypeSize(property.Type);
+					const uint8_t* items = countValue ? reader.Next(static_cast<size_t>(count) * itemSize) : nullptr;
+					if (!items)
+					{
+						std::cerr << "PLY file ends inside " << element.Name << "\n";
+						return false;
+					}
+
+					if (element.Name == "face" && IsFaceList(property))
+					{
+						polygon.resize(count);
+						bool valid = true;
+						for (uint32_t j = 0; j < count; j++)
+						{
+							valid &= ToPlyIndex(DecodePlyValue(items + j * itemSize, property.Type, swap), polygon[j]);
+						}
+						if (!valid || !AddPlyFace(polygon.data(), count, vertices->Count, mesh.Indices))
+						{
+							std::cerr << "PLY face index out of range\n";
+							return false;
+						}
+					}
+				}
+			}
+		}
+
+		bytes += reader.GetBytes();
+		return true;
+	}
+
+	bool ImportPly(std::istream& file, size_t blockSize, JobSystem& jobs, const Gl::BufferLayout& layout, MeshData& mesh, size_t& bytes)
+	{
+		PlyFormat format = PlyFormat::Ascii;
+		std::vector<PlyElement> elements;
+		if (!ParsePlyHeader(file, format, elements, bytes))
+		{
+			return false;
+		}
+
+		const auto vertexIt = std::find_if(elements.begin(), elements.end(), [](const auto& e) { return e.Name == "vertex"; });
+		if (vertexIt == elements.end())
+		{
+			std::cerr << "PLY file without vertices\n";
+			return false;
+		}
+		const PlyElement* vertices = &*vertexIt;
+
+		// The vertex arrays are sized from the header, a few bytes of it could ask for gigabytes
+		uint64_t minBodySize = 0;
+		for (const auto& element : elements)
+		{
+			minBodySize += static_cast<uint64_t>(element.Count) * element.MinRecordSize(format == PlyFormat::Ascii);
+		}
+		// The last ascii row may end without a newline
+		if (minBodySize > RemainingBytes(file) + 1)
+		{
+			std::cerr << "PLY header declares more rows than the file holds\n";
+			return false;
+		}
+
+		SourceData data;
+		auto targets = PlyVertexTargets(*vertices, data);
+		if (data.Positions.empty())
+		{
+			std::cerr << "PLY vertices without x, y, z\n";
+			return false;
+		}
+
+		mesh.Indices.clear();
+
+		bool ok;
+		if (format == PlyFormat::Ascii)
+		{
+			ok = ImportPlyAscii(file, blockSize, jobs, elements, vertices, targets, mesh, bytes);
+		}
+		else
+		{
+			const uint16_t probe = 1;
+			const bool littleEndianHost = *reinterpret_cast<const uint8_t*>(&probe) == 1;
+			const bool swap = littleEndianHost != (format == PlyFormat::BinaryLittleEndian);
+			ok = ImportPlyBinary(file, blockSize, jobs, swap, elements, vertices, targets, mesh, bytes);
+		}
+
+		if (!ok)
+		{
+			return false;
+		}
+
+		// PLY vertices are unique already, every attribute is indexed by the vertex
+		WriteVertices(jobs, layout, data, vertices->Count, [](uint32_t v) { return VertexKey{ v, v, v }; }, mesh);
+		return true;
+	}
+}
+
+MeshImporter::MeshImporter(JobSystem& jobs, size_t blockSize)
+	:
+	m_Jobs(jobs),
+	m_BlockSize(blockSize)
+{
+}
+
+bool MeshImporter::Import(const std::string& path, const Gl::BufferLayout& layout, MeshData& mesh)
+{
+	assert(layout.GetStride() % sizeof(float) == 0);
+
+	const auto start = std::chrono::steady_clock::now();
+	m_Stats = {};
+
+	std::string extension = path.substr(std::min(path.size(), path.rfind('.')));
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+
+	std::ifstream file(path, std::ios::in | std::ios::binary);
+	if (!file.is_open())
+	{
+		std::cerr << "Error opening file " << path << "\n";
+		return false;
+	}
+
+	mesh.DrawType = GL_TRIANGLES;
+
+	bool ok;
+	if (extension == ".obj")
+	{
+		ok = ImportObj(file, m_BlockSize, m_Jobs, layout, mesh, m_Stats.Bytes);
+	}
+	else if (extension == ".ply")
+	{
+		ok = ImportPly(file, m_BlockSize, m_Jobs, layout, mesh, m_Stats.Bytes);
+	}
+	else
+	{
+		std::cerr << "Unknown mesh format " << path << "\n";
+		return false;
+	}
+
+	if (!ok)
+	{
+		std::cerr << "Failed to import " << path << "\n";
+		return false;
+	}
+
+	m_Stats.Vertices = mesh.Vertices.size() * sizeof(float) / layout.GetStride();
+	m_Stats.Triangles = mesh.Indices.size() / 3;
+	m_Stats.Ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return true;
+}
+
+bool MeshImporter::Import(const std::string& path, StaticMesh& mesh)
+{
+	const auto& layout = mesh.GetVertexBuffer(0).GetLayout();
+
+	MeshData data;
+	if (!Import(path, layout, data))
+	{
+		return false;
+	}
+
+	mesh.SetDrawType(data.DrawType);
+	mesh.UploadVertexData(0, data.Vertices.data(), data.Vertices.size() * sizeof(float));
+	mesh.UploadIndexData(data.Indices);
+	return true;
+}
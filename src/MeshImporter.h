@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+#include "Buffer.h"
+#include "MeshData.h"
+#include "JobSystem.h"
+#include "StaticMesh.h"
+
+// OBJ and PLY (ascii, binary little and big endian) import into interleaved vertices of a given layout
+// The file is read in blocks that are parsed as jobs while the next ones are read, only a few blocks
+// are held at a time so the whole text never sits in memory. Parsed blocks are merged in file order.
+// Layout elements are filled by name: "position", "normal", "uv" (or "texcoord") and "color", others are
+// zeroed. Compact element types are encoded on the way (colors and normals normalized).
+// OBJ corners are deduplicated by their position/uv/normal indices, polygons are triangulated as fans.
+
+struct MeshImportStats
+{
+	size_t Bytes{ 0 };
+	uint32_t Vertices{ 0 };
+	uint32_t Triangles{ 0 };
+	double Ms{ 0.0 };
+};
+
+class MeshImporter
+{
+public:
+	static constexpr size_t DefaultBlockSize = 4 << 20;
+
+	MeshImporter(JobSystem& jobs, size_t blockSize = DefaultBlockSize);
+
+	// The format comes from the extension, the result is an indexed triangle list
+	bool Import(const std::string& path, const Gl::BufferLayout& layout, MeshData& mesh);
+	// Fills the mesh's first vertex buffer (with its layout) and the indices
+	bool Import(const std::string& path, StaticMesh& mesh);
+
+	const MeshImportStats& GetStats() const { return m_Stats; }
+private:
+	JobSystem& m_Jobs;
+	size_t m_BlockSize;
+	MeshImportStats m_Stats;
+};
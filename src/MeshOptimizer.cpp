@@ -0,0 +1,410 @@
+#include "MeshOptimizer.h"
+
+#include <cmath>
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+namespace
+{
+	// Forsyth's LRU cache, larger than the FIFO the stats use since the scores fall off smoothly
+	constexpr uint32_t ScoreCacheSize = 32;
+	constexpr float CacheDecayPower = 1.5f;
+	constexpr float LastTriangleScore = 0.75f;
+	constexpr float ValenceBoostScale = 2.f;
+	constexpr float ValenceBoostPower = 0.5f;
+
+	constexpr uint32_t InvalidTriangle = 0xffffffff;
+
+	float VertexScore(int32_t cachePosition, uint32_t liveTriangles)
+	{
+		if (liveTriangles == 0)
+		{
+			return -1.f;
+		}
+
+		float score = 0.f;
+		if (cachePosition >= 3)
+		{
+			const float scaler = 1.f / (ScoreCacheSize - 3);
+			score = std::pow(1.f - (cachePosition - 3) * scaler, CacheDecayPower);
+		}
+		else if (cachePosition >= 0)
+		{
+			// The last triangle's vertices get a fixed score so the next triangle doesn't just reuse its edge
+			score = LastTriangleScore;
+		}
+
+		// Vertices with few triangles left are finished off first so they leave the cache for good
+		return score + ValenceBoostScale * std::pow(static_cast<float>(liveTriangles), -ValenceBoostPower);
+	}
+
+	// FIFO cache simulated with timestamps, a vertex is cached if it was transformed in the last cacheSize misses
+	class FifoCache
+	{
+	public:
+		FifoCache(uint32_t vertexCount, uint32_t cacheSize)
+			: m_Timestamps(vertexCount, 0), m_CacheSize(cacheSize), m_Time(cacheSize + 1)
+		{
+		}
+
+		uint32_t Triangle(const uint32_t* tri)
+		{
+			uint32_t misses = 0;
+			for (uint32_t i = 0; i < 3; i++)
+			{
+				if (m_Time - m_Timestamps[tri[i]] > m_CacheSize)
+				{
+					m_Timestamps[tri[i]] = m_Time++;
+					misses++;
+				}
+			}
+			return misses;
+		}
+
+		void Reset() { m_Time += m_CacheSize + 1; }
+	private:
+		std::vector<uint32_t> m_Timestamps;
+		uint32_t m_CacheSize;
+		uint32_t m_Time;
+	};
+}
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const uint32_t* indices, size_t count, uint32_t vertexCount, uint32_t cacheSize)
+{
+	assert(count % 3 == 0);
+
+	if (count == 0 || vertexCount == 0)
+	{
+		return {};
+	}
+
+	FifoCache cache(vertexCount, cacheSize);
+	size_t misses = 0;
+	for (size_t i = 0; i < count; i += 3)
+	{
+		misses += cache.Triangle(indices + i);
+	}
+
+	return { static_cast<float>(misses) / (count / 3), static_cast<float>(misses) / vertexCount };
+}
+
+void MeshOptimizer::OptimizeVertexCache(uint32_t* indices, size_t count, uint32_t vertexCount)
+{
+	assert(count % 3 == 0);
+
+	const uint32_t triangleCount = count / 3;
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	// Triangles of every vertex, the live ones are kept at the front of each range
+	std::vector<uint32_t> liveTriangles(vertexCount, 0);
+	for (size_t i = 0; i < count; i++)
+	{
+		assert(indices[i] < vertexCount);
+		liveTriangles[indices[i]]++;
+	}
+
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (uint32_t v = 0; v < vertexCount; v++)
+	{
+		adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+	}
+
+	std::vector<uint32_t> adjacency(count);
+	{
+		std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < count; i++)
+		{
+			adjacency[fill[indices[i]]++] = i / 3;
+		}
+	}
+
+	std::vector<int32_t> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (uint32_t v = 0; v < vertexCount; v++)
+	{
+		vertexScores[v] = VertexScore(-1, liveTriangles[v]);
+	}
+
+	std::vector<float> triangleScores(triangleCount);
+	std::vector<bool> emitted(triangleCount, false);
+	uint32_t best = 0;
+	for (uint32_t t = 0; t < triangleCount; t++)
+	{
+		const uint32_t* tri = indices + t * 3;
+		triangleScores[t] = vertexScores[tri[0]] + vertexScores[tri[1]] + vertexScores[tri[2]];
+		if (triangleScores[t] > triangleScores[best])
+		{
+			best = t;
+		}
+	}
+
+	std::array<uint32_t, ScoreCacheSize + 3> cache;
+	std::array<uint32_t, ScoreCacheSize + 3> newCache;
+	uint32_t cacheCount = 0;
+
+	std::vector<uint32_t> result(count);
+	uint32_t cursor = 0;
+
+	for (uint32_t out = 0; out < triangleCount; out++)
+	{
+		// Dead end, nothing in the cache has triangles left, continue with the next unemitted one
+		if (best == InvalidTriangle)
+		{
+			while (emitted[cursor])
+			{
+				cursor++;
+			}
+			best = cursor;
+		}
+
+		const uint32_t* tri = indices + best * 3;
+		std::memcpy(&result[out * 3], tri, 3 * sizeof(uint32_t));
+		emitted[best] = true;
+
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			const uint32_t v = tri[i];
+			uint32_t* first = &adjacency[adjacencyOffsets[v]];
+			uint32_t* last = first + liveTriangles[v] - 1;
+			std::iter_swap(std::find(first, last + 1, best), last);
+			liveTriangles[v]--;
+		}
+
+		// The triangle's vertices move to the front, everything else shifts back
+		uint32_t newCount = 0;
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			newCache[newCount++] = tri[i];
+		}
+		for (uint32_t i = 0; i < cacheCount; i++)
+		{
+			const uint32_t v = cache[i];
+			if (v != tri[0] && v != tri[1] && v != tri[2])
+			{
+				newCache[newCount++] = v;
+			}
+		}
+
+		for (uint32_t i = 0; i < newCount; i++)
+		{
+			const uint32_t v = newCache[i];
+			cachePositions[v] = i < ScoreCacheSize ? static_cast<int32_t>(i) : -1;
+			vertexScores[v] = VertexScore(cachePositions[v], liveTriangles[v]);
+		}
+
+		// Only triangles touching the cache changed their score, the best one of them goes next
+		best = InvalidTriangle;
+		float bestScore = -1.f;
+		for (uint32_t i = 0; i < newCount; i++)
+		{
+			const uint32_t v = newCache[i];
+			for (uint32_t j = 0; j < liveTriangles[v]; j++)
+			{
+				const uint32_t t = adjacency[adjacencyOffsets[v] + j];
+				const uint32_t* adj = indices + t * 3;
+				triangleScores[t] = vertexScores[adj[0]] + vertexScores[adj[1]] + vertexScores[adj[2]];
+				if (triangleScores[t] > bestScore)
+				{
+					best = t;
+					bestScore = triangleScores[t];
+				}
+			}
+		}
+
+		cacheCount = std::min(newCount, ScoreCacheSize);
+		std::copy(newCache.begin(), newCache.begin() + cacheCount, cache.begin());
+	}
+
+	std::copy(result.begin(), result.end(), indices);
+}
+
+void MeshOptimizer::OptimizeOverdraw(uint32_t* indices, size_t count, const float* vertices, uint32_t vertexCount, uint32_t vertexLength, float threshold)
+{
+	assert(count % 3 == 0 && vertexLength >= 3);
+
+	const uint32_t triangleCount = count / 3;
+	if (threshold < 1.f || triangleCount == 0)
+	{
+		return;
+	}
+
+	// Hard boundaries are where the cache optimized order ran into a dead end and started cold
+	// The first triangle always starts one, it can miss fewer than 3 times when it's degenerate
+	FifoCache cache(vertexCount, DefaultCacheSize);
+	std::vector<uint32_t> hardClusters;
+	for (uint32_t t = 0; t < triangleCount; t++)
+	{
+		const uint32_t misses = cache.Triangle(indices + t * 3);
+		if (t == 0 || misses == 3)
+		{
+			hardClusters.push_back(t);
+		}
+	}
+	hardClusters.push_back(triangleCount);
+
+	// Soft boundaries split a hard cluster once the part so far is within threshold of the whole cluster's ACMR
+	std::vector<uint32_t> clusters;
+	for (size_t c = 0; c + 1 < hardClusters.size(); c++)
+	{
+		const uint32_t begin = hardClusters[c];
+		const uint32_t end = hardClusters[c + 1];
+
+		cache.Reset();
+		uint32_t misses = 0;
+		for (uint32_t t = begin; t < end; t++)
+		{
+			misses += cache.Triangle(indices + t * 3);
+		}
+		const float limit = static_cast<float>(misses) / (end - begin) * threshold;
+
+		cache.Reset();
+		uint32_t start = begin;
+		misses = 0;
+		for (uint32_t t = begin; t < end; t++)
+		{
+			misses += cache.Triangle(indices + t * 3);
+			if (t + 1 < end && static_cast<float>(misses) / (t + 1 - start) <= limit)
+			{
+				clusters.push_back(start);
+				start = t + 1;
+				misses = 0;
+				cache.Reset();
+			}
+		}
+		clusters.push_back(start);
+	}
+	clusters.push_back(triangleCount);
+
+	const auto position = [&](uint32_t v)
+	{
+		const float* p = vertices + static_cast<size_t>(v) * vertexLength;
+		return glm::vec3(p[0], p[1], p[2]);
+	};
+
+	// Area weighted centroids and normals, the cross product's length is twice the area
+	struct ClusterInfo
+	{
+		glm::vec3 Centroid{ 0.f };
+		glm::vec3 Normal{ 0.f };
+		float Area{ 0.f };
+	};
+
+	std::vector<ClusterInfo> infos(clusters.size() - 1);
+	ClusterInfo mesh;
+	for (size_t c = 0; c < infos.size(); c++)
+	{
+		auto& info = infos[c];
+		for (uint32_t t = clusters[c]; t < clusters[c + 1]; t++)
+		{
+			const glm::vec3 a = position(indices[t * 3]);
+			const glm::vec3 b = position(indices[t * 3 + 1]);
+			const glm::vec3 d = position(indices[t * 3 + 2]);
+
+			const glm::vec3 normal = glm::cross(b - a, d - a);
+			const float area = glm::length(normal);
+
+			info.Centroid += (a + b + d) * (area / 3.f);
+			info.Normal += normal;
+			info.Area += area;
+		}
+
+		mesh.Centroid += info.Centroid;
+		mesh.Area += info.Area;
+
+		info.Centroid = info.Area > 0.f ? info.Centroid / info.Area : info.Centroid;
+		const float length = glm::length(info.Normal);
+		info.Normal = length > 0.f ? info.Normal / length : info.Normal;
+	}
+	mesh.Centroid = mesh.Area > 0.f ? mesh.Centroid / mesh.Area : mesh.Centroid;
+
+	// Clusters pointing away from the center are likely in front of the rest from most view directions
+	std::vector<float> keys(infos.size());
+	std::vector<uint32_t> order(infos.size());
+	for (uint32_t c = 0; c < infos.size(); c++)
+	{
+		keys[c] = glm::dot(infos[c].Centroid - mesh.Centroid, infos[c].Normal);
+		order[c] = c;
+	}
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return keys[a] > keys[b]; });
+
+	std::vector<uint32_t> result;
+	result.reserve(count);
+	for (uint32_t c : order)
+	{
+		result.insert(result.end(), indices + clusters[c] * 3, indices + clusters[c + 1] * 3);
+	}
+
+	assert(result.size() == count);
+	std::copy(result.begin(), result.end(), indices);
+}
+
+std::vector<uint32_t> MeshOptimizer::OptimizeVertexFetch(uint32_t* indices, size_t count, uint32_t vertexCount)
+{
+	std::vector<uint32_t> remap(vertexCount, UnusedVertex);
+	uint32_t next = 0;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		assert(indices[i] < vertexCount);
+
+		uint32_t& mapped = remap[indices[i]];
+		if (mapped == UnusedVertex)
+		{
+			mapped = next++;
+		}
+		indices[i] = mapped;
+	}
+
+	return remap;
+}
+
+uint32_t MeshOptimizer::RemapVertices(void* vertices, uint32_t vertexCount, size_t vertexSize, const std::vector<uint32_t>& remap)
+{
+	assert(remap.size() == vertexCount);
+
+	auto* bytes = static_cast<unsigned char*>(vertices);
+	const std::vector<unsigned char> source(bytes, bytes + vertexCount * vertexSize);
+
+	uint32_t newCount = 0;
+	for (uint32_t v = 0; v < vertexCount; v++)
+	{
+		if (remap[v] != UnusedVertex)
+		{
+			std::memcpy(bytes + remap[v] * vertexSize, &source[v * vertexSize], vertexSize);
+			newCount = std::max(newCount, remap[v] + 1);
+		}
+	}
+
+	return newCount;
+}
+
+MeshOptimizerReport MeshOptimizer::Optimize(MeshData& mesh, uint32_t vertexLength, float overdrawThreshold)
+{
+	assert(mesh.DrawType == GL_TRIANGLES);
+	assert(mesh.Vertices.size() % vertexLength == 0);
+
+	MeshOptimizerReport report;
+
+	const uint32_t vertexCount = mesh.Vertices.size() / vertexLength;
+	auto& indices = mesh.Indices;
+
+	report.Before = AnalyzeVertexCache(indices.data(), indices.size(), vertexCount);
+
+	OptimizeVertexCache(indices.data(), indices.size(), vertexCount);
+	OptimizeOverdraw(indices.data(), indices.size(), mesh.Vertices.data(), vertexCount, vertexLength, overdrawThreshold);
+
+	const auto remap = OptimizeVertexFetch(indices.data(), indices.size(), vertexCount);
+	report.VertexCount = RemapVertices(mesh.Vertices.data(), vertexCount, vertexLength * sizeof(float), remap);
+	mesh.Vertices.resize(static_cast<size_t>(report.VertexCount) * vertexLength);
+
+	report.After = AnalyzeVertexCache(indices.data(), indices.size(), report.VertexCount);
+
+	return report;
+}
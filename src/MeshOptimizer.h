@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "MeshData.h"
+
+// Offline reordering of indexed triangle lists, meant to run once on big static meshes before the upload
+// Triangles are reordered for the post-transform vertex cache (Forsyth's linear-speed algorithm),
+// optionally regrouped so outward facing clusters draw first (overdraw), then vertices are reordered
+// in first use order so vertex fetch walks memory linearly.
+
+struct VertexCacheStats
+{
+	float Acmr{ 0.f }; // transformed vertices per triangle, 0.5 is the best a regular grid can do
+	float Atvr{ 0.f }; // transformed vertices per vertex, 1 is optimal
+};
+
+struct MeshOptimizerReport
+{
+	VertexCacheStats Before;
+	VertexCacheStats After;
+	uint32_t VertexCount{ 0 }; // after unreferenced vertices were dropped
+};
+
+class MeshOptimizer
+{
+public:
+	static constexpr uint32_t UnusedVertex = 0xffffffff;
+	// FIFO size used for the stats, close to what current GPUs reuse
+	static constexpr uint32_t DefaultCacheSize = 16;
+
+	// Simulates a FIFO cache of cacheSize vertices over the triangle list
+	static VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t count, uint32_t vertexCount, uint32_t cacheSize = DefaultCacheSize);
+
+	// Reorders the triangles in place, the indices themselves don't change
+	static void OptimizeVertexCache(uint32_t* indices, size_t count, uint32_t vertexCount);
+
+	// Keeps the cache optimized order inside clusters and sorts the clusters so the ones facing away
+	// from the mesh center come first. threshold is how much worse than the cache optimized ACMR a
+	// cluster may get before it's split, values below 1 keep the order as it is.
+	// vertexLength is in floats, the position is the first three floats of a vertex
+	static void OptimizeOverdraw(uint32_t* indices, size_t count, const float* vertices, uint32_t vertexCount, uint32_t vertexLength, float threshold = 1.05f);
+
+	// Renumbers the vertices in the order the indices first reference them and rewrites the indices
+	// Returns the old to new vertex map, unreferenced vertices map to UnusedVertex
+	static std::vector<uint32_t> OptimizeVertexFetch(uint32_t* indices, size_t count, uint32_t vertexCount);
+
+	// Moves the vertices of a buffer to their remapped place and drops the unused ones, returns the new vertex count
+	// Every vertex buffer of the mesh has to be remapped with the same map
+	static uint32_t RemapVertices(void* vertices, uint32_t vertexCount, size_t vertexSize, const std::vector<uint32_t>& remap);
+
+	// All of the above on a triangle list, the vertices and indices are replaced
+	static MeshOptimizerReport Optimize(MeshData& mesh, uint32_t vertexLength, float overdrawThreshold = 1.05f);
+};
@@ -0,0 +1,213 @@
+#include "Profiler.h"
+
+#include <cassert>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace Gl
+{
+	Profiler::Profiler(uint32_t historyFrames)
+		:
+		m_HistoryFrames(historyFrames > FrameLatency ? historyFrames : FrameLatency + 1)
+	{
+	}
+
+	Profiler::~Profiler()
+	{
+		for (auto& frame : m_FrameQueries)
+		{
+			if (!frame.Queries.empty())
+			{
+				glDeleteQueries(frame.Queries.size(), frame.Queries.data());
+			}
+		}
+	}
+
+	uint32_t Profiler::RegisterPass(const std::string& name)
+	{
+		auto it = m_PassIds.find(name);
+		if (it != m_PassIds.end())
+		{
+			return it->second;
+		}
+
+		const uint32_t id = m_Passes.size();
+		m_Passes.push_back({
+			name,
+			std::vector<float>(m_HistoryFrames, -1.f),
+			std::vector<float>(m_HistoryFrames, -1.f)
+		});
+		m_PassIds.emplace(name, id);
+
+		return id;
+	}
+
+	void Profiler::BeginFrame()
+	{
+		assert(m_ActivePasses.empty());
+
+		m_Frame++;
+
+		auto& frame = m_FrameQueries[m_Frame % FrameLatency];
+		if (frame.Pending)
+		{
+			Collect(frame, false);
+		}
+
+		frame.Frame = m_Frame;
+		frame.Used = 0;
+
+		const uint32_t idx = HistoryIndex(m_Frame);
+		for (auto& pass : m_Passes)
+		{
+			pass.Cpu[idx] = -1.f;
+			pass.Gpu[idx] = -1.f;
+		}
+	}
+
+	void Profiler::EndFrame()
+	{
+		assert(m_ActivePasses.empty());
+
+		auto& frame = m_FrameQueries[m_Frame % FrameLatency];
+		frame.Pending = frame.Used > 0;
+	}
+
+	void Profiler::BeginPass(uint32_t passId)
+	{
+		assert(passId < m_Passes.size());
+
+		auto& frame = m_FrameQueries[m_Frame % FrameLatency];
+
+		if (frame.Used * 2 + 2 > frame.Queries.size())
+		{
+			const size_t oldSize = frame.Queries.size();
+			const size_t newSize = oldSize ? oldSize * 2 : 16;
+			frame.Queries.resize(newSize);
+			frame.Passes.resize(newSize / 2);
+			glGenQueries(newSize - oldSize, &frame.Queries[oldSize]);
+		}
+
+		const uint32_t query = frame.Used++;
+		frame.Passes[query] = passId;
+		glQueryCounter(frame.Queries[query * 2], GL_TIMESTAMP);
+
+		m_ActivePasses.push_back({ passId, query, Clock::now() });
+	}
+
+	void Profiler::EndPass()
+	{
+		assert(!m_ActivePasses.empty());
+
+		const auto active = m_ActivePasses.back();
+		m_ActivePasses.pop_back();
+
+		auto& frame = m_FrameQueries[m_Frame % FrameLatency];
+		glQueryCounter(frame.Queries[active.Query * 2 + 1], GL_TIMESTAMP);
+
+		const float cpuMs = std::chrono::duration<float, std::milli>(Clock::now() - active.Start).count();
+		Accumulate(m_Passes[active.PassId].Cpu[HistoryIndex(m_Frame)], cpuMs);
+	}
+
+	void Profiler::Resolve()
+	{
+		for (auto& frame : m_FrameQueries)
+		{
+			if (frame.Pending)
+			{
+				Collect(frame, true);
+			}
+		}
+	}
+
+	void Profiler::Collect(FrameQueries& frame, bool wait)
+	{
+		frame.Pending = false;
+
+		if (frame.Used == 0 || m_Frame - frame.Frame >= m_HistoryFrames)
+		{
+			return;
+		}
+
+		// Queries finish in order, if the last one is done all of them are
+		if (!wait)
+		{
+			GLint available = 0;
+			glGetQueryObjectiv(frame.Queries[frame.Used * 2 - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+			{
+				return;
+			}
+		}
+
+		const uint32_t idx = HistoryIndex(frame.Frame);
+		for (uint32_t i = 0; i < frame.Used; i++)
+		{
+			GLuint64 begin, end;
+			glGetQueryObjectui64v(frame.Queries[i * 2], GL_QUERY_RESULT, &begin);
+			glGetQueryObjectui64v(frame.Queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+
+			Accumulate(m_Passes[frame.Passes[i]].Gpu[idx], (end - begin) / 1e6f);
+		}
+	}
+
+	void Profiler::Accumulate(float& dst, float value)
+	{
+		dst = dst < 0.f ? value : dst + value;
+	}
+
+	float Profiler::GetCpuTime(uint32_t passId, uint64_t frame) const
+	{
+		if (passId >= m_Passes.size() || frame == 0 || frame > m_Frame || m_Frame - frame >= m_HistoryFrames)
+		{
+			return -1.f;
+		}
+		return m_Passes[passId].Cpu[HistoryIndex(frame)];
+	}
+
+	float Profiler::GetGpuTime(uint32_t passId, uint64_t frame) const
+	{
+		if (passId >= m_Passes.size() || frame == 0 || frame > m_Frame || m_Frame - frame >= m_HistoryFrames)
+		{
+			return -1.f;
+		}
+		return m_Passes[passId].Gpu[HistoryIndex(frame)];
+	}
+
+	bool Profiler::WriteCsv(const std::string& filepath) const
+	{
+		std::ofstream file(filepath, std::ios::out | std::ios::trunc);
+
+		if (!file.is_open())
+		{
+			std::cerr << "Error opening file " << filepath << "\n";
+			return false;
+		}
+
+		file << "frame,pass,cpu_ms,gpu_ms\n";
+		file << std::fixed << std::setprecision(6);
+
+		const uint64_t first = m_Frame >= m_HistoryFrames ? m_Frame - m_HistoryFrames + 1 : 1;
+		for (uint64_t frame = first; frame <= m_Frame; frame++)
+		{
+			const uint32_t idx = HistoryIndex(frame);
+			for (const auto& pass : m_Passes)
+			{
+				if (pass.Cpu[idx] < 0.f)
+				{
+					continue;
+				}
+
+				file << frame << "," << pass.Name << "," << pass.Cpu[idx] << ",";
+				if (pass.Gpu[idx] >= 0.f)
+				{
+					file << pass.Gpu[idx];
+				}
+				file << "\n";
+			}
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+#include <glad/glad.h>
+
+// CPU and GPU timings of named passes for the last N frames
+// GPU times come from GL_TIMESTAMP query pairs, every frame gets its own set of queries
+// and they're read back FrameLatency frames later so collecting never waits on the GPU.
+// Passes can nest, the same pass can run multiple times per frame (times are summed).
+
+namespace Gl
+{
+	class Profiler
+	{
+	public:
+		static constexpr uint32_t FrameLatency = 3;
+
+		Profiler(uint32_t historyFrames = 256);
+		~Profiler();
+
+		Profiler(const Profiler&) = delete;
+		Profiler& operator=(const Profiler&) = delete;
+
+		// Look up the id once and use it in the frame loop
+		uint32_t RegisterPass(const std::string& name);
+
+		void BeginFrame();
+		void EndFrame();
+
+		void BeginPass(uint32_t passId);
+		void EndPass();
+
+		// Blocks until all issued queries are available, meant for shutdown
+		void Resolve();
+
+		// A negative value means the pass didn't run (or the GPU result was lost) in that frame
+		float GetCpuTime(uint32_t passId, uint64_t frame) const;
+		float GetGpuTime(uint32_t passId, uint64_t frame) const;
+		uint64_t GetFrame() const { return m_Frame; }
+
+		bool WriteCsv(const std::string& filepath) const;
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		struct PassHistory
+		{
+			std::string Name;
+			std::vector<float> Cpu;
+			std::vector<float> Gpu;
+		};
+
+		struct ActivePass
+		{
+			uint32_t PassId;
+			uint32_t Query;
+			Clock::time_point Start;
+		};
+
+		struct FrameQueries
+		{
+			uint64_t Frame{ 0 };
+			bool Pending{ false };
+			uint32_t Used{ 0 };
+			std::vector<GLuint> Queries; // begin/end timestamp pairs
+			std::vector<uint32_t> Passes; // pass id of every pair
+		};
+
+		uint32_t HistoryIndex(uint64_t frame) const { return frame % m_HistoryFrames; }
+		void Collect(FrameQueries& frame, bool wait);
+		static void Accumulate(float& dst, float value);
+
+		uint32_t m_HistoryFrames;
+		uint64_t m_Frame{ 0 };
+		std::vector<PassHistory> m_Passes;
+		std::unordered_map<std::string, uint32_t> m_PassIds;
+		std::vector<ActivePass> m_ActivePasses;
+		std::array<FrameQueries, FrameLatency> m_FrameQueries;
+	};
+
+	// Times everything issued during the scope
+	class ProfileScope
+	{
+	public:
+		ProfileScope(Profiler& profiler, uint32_t passId)
+			:
+			m_Profiler(profiler)
+		{
+			m_Profiler.BeginPass(passId);
+		}
+
+		~ProfileScope()
+		{
+			m_Profiler.EndPass();
+		}
+	private:
+		Profiler& m_Profiler;
+	};
+}
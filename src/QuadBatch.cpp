@@ -0,0 +1,283 @@
+#include "QuadBatch.h"
+
+#include <cmath>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+
+#include "StateCache.h"
+#include "VertexEncoding.h"
+
+const Gl::BufferLayout QuadBatch::Layout({
+	{ Gl::ShaderDataType::Float2, "position" },
+	{ Gl::ShaderDataType::Float2, "uv" },
+	{ Gl::ShaderDataType::UByte4, "color", true }
+});
+
+namespace
+{
+	constexpr size_t QuadSize = 4 * sizeof(QuadVertex);
+}
+
+QuadBatch::QuadBatch(uint32_t maxQuads, uint32_t frameQuads)
+	:
+	m_MaxQuads(maxQuads),
+	m_Stream(Gl::StreamBuffer::Create(static_cast<size_t>(frameQuads) * QuadSize)),
+	m_OverflowBuffer(Gl::VertexBuffer::Create(Layout)),
+	m_VertexArray(std::make_unique<Gl::VertexArray>()),
+	m_IndexBuffer(Gl::IndexBuffer::Create()),
+	m_White(std::make_unique<Gl::Texture2D>(1, 1, GL_RGBA8, 1))
+{
+	assert(maxQuads > 0 && frameQuads > 0);
+
+	// Every quad is two triangles over its own four vertices, the pattern never changes
+	std::vector<uint32_t> indices(static_cast<size_t>(maxQuads) * 6);
+	for (uint32_t quad = 0; quad < maxQuads; quad++)
+	{
+		const uint32_t base = quad * 4;
+		uint32_t* index = &indices[static_cast<size_t>(quad) * 6];
+		index[0] = base;
+		index[1] = base + 1;
+		index[2] = base + 2;
+		index[3] = base + 2;
+		index[4] = base + 3;
+		index[5] = base;
+	}
+	m_IndexBuffer->SetData(indices.data(), indices.size());
+
+	m_OverflowBuffer->EnsureCapacity(static_cast<size_t>(maxQuads) * QuadSize);
+	m_VertexArray->AddVertexBuffer(m_OverflowBuffer);
+	m_VertexArray->SetIndexBuffer(m_IndexBuffer);
+
+	const uint32_t white = 0xffffffff;
+	m_White->SetData(&white);
+	m_Texture = m_White->GetID();
+}
+
+QuadBatch::~QuadBatch() = default;
+
+void QuadBatch::SetShader(const std::shared_ptr<Gl::Shader>& shader)
+{
+	if (shader == m_Shader)
+	{
+		return;
+	}
+
+	if (m_QuadCount > 0)
+	{
+		Flush();
+		m_Stats.ShaderFlushes++;
+	}
+	m_Shader = shader;
+}
+
+void QuadBatch::Begin()
+{
+	m_Stream->BeginFrame();
+
+	m_Stats = {};
+	m_Allocation = {};
+	m_Vertices = nullptr;
+	m_QuadCount = 0;
+	m_Capacity = 0;
+	m_Overflowing = false;
+}
+
+void QuadBatch::End()
+{
+	Flush();
+	m_Stream->EndFrame();
+
+	m_LastStats = m_Stats;
+}
+
+void QuadBatch::DrawQuad(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color)
+{
+	DrawQuad({ position, position + glm::vec2(size.x, 0.f), position + size, position + glm::vec2(0.f, size.y) },
+		glm::vec4(0.f, 0.f, 1.f, 1.f), PackUnorm4x8(color), 0);
+}
+
+void QuadBatch::DrawQuad(const glm::vec2& position, const glm::vec2& size, const std::shared_ptr<Gl::Texture2D>& texture, const glm::vec4& tint, const glm::vec4& uvRect)
+{
+	DrawQuad({ position, position + glm::vec2(size.x, 0.f), position + size, position + glm::vec2(0.f, size.y) },
+		uvRect, PackUnorm4x8(tint), texture->GetID());
+}
+
+void QuadBatch::DrawQuad(const glm::vec2& position, const glm::vec2& size, const Gl::TextureHandle& texture, const glm::vec4& tint, const glm::vec4& uvRect)
+{
+	DrawQuad({ position, position + glm::vec2(size.x, 0.f), position + size, position + glm::vec2(0.f, size.y) },
+		uvRect, PackUnorm4x8(tint), texture->GetID());
+}
+
+void QuadBatch::DrawRotatedQuad(const glm::vec2& center, const glm::vec2& size, float rotation, const glm::vec4& color)
+{
+	DrawQuad(GetRotatedCorners(center, size, rotation), glm::vec4(0.f, 0.f, 1.f, 1.f), PackUnorm4x8(color), 0);
+}
+
+void QuadBatch::DrawQuad(const std::array<glm::vec2, 4>& corners, const glm::vec4& uvRect, uint32_t color, GLuint texture)
+{
+	SetTexture(texture);
+
+	if (m_QuadCount == m_Capacity)
+	{
+		Reserve();
+	}
+
+	WriteQuad(m_Vertices + static_cast<size_t>(m_QuadCount) * 4, corners, uvRect, color);
+
+	m_QuadCount++;
+	m_Stats.Quads++;
+}
+
+void QuadBatch::DrawQuads(const QuadVertex* vertices, uint32_t count, GLuint texture)
+{
+	SetTexture(texture);
+
+	while (count > 0)
+	{
+		if (m_QuadCount == m_Capacity)
+		{
+			Reserve();
+		}
+
+		const uint32_t quads = std::min(count, m_Capacity - m_QuadCount);
+		std::memcpy(m_Vertices + static_cast<size_t>(m_QuadCount) * 4, vertices, quads * QuadSize);
+
+		m_QuadCount += quads;
+		m_Stats.Quads += quads;
+		vertices += static_cast<size_t>(quads) * 4;
+		count -= quads;
+	}
+}
+
+void QuadBatch::DrawQuads(const QuadVertex* from, const QuadVertex* to, uint32_t count, float t, GLuint texture)
+{
+	SetTexture(texture);
+
+	while (count > 0)
+	{
+		if (m_QuadCount == m_Capacity)
+		{
+			Reserve();
+		}
+
+		const uint32_t quads = std::min(count, m_Capacity - m_QuadCount);
+		QuadVertex* out = m_Vertices + static_cast<size_t>(m_QuadCount) * 4;
+		for (uint32_t i = 0; i < quads * 4; i++)
+		{
+			out[i] = { from[i].Position + (to[i].Position - from[i].Position) * t, to[i].Uv, to[i].Color };
+		}
+
+		m_QuadCount += quads;
+		m_Stats.Quads += quads;
+		from += static_cast<size_t>(quads) * 4;
+		to += static_cast<size_t>(quads) * 4;
+		count -= quads;
+	}
+}
+
+std::array<glm::vec2, 4> QuadBatch::GetRotatedCorners(const glm::vec2& center, const glm::vec2& size, float rotation)
+{
+	const float c = std::cos(rotation);
+	const float s = std::sin(rotation);
+	const glm::vec2 x = glm::vec2(c, s) * (size.x * 0.5f);
+	const glm::vec2 y = glm::vec2(-s, c) * (size.y * 0.5f);
+
+	return { center - x - y, center + x - y, center + x + y, center - x + y };
+}
+
+void QuadBatch::WriteQuad(QuadVertex* out, const std::array<glm::vec2, 4>& corners, const glm::vec4& uvRect, uint32_t color)
+{
+	out[0] = { corners[0], { uvRect.x, uvRect.y }, color };
+	out[1] = { corners[1], { uvRect.z, uvRect.y }, color };
+	out[2] = { corners[2], { uvRect.z, uvRect.w }, color };
+	out[3] = { corners[3], { uvRect.x, uvRect.w }, color };
+}
+
+void QuadBatch::SetTexture(GLuint texture)
+{
+	if (texture == 0)
+	{
+		texture = m_White->GetID();
+	}
+
+	if (texture != m_Texture)
+	{
+		if (m_QuadCount > 0)
+		{
+			Flush();
+			m_Stats.TextureFlushes++;
+		}
+		m_Texture = texture;
+	}
+}
+
+void QuadBatch::Reserve()
+{
+	if (m_QuadCount > 0)
+	{
+		Flush();
+		m_Stats.CapacityFlushes++;
+	}
+
+	if (!m_Overflowing)
+	{
+		const uint32_t quads = std::min<size_t>(m_MaxQuads, m_Stream->GetAvailable() / QuadSize);
+		if (quads > 0)
+		{
+			m_Allocation = m_Stream->Allocate(quads * QuadSize);
+			m_Vertices = static_cast<QuadVertex*>(m_Allocation.Data);
+			m_Capacity = quads;
+			return;
+		}
+
+		static bool warned = false;
+		if (!warned)
+		{
+			std::cerr << "Quad batch stream region is full, the rest of the frame goes through a fallback buffer\n";
+			warned = true;
+		}
+		m_Overflowing = true;
+	}
+
+	m_Overflow.resize(static_cast<size_t>(m_MaxQuads) * 4);
+	m_Vertices = m_Overflow.data();
+	m_Capacity = m_MaxQuads;
+}
+
+void QuadBatch::Flush()
+{
+	if (m_QuadCount == 0)
+	{
+		return;
+	}
+	assert(m_Shader);
+
+	if (m_Overflowing)
+	{
+		// Reallocated on every flush so the driver doesn't wait for the previous draw
+		m_OverflowBuffer->SetData(m_Overflow.data(), m_QuadCount * QuadSize);
+		m_VertexArray->SetVertexBufferStorage(0, m_OverflowBuffer->GetID(), 0);
+		m_Stats.OverflowQuads += m_QuadCount;
+	}
+	else
+	{
+		// The unused end of the allocation goes back to the region for the next batch
+		m_Stream->Trim(m_Allocation, m_QuadCount * QuadSize);
+		m_Stream->Commit(m_Allocation);
+		m_VertexArray->SetVertexBufferStorage(0, m_Stream->GetID(), m_Allocation.Offset);
+
+		m_Allocation = {};
+		m_Vertices = nullptr;
+		m_Capacity = 0;
+	}
+
+	m_Shader->Bind();
+	m_VertexArray->Bind();
+	Gl::StateCache::BindTexture(0, m_Texture);
+	glDrawElements(GL_TRIANGLES, m_QuadCount * 6, m_IndexBuffer->GetType(), nullptr);
+
+	m_Stats.DrawCalls++;
+	m_QuadCount = 0;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+#include "Texture2D.h"
+#include "VertexArray.h"
+#include "StreamBuffer.h"
+#include "TextureLoader.h"
+
+// Immediate mode 2D quads (sprites) drawn in as few draw calls as possible
+// Quads are written straight into a StreamBuffer allocation and drawn with an index buffer that
+// holds the two triangle pattern for MaxQuads quads, built once, so no index data is uploaded per
+// frame. A draw is issued when the allocation is full, the texture or the shader changes, or at End.
+// Untextured quads sample a white texture and don't break batches with textured ones.
+// Positions are in clip space like the rest of the scenes, see shaders/quad.vert.
+
+struct QuadVertex
+{
+	glm::vec2 Position;
+	glm::vec2 Uv;
+	uint32_t Color; // rgba8
+};
+
+struct QuadBatchStats
+{
+	uint32_t Quads{ 0 };
+	uint32_t DrawCalls{ 0 };
+	// Why draws were issued, the flush at End isn't counted
+	uint32_t CapacityFlushes{ 0 };
+	uint32_t TextureFlushes{ 0 };
+	uint32_t ShaderFlushes{ 0 };
+	// Quads that went through the fallback buffer because the stream region was full
+	uint32_t OverflowQuads{ 0 };
+};
+
+class QuadBatch
+{
+public:
+	static constexpr uint32_t DefaultMaxQuads = 16384; // 65536 vertices, 16 bit indices
+	static constexpr uint32_t DefaultFrameQuads = 262144;
+
+	static const Gl::BufferLayout Layout;
+
+	// maxQuads per draw, frameQuads is the stream region size (quads per frame before the fallback)
+	QuadBatch(uint32_t maxQuads = DefaultMaxQuads, uint32_t frameQuads = DefaultFrameQuads);
+	~QuadBatch();
+
+	QuadBatch(const QuadBatch&) = delete;
+	QuadBatch& operator=(const QuadBatch&) = delete;
+
+	// Flushes the pending quads if the shader is different
+	void SetShader(const std::shared_ptr<Gl::Shader>& shader);
+
+	// Once per frame, Begin waits only if the GPU is still using the region from StreamBuffer::Regions frames ago
+	void Begin();
+	void End();
+
+	// position is the bottom left corner
+	void DrawQuad(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color);
+	void DrawQuad(const glm::vec2& position, const glm::vec2& size, const std::shared_ptr<Gl::Texture2D>& texture,
+		const glm::vec4& tint = glm::vec4(1.f), const glm::vec4& uvRect = glm::vec4(0.f, 0.f, 1.f, 1.f));
+	// Draws with the asset's fallback until it's loaded
+	void DrawQuad(const glm::vec2& position, const glm::vec2& size, const Gl::TextureHandle& texture,
+		const glm::vec4& tint = glm::vec4(1.f), const glm::vec4& uvRect = glm::vec4(0.f, 0.f, 1.f, 1.f));
+	// Rotated around its center, rotation in radians
+	void DrawRotatedQuad(const glm::vec2& center, const glm::vec2& size, float rotation, const glm::vec4& color);
+
+	// Corners counter clockwise from the bottom left, uvRect is (u0, v0, u1, v1), texture 0 is white
+	void DrawQuad(const std::array<glm::vec2, 4>& corners, const glm::vec4& uvRect, uint32_t color, GLuint texture);
+	// Copies count quads (4 vertices each) built with WriteQuad, e.g. off the render thread
+	void DrawQuads(const QuadVertex* vertices, uint32_t count, GLuint texture = 0);
+	// Same, with the positions blended from the from quads to the to quads by t, uv and color come from to
+	void DrawQuads(const QuadVertex* from, const QuadVertex* to, uint32_t count, float t, GLuint texture = 0);
+
+	// No GL, safe on any thread
+	static std::array<glm::vec2, 4> GetRotatedCorners(const glm::vec2& center, const glm::vec2& size, float rotation);
+	static void WriteQuad(QuadVertex* out, const std::array<glm::vec2, 4>& corners, const glm::vec4& uvRect, uint32_t color);
+
+	// Stats of the last finished frame
+	const QuadBatchStats& GetStats() const { return m_LastStats; }
+	uint32_t GetMaxQuads() const { return m_MaxQuads; }
+private:
+	// Flushes the pending quads if the texture is different
+	void SetTexture(GLuint texture);
+	// Makes room for at least one quad in the current allocation
+	void Reserve();
+	void Flush();
+
+	uint32_t m_MaxQuads;
+
+	std::shared_ptr<Gl::StreamBuffer> m_Stream;
+	Gl::StreamAllocation m_Allocation;
+	QuadVertex* m_Vertices{ nullptr };
+	uint32_t m_QuadCount{ 0 };
+	uint32_t m_Capacity{ 0 }; // quads that fit in the current allocation
+
+	// Used when the stream region runs out in a frame
+	std::shared_ptr<Gl::VertexBuffer> m_OverflowBuffer;
+	std::vector<QuadVertex> m_Overflow;
+	bool m_Overflowing{ false };
+
+	std::unique_ptr<Gl::VertexArray> m_VertexArray;
+	std::shared_ptr<Gl::IndexBuffer> m_IndexBuffer;
+	std::unique_ptr<Gl::Texture2D> m_White;
+
+	std::shared_ptr<Gl::Shader> m_Shader;
+	GLuint m_Texture{ 0 };
+
+	QuadBatchStats m_Stats;
+	QuadBatchStats m_LastStats;
+};
@@ -0,0 +1,198 @@
+#include "RenderQueue.h"
+
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+
+#include "StateCache.h"
+
+RenderQueue::RenderQueue()
+{
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &m_UniformAlignment);
+	glCreateBuffers(1, &m_UniformBuffer);
+}
+
+RenderQueue::~RenderQueue()
+{
+	glDeleteBuffers(1, &m_UniformBuffer);
+	Gl::StateCache::OnBufferDeleted(m_UniformBuffer);
+}
+
+uint64_t RenderQueue::MakeKey(uint8_t layer, GLuint program, GLuint vertexArray, uint32_t depth)
+{
+	// Names past 16 bits would alias other programs/VAOs and split their runs. GL hands out small
+	// sequential names, a scene would need 64k live programs or vertex arrays to get there
+	assert(program <= 0xffff && vertexArray <= 0xffff && depth <= 0xffffff);
+
+	return static_cast<uint64_t>(layer) << 56
+		| static_cast<uint64_t>(program & 0xffff) << 40
+		| static_cast<uint64_t>(vertexArray & 0xffff) << 24
+		| (depth & 0xffffff);
+}
+
+void RenderQueue::Begin()
+{
+	m_Packets.clear();
+	m_UniformData.clear();
+}
+
+void RenderQueue::Submit(const DrawPacket& packet)
+{
+	m_Packets.push_back(packet);
+}
+
+void RenderQueue::SubmitArrays(const Gl::Shader& shader, const DynamicMesh& mesh, uint8_t layer, uint32_t uniformOffset, uint32_t uniformSize)
+{
+	const GLuint program = shader.GetID();
+	const GLuint vertexArray = mesh.GetVertexArrayID();
+
+	Submit({
+		MakeKey(layer, program, vertexArray),
+		program, vertexArray, static_cast<GLenum>(mesh.GetDrawType()),
+		false, GL_UNSIGNED_INT, mesh.GetVertexCount(), 0, 0, 0,
+		1, uniformOffset, uniformSize
+	});
+}
+
+void RenderQueue::SubmitIndexed(const Gl::Shader& shader, const DynamicMesh& mesh, uint8_t layer, uint32_t uniformOffset, uint32_t uniformSize)
+{
+	const GLuint program = shader.GetID();
+	const GLuint vertexArray = mesh.GetVertexArrayID();
+
+	const uint64_t key = MakeKey(layer, program, vertexArray);
+	const auto mode = static_cast<GLenum>(mesh.GetDrawType());
+	const auto& chunks = mesh.GetIndexChunks();
+
+	if (chunks.empty())
+	{
+		Submit({
+			key, program, vertexArray, mode,
+			true, mesh.GetIndexType(), mesh.GetElementCount(), 0, 0, mesh.GetIndexOffset(),
+			1, uniformOffset, uniformSize
+		});
+		return;
+	}
+
+	for (const auto& chunk : chunks)
+	{
+		Submit({
+			key, program, vertexArray, mode,
+			true, mesh.GetIndexType(), chunk.Count, chunk.First, chunk.BaseVertex, mesh.GetIndexOffset(),
+			1, uniformOffset, uniformSize
+		});
+	}
+}
+
+uint32_t RenderQueue::AllocateUniforms(const void* data, uint32_t size)
+{
+	const size_t offset = (m_UniformData.size() + m_UniformAlignment - 1) / m_UniformAlignment * m_UniformAlignment;
+
+	m_UniformData.resize(offset + size);
+	std::memcpy(m_UniformData.data() + offset, data, size);
+
+	return offset;
+}
+
+// LSD radix sort over 8 bit digits, passes where every key has the same digit are skipped
+// so keys that only use the upper bits (layer/program/VAO) sort in 3-4 passes
+void RenderQueue::Sort()
+{
+	const size_t count = m_Keys.size();
+	m_SortBuffer.resize(count);
+
+	for (uint32_t shift = 0; shift < 64; shift += 8)
+	{
+		std::array<uint32_t, 256> histogram{};
+		for (const auto& key : m_Keys)
+		{
+			histogram[(key.first >> shift) & 0xff]++;
+		}
+
+		if (histogram[(m_Keys[0].first >> shift) & 0xff] == count)
+		{
+			continue;
+		}
+
+		uint32_t sum = 0;
+		for (auto& bucket : histogram)
+		{
+			const uint32_t bucketCount = bucket;
+			bucket = sum;
+			sum += bucketCount;
+		}
+
+		for (const auto& key : m_Keys)
+		{
+			m_SortBuffer[histogram[(key.first >> shift) & 0xff]++] = key;
+		}
+
+		m_Keys.swap(m_SortBuffer);
+	}
+}
+
+void RenderQueue::End()
+{
+	m_Stats = {};
+	m_Stats.Packets = m_Packets.size();
+
+	if (m_Packets.empty())
+	{
+		return;
+	}
+
+	m_Keys.resize(m_Packets.size());
+	for (uint32_t i = 0; i < m_Packets.size(); i++)
+	{
+		m_Keys[i] = { m_Packets[i].Key, i };
+	}
+	Sort();
+
+	if (!m_UniformData.empty())
+	{
+		if (m_UniformData.size() > m_UniformCapacity)
+		{
+			m_UniformCapacity = std::max(m_UniformData.size(), m_UniformCapacity * 2);
+			glNamedBufferData(m_UniformBuffer, m_UniformCapacity, nullptr, GL_STREAM_DRAW);
+		}
+		glNamedBufferSubData(m_UniformBuffer, 0, m_UniformData.size(), m_UniformData.data());
+	}
+
+	GLuint program = 0;
+	GLuint vertexArray = 0;
+	bool first = true;
+
+	for (const auto& key : m_Keys)
+	{
+		const auto& packet = m_Packets[key.second];
+
+		if (first || packet.Program != program)
+		{
+			Gl::StateCache::UseProgram(packet.Program);
+			program = packet.Program;
+			m_Stats.ProgramSwitches++;
+		}
+		if (first || packet.VertexArray != vertexArray)
+		{
+			Gl::StateCache::BindVertexArray(packet.VertexArray);
+			vertexArray = packet.VertexArray;
+			m_Stats.VertexArraySwitches++;
+		}
+		first = false;
+
+		if (packet.UniformSize)
+		{
+			glBindBufferRange(GL_UNIFORM_BUFFER, UniformBinding, m_UniformBuffer, packet.UniformOffset, packet.UniformSize);
+		}
+
+		if (packet.Indexed)
+		{
+			const auto* offset = reinterpret_cast<const void*>(packet.IndexOffset + packet.First * Gl::IndexBuffer::TypeSize(packet.IndexType));
+			glDrawElementsInstancedBaseVertex(packet.Mode, packet.Count, packet.IndexType, offset, packet.InstanceCount, packet.BaseVertex);
+		}
+		else
+		{
+			glDrawArraysInstanced(packet.Mode, packet.First, packet.Count, packet.InstanceCount);
+		}
+	}
+}
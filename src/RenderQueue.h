@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+#include "Shader.h"
+#include "DynamicMesh.h"
+
+// Draws collected during a frame and issued in sort key order
+// The default key puts the layer first, then the program and the VAO, so a frame pays one program
+// switch per program (per layer) no matter in which order the scene submitted its meshes.
+// Per draw uniforms live in a uniform block, the data is copied into a per frame buffer and the
+// packet's range is bound at UniformBinding before the draw.
+
+struct DrawPacket
+{
+	uint64_t Key;
+	GLuint Program;
+	GLuint VertexArray;
+	GLenum Mode;
+	bool Indexed;
+	GLenum IndexType;
+	uint32_t Count;
+	uint32_t First; // first index when indexed, first vertex otherwise
+	int32_t BaseVertex;
+	size_t IndexOffset; // byte offset of the index buffer data
+	uint32_t InstanceCount;
+	uint32_t UniformOffset;
+	uint32_t UniformSize; // 0 when the draw has no uniform block
+};
+
+struct RenderQueueStats
+{
+	uint32_t Packets{ 0 };
+	uint32_t ProgramSwitches{ 0 };
+	uint32_t VertexArraySwitches{ 0 };
+};
+
+class RenderQueue
+{
+public:
+	static constexpr GLuint UniformBinding = 0;
+
+	RenderQueue();
+	~RenderQueue();
+
+	RenderQueue(const RenderQueue&) = delete;
+	RenderQueue& operator=(const RenderQueue&) = delete;
+
+	// layer (8 bits) | program (16 bits) | vertex array (16 bits) | depth (24 bits), asserts the names fit
+	static uint64_t MakeKey(uint8_t layer, GLuint program, GLuint vertexArray, uint32_t depth = 0);
+
+	void Begin();
+	void Submit(const DrawPacket& packet);
+	// uniformOffset/Size point at data from AllocateUniforms, size 0 binds no uniform block
+	void SubmitArrays(const Gl::Shader& shader, const DynamicMesh& mesh, uint8_t layer = 0, uint32_t uniformOffset = 0, uint32_t uniformSize = 0);
+	void SubmitIndexed(const Gl::Shader& shader, const DynamicMesh& mesh, uint8_t layer = 0, uint32_t uniformOffset = 0, uint32_t uniformSize = 0);
+	// Copies size bytes of uniform block data for the next packets, returns the offset for DrawPacket::UniformOffset
+	uint32_t AllocateUniforms(const void* data, uint32_t size);
+	// Sorts and issues everything submitted since Begin
+	void End();
+
+	const RenderQueueStats& GetStats() const { return m_Stats; }
+private:
+	void Sort();
+
+	std::vector<DrawPacket> m_Packets;
+	// key and packet index pairs, sorted in place of the packets
+	std::vector<std::pair<uint64_t, uint32_t>> m_Keys;
+	std::vector<std::pair<uint64_t, uint32_t>> m_SortBuffer;
+
+	std::vector<unsigned char> m_UniformData;
+	GLuint m_UniformBuffer{ 0 };
+	size_t m_UniformCapacity{ 0 };
+	GLint m_UniformAlignment{ 256 };
+
+	RenderQueueStats m_Stats;
+};
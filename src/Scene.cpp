@@ -0,0 +1,170 @@
+#include "Scene.h"
+
+#include <cassert>
+
+Scene::Scene()
+	:
+	// Objects mostly move a little every frame, a fifth of their size keeps most moves inside the fat box
+	m_Bvh(0.2f, 0.f)
+{
+}
+
+Scene::ObjectId Scene::Add(const std::shared_ptr<DynamicMesh>& mesh, const std::shared_ptr<Gl::Shader>& shader, const glm::mat4& transform)
+{
+	assert(mesh && shader);
+
+	ObjectId id;
+	if (m_FreeIds.empty())
+	{
+		id = m_Objects.size();
+		m_Objects.emplace_back();
+	}
+	else
+	{
+		id = m_FreeIds.back();
+		m_FreeIds.pop_back();
+	}
+
+	Object& object = m_Objects[id];
+	object.Mesh = mesh;
+	object.Shader = shader;
+	object.Transform = transform;
+	object.Alive = true;
+	m_ObjectCount++;
+
+	Place(id);
+	return id;
+}
+
+void Scene::Remove(ObjectId id)
+{
+	assert(id < m_Objects.size() && m_Objects[id].Alive);
+
+	Unplace(id);
+	m_Objects[id] = Object();
+	m_FreeIds.push_back(id);
+	m_ObjectCount--;
+}
+
+void Scene::SetTransform(ObjectId id, const glm::mat4& transform)
+{
+	assert(id < m_Objects.size() && m_Objects[id].Alive);
+
+	m_Objects[id].Transform = transform;
+	Place(id);
+}
+
+const glm::mat4& Scene::GetTransform(ObjectId id) const
+{
+	return m_Objects[id].Transform;
+}
+
+void Scene::UpdateBounds(ObjectId id)
+{
+	assert(id < m_Objects.size() && m_Objects[id].Alive);
+
+	Place(id);
+}
+
+const Aabb& Scene::GetWorldBounds(ObjectId id) const
+{
+	return m_Objects[id].WorldBounds;
+}
+
+void Scene::Place(ObjectId id)
+{
+	Object& object = m_Objects[id];
+	object.WorldBounds = object.Mesh->GetBounds().Transformed(object.Transform);
+
+	// Not flushed yet or positions that can't be read, drawn every frame
+	if (object.WorldBounds.IsEmpty() || object.WorldBounds.IsInfinite())
+	{
+		if (object.Leaf != DynamicBvh::Null)
+		{
+			m_Bvh.Remove(object.Leaf);
+			object.Leaf = DynamicBvh::Null;
+		}
+		if (object.Unbounded == Null)
+		{
+			object.Unbounded = m_Unbounded.size();
+			m_Unbounded.push_back(id);
+		}
+		return;
+	}
+
+	if (object.Unbounded != Null)
+	{
+		Unplace(id);
+	}
+
+	if (object.Leaf == DynamicBvh::Null)
+	{
+		object.Leaf = m_Bvh.Insert(object.WorldBounds, id);
+	}
+	else
+	{
+		m_Bvh.Move(object.Leaf, object.WorldBounds);
+	}
+}
+
+void Scene::Unplace(ObjectId id)
+{
+	Object& object = m_Objects[id];
+
+	if (object.Leaf != DynamicBvh::Null)
+	{
+		m_Bvh.Remove(object.Leaf);
+		object.Leaf = DynamicBvh::Null;
+	}
+
+	if (object.Unbounded != Null)
+	{
+		// Swap with the last one
+		const ObjectId last = m_Unbounded.back();
+		m_Unbounded[object.Unbounded] = last;
+		m_Objects[last].Unbounded = object.Unbounded;
+		m_Unbounded.pop_back();
+		object.Unbounded = Null;
+	}
+}
+
+void Scene::Submit(RenderQueue& queue, const glm::mat4& viewProjection, uint8_t layer)
+{
+	m_Stats = {};
+	m_Stats.Objects = m_ObjectCount;
+
+	const Frustum frustum = Frustum::FromMatrix(viewProjection);
+
+	m_Stats.NodesTested = m_Bvh.Query(frustum, [&](uint32_t id)
+	{
+		// The tree holds fattened boxes, the exact one culls what only the margin overlaps
+		const Object& object = m_Objects[id];
+		if (frustum.Classify(object.WorldBounds) != Containment::Outside)
+		{
+			SubmitObject(queue, object, viewProjection, layer);
+		}
+	});
+
+	for (const ObjectId id : m_Unbounded)
+	{
+		SubmitObject(queue, m_Objects[id], viewProjection, layer);
+	}
+
+	m_Stats.Culled = m_Stats.Objects - m_Stats.Visible;
+}
+
+void Scene::SubmitObject(RenderQueue& queue, const Object& object, const glm::mat4& viewProjection, uint8_t layer)
+{
+	const SceneObjectUniforms uniforms{ viewProjection * object.Transform };
+	const uint32_t offset = queue.AllocateUniforms(&uniforms, sizeof(uniforms));
+
+	if (object.Mesh->GetElementCount() > 0)
+	{
+		queue.SubmitIndexed(*object.Shader, *object.Mesh, layer, offset, sizeof(uniforms));
+	}
+	else
+	{
+		queue.SubmitArrays(*object.Shader, *object.Mesh, layer, offset, sizeof(uniforms));
+	}
+	m_Stats.Visible++;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+#include "DynamicMesh.h"
+#include "RenderQueue.h"
+#include "DynamicBvh.h"
+#include "Bounds.h"
+
+// Meshes placed in the world, culled against the view before anything is submitted
+// Every object's world box (the mesh bounds from its last flush, transformed) sits in a dynamic BVH,
+// so a frame only walks the part of the tree that overlaps the view and moving an object refits its
+// ancestors instead of rebuilding anything. Meshes without usable bounds are never culled.
+// Visible objects go to a RenderQueue with their model view projection in the per draw uniform
+// block (binding RenderQueue::UniformBinding, see shaders/scene.vert).
+
+struct SceneStats
+{
+	uint32_t Objects{ 0 };
+	uint32_t Visible{ 0 };
+	uint32_t Culled{ 0 };
+	uint32_t NodesTested{ 0 };
+};
+
+// Per draw uniform block, std140 layout
+struct SceneObjectUniforms
+{
+	glm::mat4 ModelViewProjection;
+};
+
+class Scene
+{
+public:
+	using ObjectId = uint32_t;
+
+	Scene();
+
+	// The mesh has to be flushed, its bounds are read here and in UpdateBounds
+	ObjectId Add(const std::shared_ptr<DynamicMesh>& mesh, const std::shared_ptr<Gl::Shader>& shader, const glm::mat4& transform = glm::mat4(1.f));
+	void Remove(ObjectId id);
+
+	void SetTransform(ObjectId id, const glm::mat4& transform);
+	const glm::mat4& GetTransform(ObjectId id) const;
+	// Re-reads the mesh bounds, call after flushing changed geometry
+	void UpdateBounds(ObjectId id);
+	const Aabb& GetWorldBounds(ObjectId id) const;
+
+	// Submits the objects inside the view, call between RenderQueue::Begin and End
+	void Submit(RenderQueue& queue, const glm::mat4& viewProjection, uint8_t layer = 0);
+
+	uint32_t GetObjectCount() const { return m_ObjectCount; }
+	const DynamicBvh& GetBvh() const { return m_Bvh; }
+	// Counts of the last Submit
+	const SceneStats& GetStats() const { return m_Stats; }
+private:
+	static constexpr uint32_t Null = ~0u;
+
+	struct Object
+	{
+		std::shared_ptr<DynamicMesh> Mesh;
+		std::shared_ptr<Gl::Shader> Shader;
+		glm::mat4 Transform{ 1.f };
+		Aabb WorldBounds;
+		int32_t Leaf{ DynamicBvh::Null };
+		uint32_t Unbounded{ Null }; // index in m_Unbounded
+		bool Alive{ false };
+	};
+
+	// Moves the object between the tree and the unbounded list as needed
+	void Place(ObjectId id);
+	void Unplace(ObjectId id);
+	void SubmitObject(RenderQueue& queue, const Object& object, const glm::mat4& viewProjection, uint8_t layer);
+
+	std::vector<Object> m_Objects;
+	std::vector<ObjectId> m_FreeIds;
+	std::vector<ObjectId> m_Unbounded;
+	uint32_t m_ObjectCount{ 0 };
+
+	DynamicBvh m_Bvh;
+	SceneStats m_Stats;
+};
@@ -1,8 +1,15 @@
 #include "Shader.h"
 #include "Utils.h"
+#include "ShaderCache.h"
+#include "Capabilities.h"
+#include "StateCache.h"
 
 #include "glm/gtc/type_ptr.hpp"
 
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
 namespace Gl
 {
 	Shader Shader::FromFiles(const std::string& vertFile, const std::string& fragFile)
@@ -29,9 +36,18 @@ namespace Gl
 		return std::make_unique<Shader>(vert, frag);
 	}
 
+	std::shared_ptr<Shader> Shader::RefFromFilesAsync(const std::string& vertFile, const std::string& fragFile)
+	{
+		const std::string vert = ReadFile(vertFile);
+		const std::string frag = ReadFile(fragFile);
+
+		auto ref = std::make_shared<Shader>();
+		ref->CompileAsync(vert, frag);
+		return ref;
+	}
+
 	Shader::Shader()
 	{
-		std::cerr << "Creating a base shader" << "\n";
 	}
 
 	Shader::Shader(const std::string& vert, const std::string& frag)
@@ -46,6 +62,30 @@ namespace Gl
 
 	void Shader::Compile(const std::string& vert, const std::string& frag)
 	{
+		CompileAsync(vert, frag);
+
+		if (!FinishCompile())
+		{
+			assert(false);
+		}
+	}
+
+	void Shader::CompileAsync(const std::string& vert, const std::string& frag)
+	{
+		m_UseCache = ShaderCache::IsEnabled();
+		m_CacheKey = m_UseCache ? ShaderCache::Key(vert, frag) : 0;
+
+		if (m_UseCache && (m_Program = ShaderCache::Load(m_CacheKey)))
+		{
+			m_FromBinaryCache = true;
+			m_Status = Status::Ready;
+			ReflectUniforms();
+			return;
+		}
+
+		m_FromBinaryCache = false;
+		m_Status = Status::Compiling;
+
 		m_VertexShader = __CompileShader(GL_VERTEX_SHADER, vert.c_str());
 		m_FragmentShader = __CompileShader(GL_FRAGMENT_SHADER, frag.c_str());
 
@@ -53,89 +93,337 @@ namespace Gl
 		glAttachShader(m_Program, m_VertexShader);
 		glAttachShader(m_Program, m_FragmentShader);
 
+		if (m_UseCache)
+		{
+			glProgramParameteri(m_Program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		}
+
 		glLinkProgram(m_Program);
+	}
+
+	bool Shader::Poll()
+	{
+		if (m_Status != Status::Compiling)
+		{
+			return m_Status == Status::Ready;
+		}
+
+		if (SupportsParallelCompile())
+		{
+			GLint isComplete = 0;
+			glGetProgramiv(m_Program, GL_COMPLETION_STATUS_KHR, &isComplete);
+
+			if (!isComplete)
+			{
+				return false;
+			}
+		}
+
+		return FinishCompile();
+	}
+
+	bool Shader::Wait()
+	{
+		return FinishCompile();
+	}
+
+	bool Shader::SupportsParallelCompile()
+	{
+		static const bool supported =
+			HasExtension("GL_KHR_parallel_shader_compile") || HasExtension("GL_ARB_parallel_shader_compile");
+		return supported;
+	}
+
+	bool Shader::FinishCompile()
+	{
+		if (m_Status != Status::Compiling)
+		{
+			return m_Status == Status::Ready;
+		}
 
 		GLint isLinked = 0;
 		glGetProgramiv(m_Program, GL_LINK_STATUS, &isLinked);
 
 		if (!isLinked)
 		{
+			__PrintShaderLog(m_VertexShader, GL_VERTEX_SHADER);
+			__PrintShaderLog(m_FragmentShader, GL_FRAGMENT_SHADER);
+
 			GLint maxLen = 0;
 
 			glGetProgramiv(m_Program, GL_INFO_LOG_LENGTH, &maxLen);
-			std::vector<GLchar> infoLog(maxLen);
+			std::vector<GLchar> infoLog(maxLen + 1);
 			glGetProgramInfoLog(m_Program, maxLen, &maxLen, &infoLog[0]);
 
 			glDeleteProgram(m_Program);
+			StateCache::OnProgramDeleted(m_Program);
 			glDeleteShader(m_VertexShader);
 			glDeleteShader(m_FragmentShader);
+			m_Program = 0;
 
 			std::cerr << infoLog.data() << "\n";
-			assert(false);
+			m_Status = Status::Failed;
+			return false;
 		}
 
 		glDetachShader(m_Program, m_VertexShader);
 		glDetachShader(m_Program, m_FragmentShader);
 		glDeleteShader(m_VertexShader);
 		glDeleteShader(m_FragmentShader);
+
+		if (m_UseCache)
+		{
+			ShaderCache::Store(m_CacheKey, m_Program);
+		}
+
+		ReflectUniforms();
+		m_Status = Status::Ready;
+		return true;
+	}
+
+	void Shader::ReflectUniforms()
+	{
+		m_Uniforms.clear();
+		m_UniformSlots.clear();
+
+		GLint count = 0, maxNameLength = 0;
+		glGetProgramiv(m_Program, GL_ACTIVE_UNIFORMS, &count);
+		glGetProgramiv(m_Program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+		std::vector<GLchar> nameBuffer(maxNameLength + 1);
+		m_Uniforms.reserve(count);
+
+		for (GLint i = 0; i < count; i++)
+		{
+			GLsizei length = 0;
+			GLint size = 0;
+			GLenum type = 0;
+			glGetActiveUniform(m_Program, i, nameBuffer.size(), &length, &size, &type, nameBuffer.data());
+
+			std::string name(nameBuffer.data(), length);
+			const GLint location = glGetUniformLocation(m_Program, name.c_str());
+
+			// Uniform block members don't have a location
+			if (location < 0)
+			{
+				continue;
+			}
+
+			// Arrays are reported as "name[0]", register them by the base name
+			const auto bracket = name.find('[');
+			if (bracket != std::string::npos)
+			{
+				name.erase(bracket);
+			}
+
+			UniformInfo info;
+			info.Hash = std::hash<std::string_view>{}(name);
+			info.Name = std::move(name);
+			info.Location = location;
+			info.Type = type;
+			info.Size = size;
+			m_Uniforms.push_back(std::move(info));
+		}
+
+		BuildUniformSlots();
 	}
 
+	void Shader::BuildUniformSlots()
+	{
+		size_t slots = 4;
+		while (slots < m_Uniforms.size() * 2)
+		{
+			slots *= 2;
+		}
+		m_UniformSlots.assign(slots, -1);
+
+		const size_t mask = slots - 1;
+		for (size_t i = 0; i < m_Uniforms.size(); i++)
+		{
+			size_t slot = m_Uniforms[i].Hash & mask;
+			while (m_UniformSlots[slot] >= 0)
+			{
+				slot = (slot + 1) & mask;
+			}
+			m_UniformSlots[slot] = i;
+		}
+	}
+
+	int32_t Shader::FindUniform(std::string_view name) const
+	{
+		if (m_UniformSlots.empty())
+		{
+			return -1;
+		}
+
+		const size_t hash = std::hash<std::string_view>{}(name);
+		const size_t mask = m_UniformSlots.size() - 1;
+
+		for (size_t slot = hash & mask; m_UniformSlots[slot] >= 0; slot = (slot + 1) & mask)
+		{
+			const auto& uniform = m_Uniforms[m_UniformSlots[slot]];
+			if (uniform.Hash == hash && uniform.Name == name)
+			{
+				return m_UniformSlots[slot];
+			}
+		}
+
+		return -1;
+	}
 
 	void Shader::SetInt(const std::string& name, int v) const
 	{
-		GLint loc = glGetUniformLocation(m_Program, name.c_str());
-		glUniform1i(loc, v);
+		SetByName(name, v);
 	}
 
 	void Shader::SetFloat(const std::string& name, float v) const
 	{
-		GLint loc = glGetUniformLocation(m_Program, name.c_str());
-		glUniform1f(loc, v);
+		SetByName(name, v);
 	}
 
 	void Shader::SetFloat2(const std::string& name, const glm::vec2& v) const
 	{
-		GLint loc = glGetUniformLocation(m_Program, name.c_str());
-		glUniform2f(loc, v.x, v.y);
+		SetByName(name, v);
 	}
 
 	void Shader::SetFloat3(const std::string& name, const glm::vec3& v) const
 	{
-		GLint loc = glGetUniformLocation(m_Program, name.c_str());
-		glUniform3f(loc, v.x, v.y, v.z);
+		SetByName(name, v);
 	}
 
 	void Shader::SetFloat4(const std::string& name, const glm::vec4& v) const
 	{
-		GLint loc = glGetUniformLocation(m_Program, name.c_str());
-		glUniform4f(loc, v.x, v.y, v.z, v.w);
+		SetByName(name, v);
 	}
 
 	void Shader::SetMat3(const std::string& name, const glm::mat3& v) const
 	{
-		GLint loc = glGetUniformLocation(m_Program, name.c_str());
-		glUniformMatrix3fv(loc, 1, GL_FALSE, glm::value_ptr(v));
+		SetByName(name, v);
 	}
 
-
 	void Shader::SetMat4(const std::string& name, const glm::mat4& v) const
 	{
-		GLint loc = glGetUniformLocation(m_Program, name.c_str());
-		glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(v));
+		SetByName(name, v);
+	}
+
+	void Shader::Upload(GLint loc, int v) const
+	{
+		glProgramUniform1i(m_Program, loc, v);
+	}
+
+	void Shader::Upload(GLint loc, float v) const
+	{
+		glProgramUniform1f(m_Program, loc, v);
+	}
+
+	void Shader::Upload(GLint loc, const glm::vec2& v) const
+	{
+		glProgramUniform2f(m_Program, loc, v.x, v.y);
+	}
+
+	void Shader::Upload(GLint loc, const glm::vec3& v) const
+	{
+		glProgramUniform3f(m_Program, loc, v.x, v.y, v.z);
+	}
+
+	void Shader::Upload(GLint loc, const glm::vec4& v) const
+	{
+		glProgramUniform4f(m_Program, loc, v.x, v.y, v.z, v.w);
+	}
+
+	void Shader::Upload(GLint loc, const glm::mat3& v) const
+	{
+		glProgramUniformMatrix3fv(m_Program, loc, 1, GL_FALSE, glm::value_ptr(v));
+	}
+
+	void Shader::Upload(GLint loc, const glm::mat4& v) const
+	{
+		glProgramUniformMatrix4fv(m_Program, loc, 1, GL_FALSE, glm::value_ptr(v));
+	}
+
+	void Shader::UploadValue(const UniformInfo& uniform) const
+	{
+		const auto get = [&uniform](auto v)
+		{
+			std::memcpy(&v, uniform.Value, sizeof(v));
+			return v;
+		};
+
+		switch (uniform.Type)
+		{
+		case GL_FLOAT: Upload(uniform.Location, get(float())); break;
+		case GL_FLOAT_VEC2: Upload(uniform.Location, get(glm::vec2())); break;
+		case GL_FLOAT_VEC3: Upload(uniform.Location, get(glm::vec3())); break;
+		case GL_FLOAT_VEC4: Upload(uniform.Location, get(glm::vec4())); break;
+		case GL_FLOAT_MAT3: Upload(uniform.Location, get(glm::mat3())); break;
+		case GL_FLOAT_MAT4: Upload(uniform.Location, get(glm::mat4())); break;
+		default: Upload(uniform.Location, get(int())); break;
+		}
 	}
 
 	void Shader::Bind()
 	{
-		glUseProgram(m_Program);
+		StateCache::UseProgram(m_Program);
 	}
 
 	void Shader::Unbind()
 	{
-		glUseProgram(0);
+		StateCache::UseProgram(0);
+	}
+
+	void Shader::ReplaceProgram(Shader& other)
+	{
+		assert(other.IsReady());
+
+		std::swap(m_Program, other.m_Program);
+		m_FromBinaryCache = other.m_FromBinaryCache;
+		m_Status = Status::Ready;
+
+		// Keep the indices the handles point to, only refresh what the new program reports
+		std::vector<UniformInfo> uniforms = m_Uniforms;
+		for (auto& uniform : uniforms)
+		{
+			const int32_t idx = other.FindUniform(uniform.Name);
+
+			if (idx >= 0 && other.m_Uniforms[idx].Type == uniform.Type)
+			{
+				uniform.Location = other.m_Uniforms[idx].Location;
+				uniform.Size = other.m_Uniforms[idx].Size;
+
+				// The new program starts with defaults, values set once at startup would be lost
+				if (uniform.HasValue)
+				{
+					UploadValue(uniform);
+				}
+			}
+			else
+			{
+				uniform.Location = -1;
+				uniform.HasValue = false;
+			}
+		}
+		for (const auto& uniform : other.m_Uniforms)
+		{
+			if (FindUniform(uniform.Name) < 0)
+			{
+				uniforms.push_back(uniform);
+			}
+		}
+
+		m_Uniforms = std::move(uniforms);
+		BuildUniformSlots();
 	}
 
 	void Shader::Delete()
 	{
+		if (m_Status == Status::Compiling)
+		{
+			glDeleteShader(m_VertexShader);
+			glDeleteShader(m_FragmentShader);
+		}
 		glDeleteProgram(m_Program);
+		StateCache::OnProgramDeleted(m_Program);
+		m_Program = 0;
+		m_Status = Status::Empty;
 	}
 }
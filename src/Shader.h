@@ -4,22 +4,66 @@
 #include <vector>
 #include <memory>
 #include <cassert>
+#include <cstring>
 #include <iostream>
+#include <string_view>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
 namespace Gl
 {
+	// Handle to a reflected uniform, fetch it once with Shader::GetUniform and reuse it every frame
+	template<typename T>
+	class Uniform
+	{
+	public:
+		Uniform() = default;
+
+		bool IsValid() const { return m_Index >= 0; }
+	private:
+		friend class Shader;
+
+		explicit Uniform(int32_t index)
+			: m_Index(index)
+		{
+		}
+
+		int32_t m_Index{ -1 };
+	};
+
+	struct UniformInfo
+	{
+		std::string Name;
+		size_t Hash;
+		GLint Location;
+		GLenum Type;
+		GLint Size;
+
+		// Last uploaded value, uploads of the same value are skipped
+		bool HasValue{ false };
+		alignas(16) unsigned char Value[64];
+	};
+
 	class Shader
 	{
 	public:
+		enum class Status
+		{
+			Empty,
+			Compiling,
+			Ready,
+			Failed
+		};
+
 		Shader();
 		Shader(const std::string& vert, const std::string& frag);
 
 		static Shader FromFiles(const std::string& vertFile, const std::string& fragFile);
 		static std::shared_ptr<Shader> RefFromFiles(const std::string& vertFile, const std::string& fragFile);
 		static std::unique_ptr<Shader> PtrFromFiles(const std::string& vertFile, const std::string& fragFile);
+		// Returns with the compile in flight, see CompileAsync
+		static std::shared_ptr<Shader> RefFromFilesAsync(const std::string& vertFile, const std::string& fragFile);
 
 		virtual ~Shader();
 
@@ -31,23 +75,154 @@ namespace Gl
 		void SetMat3(const std::string& name, const glm::mat3& m) const;
 		void SetMat4(const std::string& name, const glm::mat4& m) const;
 
+		// Invalid handle if the uniform isn't active or its type doesn't match T
+		template<typename T>
+		Uniform<T> GetUniform(const std::string& name) const
+		{
+			const int32_t idx = FindUniform(name);
+
+			if (idx < 0)
+			{
+				std::cerr << "Uniform " << name << " is not active\n";
+				return Uniform<T>();
+			}
+			if (!IsUniformType<T>(m_Uniforms[idx].Type))
+			{
+				std::cerr << "Uniform " << name << " requested with a mismatching type\n";
+				return Uniform<T>();
+			}
+
+			return Uniform<T>(idx);
+		}
+
+		template<typename T>
+		void Set(Uniform<T> uniform, const T& v) const
+		{
+			if (uniform.IsValid())
+			{
+				SetCached(m_Uniforms[uniform.m_Index], v);
+			}
+		}
+
+		const std::vector<UniformInfo>& GetUniforms() const { return m_Uniforms; }
+
+		bool IsFromBinaryCache() const { return m_FromBinaryCache; }
+
+		// Submits the compile and link without querying any status
+		// With GL_KHR_parallel_shader_compile the driver compiles on its own threads and Poll never blocks,
+		// without it the first Poll waits for the driver to finish.
+		void CompileAsync(const std::string& vert, const std::string& frag);
+		bool Poll();
+		// Blocks until the program is linked, false if it failed
+		bool Wait();
+
+		// Takes over the linked program of other (used for hot reload), uniform handles stay valid
+		// Uniforms that don't exist in the new program become no-ops
+		void ReplaceProgram(Shader& other);
+
+		Status GetStatus() const { return m_Status; }
+		bool IsReady() const { return m_Status == Status::Ready; }
+		// Changes when the program is hot reloaded, don't keep it across frames
+		GLuint GetID() const { return m_Program; }
+
+		static bool SupportsParallelCompile();
+
 		void Bind();
 		void Unbind();
 
 		void Delete();
 	private:
-		GLuint m_Program;
-		GLuint m_VertexShader;
-		GLuint m_FragmentShader;
+		GLuint m_Program{ 0 };
+		GLuint m_VertexShader{ 0 };
+		GLuint m_FragmentShader{ 0 };
+		bool m_FromBinaryCache{ false };
+		Status m_Status{ Status::Empty };
+
+		bool m_UseCache{ false };
+		uint64_t m_CacheKey{ 0 };
+
+		// Reflected active uniforms and an open addressing table (name hash -> index into m_Uniforms)
+		mutable std::vector<UniformInfo> m_Uniforms;
+		std::vector<int32_t> m_UniformSlots;
 
 		void Compile(const std::string& vert, const std::string& frag);
+		bool FinishCompile();
+		void ReflectUniforms();
+		void BuildUniformSlots();
+		int32_t FindUniform(std::string_view name) const;
+
+		// Names that weren't reflected (e.g. array elements past the first) go through glGetUniformLocation
+		template<typename T>
+		void SetByName(const std::string& name, const T& v) const
+		{
+			const int32_t idx = FindUniform(name);
+
+			if (idx >= 0)
+			{
+				SetCached(m_Uniforms[idx], v);
+			}
+			else
+			{
+				Upload(glGetUniformLocation(m_Program, name.c_str()), v);
+			}
+		}
+
+		template<typename T>
+		static bool IsUniformType(GLenum type)
+		{
+			if constexpr (std::is_same_v<T, int>)
+			{
+				return type == GL_INT || type == GL_BOOL ||
+					type == GL_SAMPLER_2D || type == GL_SAMPLER_CUBE || type == GL_SAMPLER_2D_ARRAY;
+			}
+			else if constexpr (std::is_same_v<T, float>) return type == GL_FLOAT;
+			else if constexpr (std::is_same_v<T, glm::vec2>) return type == GL_FLOAT_VEC2;
+			else if constexpr (std::is_same_v<T, glm::vec3>) return type == GL_FLOAT_VEC3;
+			else if constexpr (std::is_same_v<T, glm::vec4>) return type == GL_FLOAT_VEC4;
+			else if constexpr (std::is_same_v<T, glm::mat3>) return type == GL_FLOAT_MAT3;
+			else if constexpr (std::is_same_v<T, glm::mat4>) return type == GL_FLOAT_MAT4;
+			return false;
+		}
+
+		template<typename T>
+		void SetCached(UniformInfo& uniform, const T& v) const
+		{
+			static_assert(sizeof(T) <= sizeof(uniform.Value));
+
+			if (uniform.HasValue && std::memcmp(uniform.Value, &v, sizeof(T)) == 0)
+			{
+				return;
+			}
+
+			std::memcpy(uniform.Value, &v, sizeof(T));
+			uniform.HasValue = true;
+			Upload(uniform.Location, v);
+		}
 
+		// Re-uploads the cached value, for a relinked program
+		void UploadValue(const UniformInfo& uniform) const;
+
+		// Writes to this program whichever one is bound, so the cached values always match it
+		void Upload(GLint loc, int v) const;
+		void Upload(GLint loc, float v) const;
+		void Upload(GLint loc, const glm::vec2& v) const;
+		void Upload(GLint loc, const glm::vec3& v) const;
+		void Upload(GLint loc, const glm::vec4& v) const;
+		void Upload(GLint loc, const glm::mat3& v) const;
+		void Upload(GLint loc, const glm::mat4& v) const;
+
+		// Only issues the compile, the status is checked once the whole program is linked
 		static GLuint __CompileShader(GLenum type, const char* src)
 		{
 			GLuint shader = glCreateShader(type);
 			glShaderSource(shader, 1, &src, nullptr);
 			glCompileShader(shader);
 
+			return shader;
+		}
+
+		static void __PrintShaderLog(GLuint shader, GLenum type)
+		{
 			GLint isCompiled = 0;
 
 			glGetShaderiv(shader, GL_COMPILE_STATUS, &isCompiled);
@@ -60,11 +235,8 @@ namespace Gl
 				std::vector<GLchar> infoLog(maxLength);
 				glGetShaderInfoLog(shader, maxLength, &maxLength, &infoLog[0]);
 
-				std::cerr << ("{0}: {1}", type == GL_VERTEX_SHADER ? "Vertex Shader" : "Fragment Shader") << infoLog.data();
-				assert(false);
+				std::cerr << (type == GL_VERTEX_SHADER ? "Vertex Shader: " : "Fragment Shader: ") << infoLog.data();
 			}
-
-			return shader;
 		}
 		;
 	};
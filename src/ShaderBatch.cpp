@@ -0,0 +1,51 @@
+#include "ShaderBatch.h"
+
+namespace Gl
+{
+	std::shared_ptr<Shader> ShaderBatch::Add(const std::string& vertFile, const std::string& fragFile)
+	{
+		auto shader = Shader::RefFromFilesAsync(vertFile, fragFile);
+		m_Shaders.push_back(shader);
+		return shader;
+	}
+
+	bool ShaderBatch::Poll()
+	{
+		bool done = true;
+
+		for (auto& shader : m_Shaders)
+		{
+			if (shader->GetStatus() == Shader::Status::Compiling)
+			{
+				shader->Poll();
+				done &= shader->GetStatus() != Shader::Status::Compiling;
+			}
+		}
+
+		return done;
+	}
+
+	bool ShaderBatch::Wait()
+	{
+		bool success = true;
+
+		for (auto& shader : m_Shaders)
+		{
+			success &= shader->Wait();
+		}
+
+		return success;
+	}
+
+	size_t ShaderBatch::GetPendingCount() const
+	{
+		size_t count = 0;
+
+		for (const auto& shader : m_Shaders)
+		{
+			count += shader->GetStatus() == Shader::Status::Compiling;
+		}
+
+		return count;
+	}
+}
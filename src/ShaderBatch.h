@@ -0,0 +1,30 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Shader.h"
+
+// Submits every program up front and checks their status only at the end,
+// so the driver can compile them in parallel (GL_KHR_parallel_shader_compile)
+// while the caller keeps doing other work
+
+namespace Gl
+{
+	class ShaderBatch
+	{
+	public:
+		std::shared_ptr<Shader> Add(const std::string& vertFile, const std::string& fragFile);
+
+		// True once every program is done compiling, failed ones included
+		bool Poll();
+		// False if any of the programs failed
+		bool Wait();
+
+		size_t GetPendingCount() const;
+		const std::vector<std::shared_ptr<Shader>>& GetShaders() const { return m_Shaders; }
+	private:
+		std::vector<std::shared_ptr<Shader>> m_Shaders;
+	};
+}
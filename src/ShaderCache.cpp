@@ -0,0 +1,186 @@
+#include "ShaderCache.h"
+
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+
+namespace Gl
+{
+	namespace
+	{
+		constexpr uint32_t CacheMagic = 0x42504c47; // "GLPB"
+		constexpr uint32_t CacheVersion = 1;
+
+		struct CacheHeader
+		{
+			uint32_t Magic;
+			uint32_t Version;
+			uint64_t Key;
+			uint32_t Format;
+			uint32_t Length;
+		};
+
+		uint64_t Fnv1a(uint64_t hash, const void* data, size_t size)
+		{
+			const auto* bytes = static_cast<const unsigned char*>(data);
+			for (size_t i = 0; i < size; i++)
+			{
+				hash ^= bytes[i];
+				hash *= 0x100000001b3ull;
+			}
+			return hash;
+		}
+
+		uint64_t Fnv1a(uint64_t hash, const char* str)
+		{
+			// The terminator is hashed too so "ab" + "c" != "a" + "bc"
+			return Fnv1a(hash, str ? str : "", (str ? std::char_traits<char>::length(str) : 0) + 1);
+		}
+
+		bool SupportsProgramBinaries()
+		{
+			GLint formats = 0;
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+			return formats > 0;
+		}
+	}
+
+	std::string ShaderCache::s_Directory;
+
+	void ShaderCache::SetDirectory(const std::string& directory)
+	{
+		s_Directory = directory;
+
+		if (s_Directory.empty())
+		{
+			return;
+		}
+
+		std::error_code ec;
+		std::filesystem::create_directories(s_Directory, ec);
+		if (ec)
+		{
+			std::cerr << "Cannot create shader cache directory " << s_Directory << ": " << ec.message() << "\n";
+			s_Directory.clear();
+		}
+	}
+
+	bool ShaderCache::IsEnabled()
+	{
+		static const bool supported = SupportsProgramBinaries();
+		return !s_Directory.empty() && supported;
+	}
+
+	uint64_t ShaderCache::Key(const std::string& vert, const std::string& frag)
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
+		hash = Fnv1a(hash, reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
+		hash = Fnv1a(hash, reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+		hash = Fnv1a(hash, reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+		hash = Fnv1a(hash, vert.c_str());
+		hash = Fnv1a(hash, frag.c_str());
+		return hash;
+	}
+
+	std::string ShaderCache::EntryPath(uint64_t key)
+	{
+		static constexpr char hex[] = "0123456789abcdef";
+
+		std::string name(16, '0');
+		for (int i = 15; i >= 0; i--, key >>= 4)
+		{
+			name[i] = hex[key & 0xf];
+		}
+
+		return s_Directory + "/" + name + ".bin";
+	}
+
+	GLuint ShaderCache::Load(uint64_t key)
+	{
+		if (!IsEnabled())
+		{
+			return 0;
+		}
+
+		const auto path = EntryPath(key);
+		std::ifstream file(path, std::ios::in | std::ios::binary);
+		std::error_code ec;
+
+		if (!file.is_open())
+		{
+			return 0;
+		}
+
+		CacheHeader header;
+		file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+		std::vector<char> binary;
+		bool complete = false;
+		if (file && header.Magic == CacheMagic && header.Version == CacheVersion && header.Key == key && header.Length > 0)
+		{
+			binary.resize(header.Length);
+			file.read(binary.data(), binary.size());
+			complete = static_cast<size_t>(file.gcount()) == binary.size();
+		}
+		file.close();
+
+		if (!complete)
+		{
+			std::filesystem::remove(path, ec);
+			return 0;
+		}
+
+		GLuint program = glCreateProgram();
+		glProgramBinary(program, header.Format, binary.data(), binary.size());
+
+		GLint isLinked = 0;
+		glGetProgramiv(program, GL_LINK_STATUS, &isLinked);
+
+		// Driver update or a different GPU, drop the entry and let the caller recompile
+		if (!isLinked)
+		{
+			glDeleteProgram(program);
+			std::filesystem::remove(path, ec);
+			return 0;
+		}
+
+		return program;
+	}
+
+	void ShaderCache::Store(uint64_t key, GLuint program)
+	{
+		if (!IsEnabled())
+		{
+			return;
+		}
+
+		GLint length = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+		if (length <= 0)
+		{
+			return;
+		}
+
+		CacheHeader header{ CacheMagic, CacheVersion, key, 0, 0 };
+		std::vector<char> binary(length);
+
+		GLenum format = 0;
+		glGetProgramBinary(program, length, &length, &format, binary.data());
+		header.Format = format;
+		header.Length = length;
+
+		const auto path = EntryPath(key);
+		std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+
+		if (!file.is_open())
+		{
+			std::cerr << "Error opening file " << path << "\n";
+			return;
+		}
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(binary.data(), length);
+	}
+}
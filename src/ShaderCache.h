@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+// On-disk cache of linked program binaries (glGetProgramBinary/glProgramBinary)
+// Entries are keyed by the shader sources and the driver vendor/renderer/version strings,
+// a binary the driver rejects is deleted and the caller compiles from source.
+// Disabled until a directory is set.
+
+namespace Gl
+{
+	class ShaderCache
+	{
+	public:
+		static void SetDirectory(const std::string& directory);
+		static bool IsEnabled();
+
+		static uint64_t Key(const std::string& vert, const std::string& frag);
+
+		// Creates and returns a linked program from the cache, 0 on a miss
+		static GLuint Load(uint64_t key);
+		// The program has to be linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+		static void Store(uint64_t key, GLuint program);
+	private:
+		static std::string EntryPath(uint64_t key);
+		static std::string s_Directory;
+	};
+}
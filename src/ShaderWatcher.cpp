@@ -0,0 +1,219 @@
+#include "ShaderWatcher.h"
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+#ifdef __linux__
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+namespace
+{
+	std::string FileName(const std::string& path)
+	{
+		const auto slash = path.find_last_of("/\\");
+		return slash == std::string::npos ? path : path.substr(slash + 1);
+	}
+
+	// Editors save in several steps, a half written file reads as empty
+	bool ReadSource(const std::string& filepath, std::string& out)
+	{
+		std::ifstream file(filepath, std::ios::in | std::ios::binary);
+
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		std::ostringstream stream;
+		stream << file.rdbuf();
+		out = stream.str();
+		return !out.empty();
+	}
+}
+
+ShaderWatcher::ShaderWatcher(const std::string& directory)
+	:
+	m_Directory(directory)
+{
+#ifdef __linux__
+	m_Fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+	if (m_Fd < 0 || inotify_add_watch(m_Fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+	{
+		std::cerr << "Cannot watch shader directory " << directory << "\n";
+		if (m_Fd >= 0)
+		{
+			close(m_Fd);
+			m_Fd = -1;
+		}
+		return;
+	}
+
+	m_Thread = std::thread(&ShaderWatcher::Run, this);
+#else
+	std::cerr << "Shader hot reload is only supported on Linux\n";
+#endif
+}
+
+ShaderWatcher::~ShaderWatcher()
+{
+	m_Stop = true;
+
+	if (m_Thread.joinable())
+	{
+		m_Thread.join();
+	}
+
+#ifdef __linux__
+	if (m_Fd >= 0)
+	{
+		close(m_Fd);
+	}
+#endif
+}
+
+void ShaderWatcher::Watch(const std::shared_ptr<Gl::Shader>& shader, const std::string& vertFile, const std::string& fragFile)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Entries.push_back({ shader, vertFile, fragFile, nullptr });
+}
+
+void ShaderWatcher::Run()
+{
+#ifdef __linux__
+	alignas(inotify_event) char buffer[4096];
+	pollfd pfd{ m_Fd, POLLIN, 0 };
+
+	while (!m_Stop)
+	{
+		// Timeout so the destructor doesn't wait on a file event
+		if (poll(&pfd, 1, 100) <= 0)
+		{
+			continue;
+		}
+
+		std::vector<std::string> changedFiles;
+
+		ssize_t length;
+		while ((length = read(m_Fd, buffer, sizeof(buffer))) > 0)
+		{
+			for (char* ptr = buffer; ptr < buffer + length;)
+			{
+				const auto* event = reinterpret_cast<const inotify_event*>(ptr);
+				if (event->len > 0 && std::find(changedFiles.begin(), changedFiles.end(), event->name) == changedFiles.end())
+				{
+					changedFiles.emplace_back(event->name);
+				}
+				ptr += sizeof(inotify_event) + event->len;
+			}
+		}
+
+		if (!changedFiles.empty())
+		{
+			QueueReloads(changedFiles);
+		}
+	}
+#endif
+}
+
+void ShaderWatcher::QueueReloads(const std::vector<std::string>& changedFiles)
+{
+	std::vector<Sources> reloads;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		for (size_t i = 0; i < m_Entries.size(); i++)
+		{
+			const auto& entry = m_Entries[i];
+			for (const auto& file : changedFiles)
+			{
+				if (file == FileName(entry.VertFile) || file == FileName(entry.FragFile))
+				{
+					reloads.push_back({ i, entry.VertFile, entry.FragFile });
+					break;
+				}
+			}
+		}
+	}
+
+	// File IO happens outside of the lock, the paths are swapped for the contents
+	for (auto it = reloads.begin(); it != reloads.end();)
+	{
+		std::string vert, frag;
+		if (ReadSource(it->Vert, vert) && ReadSource(it->Frag, frag))
+		{
+			it->Vert = std::move(vert);
+			it->Frag = std::move(frag);
+			++it;
+		}
+		else
+		{
+			it = reloads.erase(it);
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	for (auto& reload : reloads)
+	{
+		// A newer version of the same shader replaces the queued one
+		auto queued = std::find_if(m_Ready.begin(), m_Ready.end(), [&reload](const Sources& s) { return s.Entry == reload.Entry; });
+		if (queued != m_Ready.end())
+		{
+			*queued = std::move(reload);
+		}
+		else
+		{
+			m_Ready.push_back(std::move(reload));
+		}
+	}
+}
+
+void ShaderWatcher::Update()
+{
+	std::vector<Sources> ready;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		ready.swap(m_Ready);
+	}
+
+	// m_Entries is only resized on this thread, no lock needed to read it here
+	for (auto& sources : ready)
+	{
+		auto& entry = m_Entries[sources.Entry];
+		entry.Pending = std::make_unique<Gl::Shader>();
+		entry.Pending->CompileAsync(sources.Vert, sources.Frag);
+	}
+
+	for (auto& entry : m_Entries)
+	{
+		if (!entry.Pending)
+		{
+			continue;
+		}
+
+		entry.Pending->Poll();
+
+		switch (entry.Pending->GetStatus())
+		{
+		case Gl::Shader::Status::Ready:
+			if (auto target = entry.Target.lock())
+			{
+				target->ReplaceProgram(*entry.Pending);
+				std::cerr << "Reloaded " << entry.VertFile << ", " << entry.FragFile << "\n";
+			}
+			entry.Pending.reset();
+			break;
+		case Gl::Shader::Status::Failed:
+			std::cerr << "Reloading " << entry.VertFile << ", " << entry.FragFile << " failed, keeping the old program\n";
+			entry.Pending.reset();
+			break;
+		default:
+			break;
+		}
+	}
+}
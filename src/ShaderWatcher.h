@@ -0,0 +1,60 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Shader.h"
+
+// Hot reload for shaders in a single directory (inotify, Linux only)
+// The watcher thread only reads the changed sources, everything GL happens in Update on the render thread:
+// the replacement is compiled asynchronously next to the live program and swapped in once it's linked,
+// a failed compile keeps the old program.
+
+class ShaderWatcher
+{
+public:
+	ShaderWatcher(const std::string& directory);
+	~ShaderWatcher();
+
+	ShaderWatcher(const ShaderWatcher&) = delete;
+	ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+	// Both files have to be inside the watched directory
+	void Watch(const std::shared_ptr<Gl::Shader>& shader, const std::string& vertFile, const std::string& fragFile);
+
+	// Call between frames, never blocks on the compile
+	void Update();
+
+	bool IsRunning() const { return m_Fd >= 0; }
+private:
+	struct Entry
+	{
+		std::weak_ptr<Gl::Shader> Target;
+		std::string VertFile;
+		std::string FragFile;
+		std::unique_ptr<Gl::Shader> Pending; // render thread only
+	};
+
+	struct Sources
+	{
+		size_t Entry;
+		std::string Vert;
+		std::string Frag;
+	};
+
+	void Run();
+	void QueueReloads(const std::vector<std::string>& changedFiles);
+
+	std::string m_Directory;
+	int m_Fd{ -1 };
+	std::atomic<bool> m_Stop{ false };
+	std::thread m_Thread;
+
+	std::mutex m_Mutex;
+	std::vector<Entry> m_Entries;
+	std::vector<Sources> m_Ready;
+};
@@ -0,0 +1,58 @@
+#include "SimdLevel.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define OPENGLPRJ_SSE2
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+namespace
+{
+	SimdLevel DetectSimdLevel()
+	{
+#if defined(OPENGLPRJ_AVX2) && defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		const bool avx = (info[2] & (1 << 28)) != 0;
+		// The OS has to save the YMM registers
+		if (osxsave && avx && (_xgetbv(0) & 6) == 6)
+		{
+			__cpuidex(info, 7, 0);
+			if (info[1] & (1 << 5))
+			{
+				return SimdLevel::Avx2;
+			}
+		}
+#elif defined(OPENGLPRJ_AVX2)
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+		{
+			return SimdLevel::Avx2;
+		}
+#endif
+
+#ifdef OPENGLPRJ_SSE2
+		return SimdLevel::Sse2;
+#else
+		return SimdLevel::Scalar;
+#endif
+	}
+}
+
+SimdLevel GetSupportedSimdLevel()
+{
+	static const SimdLevel level = DetectSimdLevel();
+	return level;
+}
+
+const char* GetSimdLevelName(SimdLevel level)
+{
+	switch (level)
+	{
+	case SimdLevel::Sse2: return "sse2";
+	case SimdLevel::Avx2: return "avx2";
+	default: return "scalar";
+	}
+}
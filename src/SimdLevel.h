@@ -0,0 +1,14 @@
+#pragma once
+
+// Instruction sets the CPU kernels (tessellation, transforms) are built for, picked at runtime
+
+enum class SimdLevel
+{
+	Scalar,
+	Sse2,
+	Avx2
+};
+
+// Highest level the CPU (and the build) supports
+SimdLevel GetSupportedSimdLevel();
+const char* GetSimdLevelName(SimdLevel level);
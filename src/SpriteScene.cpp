@@ -0,0 +1,88 @@
+#include "SpriteScene.h"
+
+#include <algorithm>
+
+#include "Tessellation.h"
+#include "VertexEncoding.h"
+
+SpriteScene::SpriteScene(QuadBatch& batch, const std::vector<Gl::TextureHandle>& textures, uint32_t columns, uint32_t rows)
+	:
+	IScene("sprites"),
+	m_Batch(batch),
+	m_Textures(textures),
+	m_Columns(columns),
+	m_Rows(rows),
+	m_Sin(columns),
+	m_Cos(columns)
+{
+}
+
+void SpriteScene::Update(float dt)
+{
+	m_Time += dt;
+	m_Step = dt;
+}
+
+void SpriteScene::Snapshot()
+{
+	auto& vertices = m_Builds[m_Build];
+	const float angle = m_Time * 1.2f;
+	vertices.resize(static_cast<size_t>(m_Columns) * m_Rows * 4);
+
+	const glm::vec2 size{ 2.f / m_Columns, 2.f / m_Rows };
+	const glm::vec2 half = size * 0.4f;
+	const glm::vec4 uvRect{ 0.f, 0.f, 1.f, 1.f };
+
+	QuadVertex* out = vertices.data();
+	for (uint32_t y = 0; y < m_Rows; y++)
+	{
+		// Every quad is turned 0.05 more than its left neighbour
+		SinCosRange(angle + y * 0.05f, 0.05f, m_Columns, m_Sin.data(), m_Cos.data());
+
+		for (uint32_t x = 0; x < m_Columns; x++, out += 4)
+		{
+			const glm::vec2 center{ (x + 0.5f) * size.x - 1.f, (y + 0.5f) * size.y - 1.f };
+			const glm::vec2 ax = glm::vec2(m_Cos[x], m_Sin[x]) * half.x;
+			const glm::vec2 ay = glm::vec2(-m_Sin[x], m_Cos[x]) * half.y;
+			const uint32_t color = PackUnorm4x8({ x / float(m_Columns), y / float(m_Rows), 0.5f, 1.f });
+
+			QuadBatch::WriteQuad(out, { center - ax - ay, center + ax - ay, center + ax + ay, center - ax + ay }, uvRect, color);
+		}
+	}
+
+	auto& frame = m_Frames.GetBack();
+	frame.Previous = m_LastBuild ? m_LastBuild : &vertices;
+	frame.PreviousTime = m_LastBuild ? m_LastTime : m_Time;
+	frame.Current = &vertices;
+	frame.CurrentTime = m_Time;
+	frame.Step = m_Step;
+
+	m_LastBuild = &vertices;
+	m_LastTime = m_Time;
+	m_Build = (m_Build + 1) % m_Builds.size();
+}
+
+void SpriteScene::Present()
+{
+	m_Frames.Swap();
+}
+
+void SpriteScene::Render(float alpha)
+{
+	const auto& frame = m_Frames.GetFront();
+
+	m_Batch.Begin();
+	if (frame.Current)
+	{
+		// Drawn a timestep behind, alpha of a step past the previous update's state
+		const float time = frame.CurrentTime - (1.f - alpha) * frame.Step;
+		const float span = frame.CurrentTime - frame.PreviousTime;
+		const float t = span > 0.f ? std::clamp((time - frame.PreviousTime) / span, 0.f, 1.f) : 1.f;
+		m_Batch.DrawQuads(frame.Previous->data(), frame.Current->data(), frame.Current->size() / 4, t);
+	}
+	for (size_t i = 0; i < m_Textures.size(); i++)
+	{
+		m_Batch.DrawQuad({ -1.f + (i % 16) * 0.125f, 0.875f - (i / 16) * 0.125f }, { 0.12f, 0.12f }, m_Textures[i]);
+	}
+	m_Batch.End();
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+
+#include "IScene.h"
+#include "FramePipeline.h"
+#include "QuadBatch.h"
+#include "TextureLoader.h"
+
+// A grid of spinning quads whose vertices are built on the update thread, the render thread blends
+// the two latest builds into the quad batch and draws one quad per texture on top
+
+class SpriteScene : public IScene
+{
+public:
+	SpriteScene(QuadBatch& batch, const std::vector<Gl::TextureHandle>& textures, uint32_t columns = 512, uint32_t rows = 400);
+
+	void OnEvent(const Event&) override {}
+	void Update(float dt) override;
+	void Snapshot() override;
+	void Present() override;
+	void Render(float alpha) override;
+private:
+	// The two latest builds and the simulation times they were built at
+	struct Frame
+	{
+		const std::vector<QuadVertex>* Previous{ nullptr };
+		const std::vector<QuadVertex>* Current{ nullptr };
+		float PreviousTime{ 0.f };
+		float CurrentTime{ 0.f };
+		float Step{ 0.f };
+	};
+
+	QuadBatch& m_Batch;
+	const std::vector<Gl::TextureHandle>& m_Textures;
+	uint32_t m_Columns;
+	uint32_t m_Rows;
+
+	// Update thread
+	float m_Time{ 0.f };
+	float m_Step{ 0.f };
+	std::vector<float> m_Sin;
+	std::vector<float> m_Cos;
+
+	// Render reads two builds while the third one is written
+	std::array<std::vector<QuadVertex>, 3> m_Builds;
+	uint32_t m_Build{ 0 };
+	const std::vector<QuadVertex>* m_LastBuild{ nullptr };
+	float m_LastTime{ 0.f };
+
+	DoubleBuffered<Frame> m_Frames;
+};
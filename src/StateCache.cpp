@@ -0,0 +1,154 @@
+#include "StateCache.h"
+
+#include <cassert>
+
+namespace Gl
+{
+	GLuint StateCache::s_Program = StateCache::Unknown;
+	GLuint StateCache::s_VertexArray = StateCache::Unknown;
+	std::array<GLuint, StateCache::BufferSlotCount> StateCache::s_Buffers = []()
+	{
+		std::array<GLuint, BufferSlotCount> buffers;
+		buffers.fill(Unknown);
+		return buffers;
+	}();
+	std::array<GLuint, StateCache::MaxTextureUnits> StateCache::s_Textures = []()
+	{
+		std::array<GLuint, MaxTextureUnits> textures;
+		textures.fill(Unknown);
+		return textures;
+	}();
+
+	StateCacheStats StateCache::s_Frame;
+	StateCacheStats StateCache::s_LastFrame;
+
+	bool StateCache::Update(GLuint& current, GLuint value)
+	{
+		if (current == value)
+		{
+			s_Frame.Elided++;
+			return false;
+		}
+
+		current = value;
+		s_Frame.Issued++;
+		return true;
+	}
+
+	int StateCache::GetBufferSlot(GLenum target)
+	{
+		switch (target)
+		{
+		case GL_ARRAY_BUFFER: return ArrayBuffer;
+		case GL_ELEMENT_ARRAY_BUFFER: return ElementArrayBuffer;
+		case GL_DRAW_INDIRECT_BUFFER: return DrawIndirectBuffer;
+		case GL_PIXEL_UNPACK_BUFFER: return PixelUnpackBuffer;
+		default: return -1;
+		}
+	}
+
+	void StateCache::UseProgram(GLuint program)
+	{
+		if (Update(s_Program, program))
+		{
+			glUseProgram(program);
+		}
+	}
+
+	void StateCache::BindVertexArray(GLuint vertexArray)
+	{
+		if (Update(s_VertexArray, vertexArray))
+		{
+			glBindVertexArray(vertexArray);
+			s_Buffers[ElementArrayBuffer] = Unknown;
+		}
+	}
+
+	void StateCache::BindBuffer(GLenum target, GLuint buffer)
+	{
+		const int slot = GetBufferSlot(target);
+		if (slot < 0)
+		{
+			s_Frame.Issued++;
+			glBindBuffer(target, buffer);
+			return;
+		}
+
+		if (Update(s_Buffers[slot], buffer))
+		{
+			glBindBuffer(target, buffer);
+		}
+	}
+
+	void StateCache::BindTexture(uint32_t unit, GLuint texture)
+	{
+		assert(unit < MaxTextureUnits);
+
+		if (Update(s_Textures[unit], texture))
+		{
+			glBindTextureUnit(unit, texture);
+		}
+	}
+
+	void StateCache::VertexArrayElementBuffer(GLuint vertexArray, GLuint buffer)
+	{
+		glVertexArrayElementBuffer(vertexArray, buffer);
+		if (vertexArray == s_VertexArray)
+		{
+			s_Buffers[ElementArrayBuffer] = buffer;
+		}
+	}
+
+	void StateCache::OnProgramDeleted(GLuint program)
+	{
+		if (s_Program == program)
+		{
+			s_Program = Unknown;
+		}
+	}
+
+	void StateCache::OnVertexArrayDeleted(GLuint vertexArray)
+	{
+		if (s_VertexArray == vertexArray)
+		{
+			s_VertexArray = 0;
+			s_Buffers[ElementArrayBuffer] = Unknown;
+		}
+	}
+
+	void StateCache::OnBufferDeleted(GLuint buffer)
+	{
+		for (auto& bound : s_Buffers)
+		{
+			if (bound == buffer)
+			{
+				bound = 0;
+			}
+		}
+	}
+
+	void StateCache::OnTextureDeleted(GLuint texture)
+	{
+		for (auto& bound : s_Textures)
+		{
+			if (bound == texture)
+			{
+				bound = 0;
+			}
+		}
+	}
+
+	void StateCache::Invalidate()
+	{
+		s_Program = Unknown;
+		s_VertexArray = Unknown;
+		s_Buffers.fill(Unknown);
+		s_Textures.fill(Unknown);
+	}
+
+	void StateCache::BeginFrame()
+	{
+		s_LastFrame = s_Frame;
+		s_Frame = {};
+	}
+}
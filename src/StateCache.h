@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+// Shadow copy of the bound program, VAO, buffers and texture units of the current context
+// Binds that match the tracked state are skipped. The element buffer is part of the VAO so it's
+// forgotten whenever the VAO changes. Objects have to be reported when deleted, GL resets bindings
+// of deleted objects and their names can be reused.
+// Call Invalidate after GL state is changed behind the cache's back (or the context changes).
+
+namespace Gl
+{
+	struct StateCacheStats
+	{
+		uint32_t Issued{ 0 };
+		uint32_t Elided{ 0 };
+	};
+
+	class StateCache
+	{
+	public:
+		static constexpr uint32_t MaxTextureUnits = 32;
+
+		static void UseProgram(GLuint program);
+		static void BindVertexArray(GLuint vertexArray);
+		// Targets without a tracked binding point are always issued, indexed targets (SSBO, UBO)
+		// aren't tracked because glBindBufferBase changes their generic binding too
+		static void BindBuffer(GLenum target, GLuint buffer);
+		static void BindTexture(uint32_t unit, GLuint texture);
+		// Attaches an element buffer to a VAO without binding it (DSA)
+		static void VertexArrayElementBuffer(GLuint vertexArray, GLuint buffer);
+
+		static void OnProgramDeleted(GLuint program);
+		static void OnVertexArrayDeleted(GLuint vertexArray);
+		static void OnBufferDeleted(GLuint buffer);
+		static void OnTextureDeleted(GLuint texture);
+
+		static void Invalidate();
+
+		// Starts counting a new frame, the finished frame's counts are kept for GetFrameStats
+		static void BeginFrame();
+		static const StateCacheStats& GetFrameStats() { return s_LastFrame; }
+	private:
+		static constexpr GLuint Unknown = ~0u;
+
+		enum BufferSlot
+		{
+			ArrayBuffer,
+			ElementArrayBuffer,
+			DrawIndirectBuffer,
+			PixelUnpackBuffer,
+			BufferSlotCount
+		};
+
+		static int GetBufferSlot(GLenum target);
+		// Returns true if the call has to be issued
+		static bool Update(GLuint& current, GLuint value);
+
+		static GLuint s_Program;
+		static GLuint s_VertexArray;
+		static std::array<GLuint, BufferSlotCount> s_Buffers;
+		static std::array<GLuint, MaxTextureUnits> s_Textures;
+
+		static StateCacheStats s_Frame;
+		static StateCacheStats s_LastFrame;
+	};
+}
@@ -30,7 +30,7 @@ uint32_t StaticMesh::CreateNewVertexBuffer(const Gl::BufferLayout& layout)
 	
 	if (m_VertexBuffers.size() == 0)
 	{
-		m_VertBufferParamLength = layout.GetLength();
+		m_VertexStride = layout.GetStride();
 	}
 
 	m_VertexBuffers.push_back(buff);
@@ -38,15 +38,40 @@ uint32_t StaticMesh::CreateNewVertexBuffer(const Gl::BufferLayout& layout)
 	return m_VertexBuffers.size() - 1;
 }
 
+void StaticMesh::UploadVertexData(uint32_t bufIdx, const void* data, size_t size)
+{
+	assert(bufIdx < m_VertexBuffers.size());
+
+	if (bufIdx == 0)
+	{
+		m_VertexCount = size / m_VertexStride;
+		m_Bounds = ComputeBounds(data, m_VertexCount, m_VertexBuffers[0]->GetLayout());
+	}
+
+	m_VertexBuffers[bufIdx]->SetData(data, size);
+}
+
+void StaticMesh::UploadIndexData(const void* data, size_t count, GLenum type)
+{
+	m_IndexCount = count;
+	m_IndexBuffer->SetRawData(data, count, type);
+}
+
 void StaticMesh::UploadIndexData(std::vector<uint32_t>& vec)
 {
-	m_IndexCount = vec.size();
-	m_IndexBuffer->SetData(vec, m_IndexCount);
+	UploadIndexData(vec.data(), vec.size());
 }
 
 void StaticMesh::UploadIndexData(uint32_t* data, size_t count)
 {
 	m_IndexCount = count;
+
+	if (m_IndexChunking && m_DrawType == GL_TRIANGLES)
+	{
+		m_IndexBuffer->SetDataChunked(data, count);
+		return;
+	}
+
 	m_IndexBuffer->SetData(data, count);
 }
 
@@ -57,7 +82,38 @@ void StaticMesh::DrawArrays()
 }
 
 void StaticMesh::DrawIndexed()
+{
+	DrawElements(1, 0);
+}
+
+void StaticMesh::DrawArraysInstanced(uint32_t instanceCount, uint32_t baseInstance)
+{
+	m_VertexArray->Bind();
+	glDrawArraysInstancedBaseInstance(m_DrawType, 0, m_VertexCount, instanceCount, baseInstance);
+}
+
+void StaticMesh::DrawIndexedInstanced(uint32_t instanceCount, uint32_t baseInstance)
+{
+	DrawElements(instanceCount, baseInstance);
+}
+
+void StaticMesh::DrawElements(uint32_t instanceCount, uint32_t baseInstance)
 {
 	m_VertexArray->Bind();
-	glDrawElements(m_DrawType, m_IndexCount, GL_UNSIGNED_INT, 0);
+
+	const GLenum type = m_IndexBuffer->GetType();
+	const auto& chunks = m_IndexBuffer->GetChunks();
+
+	if (chunks.empty())
+	{
+		glDrawElementsInstancedBaseInstance(m_DrawType, m_IndexCount, type, nullptr, instanceCount, baseInstance);
+		return;
+	}
+
+	for (const auto& chunk : chunks)
+	{
+		glDrawElementsInstancedBaseVertexBaseInstance(m_DrawType, chunk.Count, type,
+			reinterpret_cast<const void*>(static_cast<size_t>(chunk.First) * m_IndexBuffer->GetTypeSize()),
+			instanceCount, chunk.BaseVertex, baseInstance);
+	}
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 
 #include "VertexBuffer.h"
 #include "VertexArray.h"
+#include "Bounds.h"
 
 class StaticMesh
 {
@@ -16,6 +17,10 @@ public:
 	void SetDrawType(GLint drawType);
 	void DrawIndexed();
 	void DrawArrays();
+	// Per instance data goes in a vertex buffer whose layout elements have a divisor
+	// baseInstance offsets only the attributes with a divisor
+	void DrawIndexedInstanced(uint32_t instanceCount, uint32_t baseInstance = 0);
+	void DrawArraysInstanced(uint32_t instanceCount, uint32_t baseInstance = 0);
 
 	// Every upload function will overwrite previous data 
 	template<typename T>
@@ -25,7 +30,8 @@ public:
 
 		if (bufIdx == 0)
 		{
-			m_VertexCount = vec.size() / m_VertBufferParamLength;
+			m_VertexCount = vec.size() * sizeof(T) / m_VertexStride;
+			m_Bounds = ComputeBounds(vec.data(), m_VertexCount, m_VertexBuffers[0]->GetLayout());
 		}
 
 		m_VertexBuffers[bufIdx]->SetData(vec, vec.size());
@@ -37,14 +43,35 @@ public:
 		UploadVertexData(0, vec);
 	}
 
+	// size in bytes, the data has to match the buffer layout
+	void UploadVertexData(uint32_t bufIdx, const void* data, size_t size);
+
 	void UploadIndexData(std::vector<uint32_t>& vec);
 	void UploadIndexData(uint32_t* data, size_t size);
+	// Indices already stored as type (GL_UNSIGNED_BYTE/SHORT/INT)
+	void UploadIndexData(const void* data, size_t count, GLenum type);
+
+	GLint GetDrawType() const { return m_DrawType; }
+	uint32_t GetVertexCount() const { return m_VertexCount; }
+	uint32_t GetIndexCount() const { return m_IndexCount; }
+	// Local space bounds of the first vertex buffer, computed on upload
+	const Aabb& GetBounds() const { return m_Bounds; }
+	uint32_t GetVertexBufferCount() const { return m_VertexBuffers.size(); }
+	const Gl::VertexBuffer& GetVertexBuffer(uint32_t bufIdx) const { return *m_VertexBuffers[bufIdx]; }
+	const Gl::IndexBuffer& GetIndexBuffer() const { return *m_IndexBuffer; }
+	// Triangle lists with more than 65536 vertices get 16 bit indices split into base vertex chunks
+	// instead of 32 bit indices, applies to the next index upload
+	void SetIndexChunking(bool enable) { m_IndexChunking = enable; }
 private:
-	int m_VertBufferParamLength{ 0 };
+	void DrawElements(uint32_t instanceCount, uint32_t baseInstance);
+
+	uint32_t m_VertexStride{ 0 };
 	int m_IndexCount{ 0 };
 	int m_VertexCount{ 0 };
+	Aabb m_Bounds;
 	std::vector<std::shared_ptr<Gl::VertexBuffer>> m_VertexBuffers;
 	std::unique_ptr<Gl::VertexArray> m_VertexArray;
 	std::shared_ptr<Gl::IndexBuffer> m_IndexBuffer;
 	GLint m_DrawType{ GL_TRIANGLES };
+	bool m_IndexChunking{ false };
 };
\ No newline at end of file
@@ -0,0 +1,130 @@
+#include "StreamBuffer.h"
+
+#include <cassert>
+#include <iostream>
+
+#include "Capabilities.h"
+#include "StateCache.h"
+
+namespace Gl
+{
+	StreamBuffer::StreamBuffer(size_t regionSize)
+		:
+		m_RegionSize(regionSize)
+	{
+		const size_t size = regionSize * Regions;
+
+		glCreateBuffers(1, &m_ID);
+
+		if (HasVersion(4, 4) || HasExtension("GL_ARB_buffer_storage"))
+		{
+			static constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+			glNamedBufferStorage(m_ID, size, nullptr, flags);
+			m_Mapped = static_cast<uint8_t*>(glMapNamedBufferRange(m_ID, 0, size, flags));
+		}
+
+		if (!m_Mapped)
+		{
+			std::cerr << "Persistent mapping not available, stream buffer falls back to glNamedBufferSubData\n";
+			glNamedBufferData(m_ID, size, nullptr, GL_STREAM_DRAW);
+			m_Staging.resize(size);
+		}
+	}
+
+	StreamBuffer::~StreamBuffer()
+	{
+		for (auto& fence : m_Fences)
+		{
+			if (fence)
+			{
+				glDeleteSync(fence);
+			}
+		}
+
+		if (m_Mapped)
+		{
+			glUnmapNamedBuffer(m_ID);
+		}
+		glDeleteBuffers(1, &m_ID);
+		StateCache::OnBufferDeleted(m_ID);
+	}
+
+	std::shared_ptr<StreamBuffer> StreamBuffer::Create(size_t regionSize)
+	{
+		return std::make_shared<StreamBuffer>(regionSize);
+	}
+
+	void StreamBuffer::BeginFrame()
+	{
+		m_Region = (m_Region + 1) % Regions;
+		m_Head = 0;
+
+		auto& fence = m_Fences[m_Region];
+		if (!fence)
+		{
+			return;
+		}
+
+		GLenum result;
+		do
+		{
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		} while (result == GL_TIMEOUT_EXPIRED);
+
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+
+	void StreamBuffer::EndFrame()
+	{
+		auto& fence = m_Fences[m_Region];
+		if (fence)
+		{
+			glDeleteSync(fence);
+		}
+		fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	StreamAllocation StreamBuffer::Allocate(size_t size, size_t alignment)
+	{
+		const size_t regionStart = m_Region * m_RegionSize;
+		const size_t offset = (regionStart + m_Head + alignment - 1) / alignment * alignment;
+
+		if (offset + size > regionStart + m_RegionSize)
+		{
+			return {};
+		}
+
+		m_Head = offset + size - regionStart;
+
+		uint8_t* base = m_Mapped ? m_Mapped : m_Staging.data();
+		return { base + offset, offset, size };
+	}
+
+	void StreamBuffer::Commit(const StreamAllocation& allocation)
+	{
+		if (!m_Mapped && allocation.IsValid())
+		{
+			glNamedBufferSubData(m_ID, allocation.Offset, allocation.Size, allocation.Data);
+		}
+	}
+
+	void StreamBuffer::Trim(StreamAllocation& allocation, size_t size)
+	{
+		assert(size <= allocation.Size);
+		assert(allocation.Offset + allocation.Size == m_Region * m_RegionSize + m_Head);
+
+		m_Head -= allocation.Size - size;
+		allocation.Size = size;
+	}
+
+	size_t StreamBuffer::GetAvailable(size_t alignment) const
+	{
+		const size_t regionStart = m_Region * m_RegionSize;
+		const size_t offset = (regionStart + m_Head + alignment - 1) / alignment * alignment;
+		const size_t regionEnd = regionStart + m_RegionSize;
+
+		return offset < regionEnd ? regionEnd - offset : 0;
+	}
+}
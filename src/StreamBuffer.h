@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+// Ring buffer for data that's rewritten every frame (dynamic vertices/indices)
+// The storage is split into Regions per-frame regions, a region is reused only after the fence
+// placed at the end of its frame has signaled. With GL_ARB_buffer_storage the whole buffer stays
+// persistently and coherently mapped and allocations are written in place, without it allocations
+// go to a CPU staging copy and Commit uploads them with glNamedBufferSubData.
+// Can be bound as a vertex and as an index buffer at the same time.
+
+namespace Gl
+{
+	struct StreamAllocation
+	{
+		void* Data{ nullptr };
+		size_t Offset{ 0 }; // from the start of the buffer
+		size_t Size{ 0 };
+
+		bool IsValid() const { return Data != nullptr; }
+	};
+
+	class StreamBuffer
+	{
+	public:
+		static constexpr uint32_t Regions = 3;
+
+		StreamBuffer(size_t regionSize);
+		~StreamBuffer();
+
+		StreamBuffer(const StreamBuffer&) = delete;
+		StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+		static std::shared_ptr<StreamBuffer> Create(size_t regionSize);
+
+		// Moves to the next region, waits only if the GPU is still Regions frames behind
+		void BeginFrame();
+		void EndFrame();
+
+		// Invalid allocation if the current region is full
+		StreamAllocation Allocate(size_t size, size_t alignment = 4);
+		void Commit(const StreamAllocation& allocation);
+		// Returns the end of the latest allocation to the region, the first size bytes stay allocated
+		void Trim(StreamAllocation& allocation, size_t size);
+		// Largest allocation with alignment the current region still has room for
+		size_t GetAvailable(size_t alignment = 4) const;
+
+		GLuint GetID() const { return m_ID; }
+		size_t GetRegionSize() const { return m_RegionSize; }
+		bool IsPersistent() const { return m_Mapped != nullptr; }
+	private:
+		GLuint m_ID;
+		size_t m_RegionSize;
+		uint32_t m_Region{ 0 };
+		size_t m_Head{ 0 };
+		uint8_t* m_Mapped{ nullptr };
+		std::vector<uint8_t> m_Staging;
+		std::array<GLsync, Regions> m_Fences{};
+	};
+}
@@ -0,0 +1,142 @@
+#include "Tessellation.h"
+
+#include <cmath>
+#include <algorithm>
+
+#include "TessellationKernel.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define OPENGLPRJ_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef OPENGLPRJ_AVX2
+// TessellationAvx2.cpp, compiled with AVX2 enabled
+uint32_t TessellateArcAvx2(const ArcParams& arc, uint32_t first, uint32_t count, ColoredVertex* out);
+uint32_t SinCosRangeAvx2(float start, float step, uint32_t count, float* sin, float* cos);
+#endif
+
+namespace
+{
+#ifdef OPENGLPRJ_SSE2
+	struct Sse2Ops
+	{
+		using Float = __m128;
+		using Int = __m128i;
+		static constexpr uint32_t Width = 4;
+
+		static Float Set(float v) { return _mm_set1_ps(v); }
+		static Int SetInt(int32_t v) { return _mm_set1_epi32(v); }
+		static Float Ramp() { return _mm_setr_ps(0.f, 1.f, 2.f, 3.f); }
+
+		static Float Add(Float a, Float b) { return _mm_add_ps(a, b); }
+		static Float Sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+		static Float Mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+		static Float And(Float a, Float b) { return _mm_and_ps(a, b); }
+		static Float AndNot(Float a, Float b) { return _mm_andnot_ps(a, b); }
+		static Float Or(Float a, Float b) { return _mm_or_ps(a, b); }
+		static Float Xor(Float a, Float b) { return _mm_xor_ps(a, b); }
+
+		static Int ToInt(Float v) { return _mm_cvttps_epi32(v); }
+		static Float ToFloat(Int v) { return _mm_cvtepi32_ps(v); }
+		static Float CastToFloat(Int v) { return _mm_castsi128_ps(v); }
+
+		static Int IntAdd(Int a, Int b) { return _mm_add_epi32(a, b); }
+		static Int IntSub(Int a, Int b) { return _mm_sub_epi32(a, b); }
+		static Int IntAnd(Int a, Int b) { return _mm_and_si128(a, b); }
+		static Int IntAndNot(Int a, Int b) { return _mm_andnot_si128(a, b); }
+		static Int IntEqual(Int a, Int b) { return _mm_cmpeq_epi32(a, b); }
+		template<int Bits>
+		static Int ShiftLeft(Int v) { return _mm_slli_epi32(v, Bits); }
+
+		static void Store(float* dst, Float v) { _mm_storeu_ps(dst, v); }
+		static void StoreInt(int32_t* dst, Int v) { _mm_storeu_si128(reinterpret_cast<Int*>(dst), v); }
+	};
+#endif
+
+	void TessellateArcScalar(const ArcParams& arc, uint32_t first, uint32_t count, ColoredVertex* out)
+	{
+		const uint32_t lastStop = arc.ColorCount - 1;
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const float sample = static_cast<float>(first + i);
+			const float angle = arc.StartAngle + sample * arc.AngleStep;
+			const float c = std::cos(angle);
+			const float s = std::sin(angle);
+
+			const float colorPos = sample * arc.ColorStep;
+			const uint32_t stop = static_cast<uint32_t>(colorPos);
+			const float frac = colorPos - stop;
+			const auto& from = arc.Colors[std::min(stop, lastStop)];
+			const auto& to = arc.Colors[std::min(stop + 1, lastStop)];
+			const glm::vec3 clr = (to - from) * frac + from;
+
+			out[i * 2] = { { arc.Center.x + c * arc.RadiusA, arc.Center.y + s * arc.RadiusA, 0.f }, clr };
+			out[i * 2 + 1] = { { arc.Center.x + c * arc.RadiusB, arc.Center.y + s * arc.RadiusB, 0.f }, clr };
+		}
+	}
+
+	void SinCosRangeScalar(float start, float step, uint32_t count, float* sin, float* cos)
+	{
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const float angle = start + static_cast<float>(i) * step;
+			sin[i] = std::sin(angle);
+			cos[i] = std::cos(angle);
+		}
+	}
+}
+
+void TessellateArc(const ArcParams& arc, uint32_t first, uint32_t count, ColoredVertex* out)
+{
+	TessellateArc(arc, first, count, out, GetSupportedSimdLevel());
+}
+
+void TessellateArc(const ArcParams& arc, uint32_t first, uint32_t count, ColoredVertex* out, SimdLevel level)
+{
+	level = std::min(level, GetSupportedSimdLevel());
+	uint32_t done = 0;
+
+#ifdef OPENGLPRJ_AVX2
+	if (level == SimdLevel::Avx2)
+	{
+		done = TessellateArcAvx2(arc, first, count, out);
+	}
+#endif
+#ifdef OPENGLPRJ_SSE2
+	if (level >= SimdLevel::Sse2)
+	{
+		done += TessellationKernel::TessellateArc<Sse2Ops>(arc, first + done, count - done, out + done * 2);
+	}
+#endif
+
+	TessellateArcScalar(arc, first + done, count - done, out + done * 2);
+}
+
+void SinCosRange(float start, float step, uint32_t count, float* sin, float* cos)
+{
+	SinCosRange(start, step, count, sin, cos, GetSupportedSimdLevel());
+}
+
+void SinCosRange(float start, float step, uint32_t count, float* sin, float* cos, SimdLevel level)
+{
+	level = std::min(level, GetSupportedSimdLevel());
+	uint32_t done = 0;
+
+#ifdef OPENGLPRJ_AVX2
+	if (level == SimdLevel::Avx2)
+	{
+		done = SinCosRangeAvx2(start, step, count, sin, cos);
+	}
+#endif
+#ifdef OPENGLPRJ_SSE2
+	if (level >= SimdLevel::Sse2)
+	{
+		const float tailStart = start + static_cast<float>(done) * step;
+		done += TessellationKernel::SinCosRange<Sse2Ops>(tailStart, step, count - done, sin + done, cos + done);
+	}
+#endif
+
+	SinCosRangeScalar(start + static_cast<float>(done) * step, step, count - done, sin + done, cos + done);
+}
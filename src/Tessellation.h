@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "Vertex.h"
+#include "SimdLevel.h"
+
+// Batched sin/cos and arc/ring vertex generation
+// SSE2 and AVX2 kernels are picked at runtime from what the CPU supports, the scalar path is the
+// reference and the fallback on other architectures. The SIMD sin/cos is accurate to a few ulp
+// for angles up to a few thousand radians.
+
+// A ring segment made of samples, every sample writes two vertices (at RadiusA then RadiusB) for a triangle strip
+// Sample i is at StartAngle + i * AngleStep, its color is interpolated from the Colors stops at i * ColorStep
+struct ArcParams
+{
+	glm::vec2 Center;
+	float StartAngle;
+	float AngleStep;
+	float RadiusA;
+	float RadiusB;
+	const glm::vec3* Colors;
+	uint32_t ColorCount;
+	float ColorStep;
+};
+
+// out receives 2 * count vertices for samples [first, first + count), disjoint ranges can run in parallel
+void TessellateArc(const ArcParams& arc, uint32_t first, uint32_t count, ColoredVertex* out);
+void TessellateArc(const ArcParams& arc, uint32_t first, uint32_t count, ColoredVertex* out, SimdLevel level);
+
+// sin/cos of start + i * step for i in [0, count)
+void SinCosRange(float start, float step, uint32_t count, float* sin, float* cos);
+void SinCosRange(float start, float step, uint32_t count, float* sin, float* cos, SimdLevel level);
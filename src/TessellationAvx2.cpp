@@ -0,0 +1,55 @@
+// Built with AVX2 enabled (see CMakeLists.txt), only called after Tessellation.cpp checked the CPU
+#ifdef OPENGLPRJ_AVX2
+
+#include <immintrin.h>
+
+#include "TessellationKernel.h"
+
+namespace
+{
+	struct Avx2Ops
+	{
+		using Float = __m256;
+		using Int = __m256i;
+		static constexpr uint32_t Width = 8;
+
+		static Float Set(float v) { return _mm256_set1_ps(v); }
+		static Int SetInt(int32_t v) { return _mm256_set1_epi32(v); }
+		static Float Ramp() { return _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f); }
+
+		static Float Add(Float a, Float b) { return _mm256_add_ps(a, b); }
+		static Float Sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+		static Float Mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+		static Float And(Float a, Float b) { return _mm256_and_ps(a, b); }
+		static Float AndNot(Float a, Float b) { return _mm256_andnot_ps(a, b); }
+		static Float Or(Float a, Float b) { return _mm256_or_ps(a, b); }
+		static Float Xor(Float a, Float b) { return _mm256_xor_ps(a, b); }
+
+		static Int ToInt(Float v) { return _mm256_cvttps_epi32(v); }
+		static Float ToFloat(Int v) { return _mm256_cvtepi32_ps(v); }
+		static Float CastToFloat(Int v) { return _mm256_castsi256_ps(v); }
+
+		static Int IntAdd(Int a, Int b) { return _mm256_add_epi32(a, b); }
+		static Int IntSub(Int a, Int b) { return _mm256_sub_epi32(a, b); }
+		static Int IntAnd(Int a, Int b) { return _mm256_and_si256(a, b); }
+		static Int IntAndNot(Int a, Int b) { return _mm256_andnot_si256(a, b); }
+		static Int IntEqual(Int a, Int b) { return _mm256_cmpeq_epi32(a, b); }
+		template<int Bits>
+		static Int ShiftLeft(Int v) { return _mm256_slli_epi32(v, Bits); }
+
+		static void Store(float* dst, Float v) { _mm256_storeu_ps(dst, v); }
+		static void StoreInt(int32_t* dst, Int v) { _mm256_storeu_si256(reinterpret_cast<Int*>(dst), v); }
+	};
+}
+
+uint32_t TessellateArcAvx2(const ArcParams& arc, uint32_t first, uint32_t count, ColoredVertex* out)
+{
+	return TessellationKernel::TessellateArc<Avx2Ops>(arc, first, count, out);
+}
+
+uint32_t SinCosRangeAvx2(float start, float step, uint32_t count, float* sin, float* cos)
+{
+	return TessellationKernel::SinCosRange<Avx2Ops>(start, step, count, sin, cos);
+}
+
+#endif
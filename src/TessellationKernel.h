@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Tessellation.h"
+
+// Kernels shared by the SSE2 and AVX2 translation units, Ops wraps the intrinsics of one
+// instruction set. Every Ops type is defined and used in a single translation unit so the
+// instantiations compiled with different target flags never get merged. For the same reason the
+// kernels don't call any inline function shared with other translation units (glm, std::min),
+// the linker could keep the AVX2 compiled copy for everyone.
+
+static_assert(sizeof(ColoredVertex) == 6 * sizeof(float), "kernels write ColoredVertex as 6 floats");
+
+namespace TessellationKernel
+{
+	// Cephes style sin/cos: reduce by pi/4 into [-pi/4, pi/4] and evaluate both minimax polynomials
+	template<typename Ops>
+	inline void SinCos(typename Ops::Float x, typename Ops::Float& sin, typename Ops::Float& cos)
+	{
+		using F = typename Ops::Float;
+		using I = typename Ops::Int;
+
+		const F signMask = Ops::CastToFloat(Ops::SetInt(static_cast<int32_t>(0x80000000)));
+
+		F signSin = Ops::And(x, signMask);
+		x = Ops::AndNot(signMask, x);
+
+		F y = Ops::Mul(x, Ops::Set(1.27323954473516f)); // 4 / pi
+
+		I quadrant = Ops::ToInt(y);
+		quadrant = Ops::IntAnd(Ops::IntAdd(quadrant, Ops::SetInt(1)), Ops::SetInt(~1));
+		y = Ops::ToFloat(quadrant);
+
+		const F swapSignSin = Ops::CastToFloat(Ops::template ShiftLeft<29>(Ops::IntAnd(quadrant, Ops::SetInt(4))));
+		const F polyMask = Ops::CastToFloat(Ops::IntEqual(Ops::IntAnd(quadrant, Ops::SetInt(2)), Ops::SetInt(0)));
+		const F signCos = Ops::CastToFloat(Ops::template ShiftLeft<29>(
+			Ops::IntAndNot(Ops::IntSub(quadrant, Ops::SetInt(2)), Ops::SetInt(4))));
+		signSin = Ops::Xor(signSin, swapSignSin);
+
+		// Extended precision x - y * pi / 4
+		x = Ops::Add(x, Ops::Mul(y, Ops::Set(-0.78515625f)));
+		x = Ops::Add(x, Ops::Mul(y, Ops::Set(-2.4187564849853515625e-4f)));
+		x = Ops::Add(x, Ops::Mul(y, Ops::Set(-3.77489497744594108e-8f)));
+
+		const F z = Ops::Mul(x, x);
+
+		F polyCos = Ops::Add(Ops::Mul(Ops::Set(2.443315711809948e-5f), z), Ops::Set(-1.388731625493765e-3f));
+		polyCos = Ops::Add(Ops::Mul(polyCos, z), Ops::Set(4.166664568298827e-2f));
+		polyCos = Ops::Mul(Ops::Mul(polyCos, z), z);
+		polyCos = Ops::Sub(polyCos, Ops::Mul(z, Ops::Set(0.5f)));
+		polyCos = Ops::Add(polyCos, Ops::Set(1.f));
+
+		F polySin = Ops::Add(Ops::Mul(Ops::Set(-1.9515295891e-4f), z), Ops::Set(8.3321608736e-3f));
+		polySin = Ops::Add(Ops::Mul(polySin, z), Ops::Set(-1.6666654611e-1f));
+		polySin = Ops::Add(Ops::Mul(Ops::Mul(polySin, z), x), x);
+
+		sin = Ops::Xor(Ops::Or(Ops::And(polyMask, polySin), Ops::AndNot(polyMask, polyCos)), signSin);
+		cos = Ops::Xor(Ops::Or(Ops::And(polyMask, polyCos), Ops::AndNot(polyMask, polySin)), signCos);
+	}
+
+	template<typename Ops>
+	inline typename Ops::Float SampleIndices(uint32_t first)
+	{
+		return Ops::Add(Ops::Set(static_cast<float>(first)), Ops::Ramp());
+	}
+
+	// Returns how many values were written, the caller finishes the tail
+	template<typename Ops>
+	inline uint32_t SinCosRange(float start, float step, uint32_t count, float* sin, float* cos)
+	{
+		constexpr uint32_t Width = Ops::Width;
+
+		uint32_t i = 0;
+		for (; i + Width <= count; i += Width)
+		{
+			const auto angle = Ops::Add(Ops::Set(start), Ops::Mul(SampleIndices<Ops>(i), Ops::Set(step)));
+
+			typename Ops::Float s, c;
+			SinCos<Ops>(angle, s, c);
+			Ops::Store(sin + i, s);
+			Ops::Store(cos + i, c);
+		}
+		return i;
+	}
+
+	template<typename Ops>
+	inline uint32_t TessellateArc(const ArcParams& arc, uint32_t first, uint32_t count, ColoredVertex* out)
+	{
+		using F = typename Ops::Float;
+		constexpr uint32_t Width = Ops::Width;
+
+		alignas(32) float ax[Width], ay[Width], bx[Width], by[Width], frac[Width];
+		alignas(32) int32_t stop[Width];
+
+		const F centerX = Ops::Set(arc.Center.x);
+		const F centerY = Ops::Set(arc.Center.y);
+		const F radiusA = Ops::Set(arc.RadiusA);
+		const F radiusB = Ops::Set(arc.RadiusB);
+		const int32_t lastStop = static_cast<int32_t>(arc.ColorCount) - 1;
+
+		uint32_t i = 0;
+		for (; i + Width <= count; i += Width)
+		{
+			const F sample = SampleIndices<Ops>(first + i);
+			const F angle = Ops::Add(Ops::Set(arc.StartAngle), Ops::Mul(sample, Ops::Set(arc.AngleStep)));
+
+			F s, c;
+			SinCos<Ops>(angle, s, c);
+
+			Ops::Store(ax, Ops::Add(centerX, Ops::Mul(c, radiusA)));
+			Ops::Store(ay, Ops::Add(centerY, Ops::Mul(s, radiusA)));
+			Ops::Store(bx, Ops::Add(centerX, Ops::Mul(c, radiusB)));
+			Ops::Store(by, Ops::Add(centerY, Ops::Mul(s, radiusB)));
+
+			const F colorPos = Ops::Mul(sample, Ops::Set(arc.ColorStep));
+			const auto colorStop = Ops::ToInt(colorPos);
+			Ops::Store(frac, Ops::Sub(colorPos, Ops::ToFloat(colorStop)));
+			Ops::StoreInt(stop, colorStop);
+
+			// Interleave into the vertex layout, the stops are a handful of colors so they're looked up per lane
+			float* dst = reinterpret_cast<float*>(out + i * 2);
+			for (uint32_t lane = 0; lane < Width; lane++, dst += 12)
+			{
+				const auto& from = arc.Colors[stop[lane] < lastStop ? stop[lane] : lastStop];
+				const auto& to = arc.Colors[stop[lane] + 1 < lastStop ? stop[lane] + 1 : lastStop];
+				const float r = (to.x - from.x) * frac[lane] + from.x;
+				const float g = (to.y - from.y) * frac[lane] + from.y;
+				const float b = (to.z - from.z) * frac[lane] + from.z;
+
+				dst[0] = ax[lane]; dst[1] = ay[lane]; dst[2] = 0.f;
+				dst[3] = r; dst[4] = g; dst[5] = b;
+				dst[6] = bx[lane]; dst[7] = by[lane]; dst[8] = 0.f;
+				dst[9] = r; dst[10] = g; dst[11] = b;
+			}
+		}
+		return i;
+	}
+}
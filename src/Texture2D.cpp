@@ -0,0 +1,79 @@
+#include "Texture2D.h"
+
+#include <cassert>
+#include <algorithm>
+
+#include "StateCache.h"
+
+namespace Gl
+{
+	Texture2D::Texture2D(uint32_t width, uint32_t height, GLenum internalFormat, uint32_t levels)
+		:
+		m_Width(width),
+		m_Height(height),
+		m_Levels(levels == 0 ? GetMipLevelCount(width, height) : levels)
+	{
+		assert(width > 0 && height > 0);
+
+		glCreateTextures(GL_TEXTURE_2D, 1, &m_ID);
+		glTextureStorage2D(m_ID, m_Levels, internalFormat, width, height);
+
+		SetFilter(m_Levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR, GL_LINEAR);
+		SetWrap(GL_REPEAT);
+	}
+
+	Texture2D::~Texture2D()
+	{
+		glDeleteTextures(1, &m_ID);
+		StateCache::OnTextureDeleted(m_ID);
+	}
+
+	std::shared_ptr<Texture2D> Texture2D::Create(uint32_t width, uint32_t height, GLenum internalFormat, uint32_t levels)
+	{
+		return std::make_shared<Texture2D>(width, height, internalFormat, levels);
+	}
+
+	uint32_t Texture2D::GetMipLevelCount(uint32_t width, uint32_t height)
+	{
+		uint32_t levels = 1;
+		for (uint32_t size = std::max(width, height); size > 1; size >>= 1)
+		{
+			levels++;
+		}
+		return levels;
+	}
+
+	void Texture2D::SetData(const void* pixels, GLenum format, GLenum type, uint32_t level)
+	{
+		assert(level < m_Levels);
+
+		const uint32_t width = std::max(1u, m_Width >> level);
+		const uint32_t height = std::max(1u, m_Height >> level);
+		glTextureSubImage2D(m_ID, level, 0, 0, width, height, format, type, pixels);
+	}
+
+	void Texture2D::GenerateMipmaps()
+	{
+		if (m_Levels > 1)
+		{
+			glGenerateTextureMipmap(m_ID);
+		}
+	}
+
+	void Texture2D::SetFilter(GLenum minFilter, GLenum magFilter)
+	{
+		glTextureParameteri(m_ID, GL_TEXTURE_MIN_FILTER, minFilter);
+		glTextureParameteri(m_ID, GL_TEXTURE_MAG_FILTER, magFilter);
+	}
+
+	void Texture2D::SetWrap(GLenum wrap)
+	{
+		glTextureParameteri(m_ID, GL_TEXTURE_WRAP_S, wrap);
+		glTextureParameteri(m_ID, GL_TEXTURE_WRAP_T, wrap);
+	}
+
+	void Texture2D::Bind(uint32_t unit) const
+	{
+		StateCache::BindTexture(unit, m_ID);
+	}
+}
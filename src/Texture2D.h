@@ -0,0 +1,45 @@
+#pragma once
+
+#include <memory>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+namespace Gl
+{
+	// Immutable storage 2D texture (glTextureStorage2D), the size and level count are fixed at creation
+	// SetData reads from client memory, or from the bound GL_PIXEL_UNPACK_BUFFER when one is bound,
+	// in which case pixels is an offset into that buffer
+	class Texture2D
+	{
+	public:
+		// levels 0 allocates the full mip chain
+		explicit Texture2D(uint32_t width, uint32_t height, GLenum internalFormat = GL_RGBA8, uint32_t levels = 0);
+		~Texture2D();
+
+		Texture2D(const Texture2D&) = delete;
+		Texture2D& operator=(const Texture2D&) = delete;
+
+		static std::shared_ptr<Texture2D> Create(uint32_t width, uint32_t height, GLenum internalFormat = GL_RGBA8, uint32_t levels = 0);
+		static uint32_t GetMipLevelCount(uint32_t width, uint32_t height);
+
+		void SetData(const void* pixels, GLenum format = GL_RGBA, GLenum type = GL_UNSIGNED_BYTE, uint32_t level = 0);
+		// Fills the levels below 0 from level 0
+		void GenerateMipmaps();
+
+		void SetFilter(GLenum minFilter, GLenum magFilter);
+		void SetWrap(GLenum wrap);
+
+		void Bind(uint32_t unit) const;
+
+		GLuint GetID() const { return m_ID; }
+		uint32_t GetWidth() const { return m_Width; }
+		uint32_t GetHeight() const { return m_Height; }
+		uint32_t GetLevels() const { return m_Levels; }
+	private:
+		GLuint m_ID;
+		uint32_t m_Width;
+		uint32_t m_Height;
+		uint32_t m_Levels;
+	};
+}
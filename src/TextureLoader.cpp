@@ -0,0 +1,299 @@
+#include "TextureLoader.h"
+
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include "StateCache.h"
+
+namespace Gl
+{
+	namespace
+	{
+		// PBOs are allocated in steps so images of similar size can share them
+		constexpr size_t PixelBufferGranularity = 1 << 20;
+
+		bool IsSignaled(GLsync fence)
+		{
+			if (!fence)
+			{
+				return true;
+			}
+
+			const GLenum result = glClientWaitSync(fence, 0, 0);
+			return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+		}
+	}
+
+	void TextureAsset::Bind(uint32_t unit) const
+	{
+		(m_Texture ? m_Texture : m_Fallback)->Bind(unit);
+	}
+
+	TextureLoader::TextureLoader(JobSystem& jobs, size_t uploadBudget)
+		:
+		m_Jobs(jobs),
+		m_UploadBudget(uploadBudget),
+		m_MaxDecodes((jobs.GetWorkerCount() + 1) * 2)
+	{
+		const uint32_t white = 0xffffffff;
+		m_Fallback = Texture2D::Create(1, 1, GL_RGBA8, 1);
+		m_Fallback->SetData(&white);
+	}
+
+	TextureLoader::~TextureLoader()
+	{
+		m_Jobs.Wait(m_DecodeJobs);
+
+		for (auto& staging : m_Staging)
+		{
+			m_Jobs.Wait(staging->Copy);
+			glUnmapNamedBuffer(staging->Buffer.ID);
+			m_PixelBuffers.push_back(staging->Buffer);
+		}
+
+		for (auto& image : m_Decoded)
+		{
+			stbi_image_free(image.Pixels);
+		}
+		for (auto& image : m_Ready)
+		{
+			stbi_image_free(image.Pixels);
+		}
+
+		for (auto& buffer : m_PixelBuffers)
+		{
+			if (buffer.Fence)
+			{
+				glDeleteSync(buffer.Fence);
+			}
+			glDeleteBuffers(1, &buffer.ID);
+			StateCache::OnBufferDeleted(buffer.ID);
+		}
+	}
+
+	TextureHandle TextureLoader::Load(const std::string& path, bool flip)
+	{
+		m_Stats.Requests++;
+
+		const auto it = m_Cache.find(path);
+		if (it != m_Cache.end())
+		{
+			m_Stats.CacheHits++;
+			return it->second;
+		}
+
+		auto asset = std::make_shared<TextureAsset>();
+		asset->m_Path = path;
+		asset->m_Fallback = m_Fallback;
+		m_Cache.emplace(path, asset);
+
+		m_Requests.emplace_back(asset, flip);
+		StartDecodes();
+		return asset;
+	}
+
+	void TextureLoader::StartDecodes()
+	{
+		while (!m_Requests.empty() && m_Decoding + m_Ready.size() < m_MaxDecodes)
+		{
+			auto [asset, flip] = std::move(m_Requests.front());
+			m_Requests.pop_front();
+			m_Decoding++;
+
+			m_Jobs.Run([this, asset, flip]()
+			{
+				stbi_set_flip_vertically_on_load_thread(flip);
+
+				int width = 0, height = 0, channels = 0;
+				uint8_t* pixels = stbi_load(asset->m_Path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+				if (!pixels)
+				{
+					std::cerr << "Error loading texture " << asset->m_Path << ": " << stbi_failure_reason() << "\n";
+				}
+
+				std::lock_guard<std::mutex> lock(m_DecodedMutex);
+				m_Decoded.push_back({ asset, pixels, static_cast<uint32_t>(width), static_cast<uint32_t>(height) });
+			}, m_DecodeJobs);
+		}
+	}
+
+	void TextureLoader::Update()
+	{
+		// Images copied since the last update go to their textures first, their PBOs may be reused below
+		for (auto it = m_Staging.begin(); it != m_Staging.end();)
+		{
+			if ((*it)->Copy.IsDone())
+			{
+				Upload(**it);
+				it = m_Staging.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_DecodedMutex);
+			m_Decoding -= m_Decoded.size();
+			m_Ready.insert(m_Ready.end(), m_Decoded.begin(), m_Decoded.end());
+			m_Decoded.clear();
+		}
+
+		size_t staged = 0;
+		while (!m_Ready.empty())
+		{
+			auto& image = m_Ready.front();
+			if (!image.Pixels)
+			{
+				image.Asset->m_State = TextureAsset::State::Failed;
+				m_Stats.Failed++;
+				m_Ready.pop_front();
+				continue;
+			}
+
+			const size_t size = static_cast<size_t>(image.Width) * image.Height * 4;
+			if (staged > 0 && staged + size > m_UploadBudget)
+			{
+				break;
+			}
+			staged += size;
+
+			auto staging = std::make_unique<Staging>();
+			staging->Image = std::move(image);
+			staging->Buffer = AcquirePixelBuffer(size);
+			m_Ready.pop_front();
+
+			// Not synchronized: the PBO's previous upload has completed (its fence signaled)
+			void* mapped = glMapNamedBufferRange(staging->Buffer.ID, 0, size,
+				GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+			if (!mapped)
+			{
+				std::cerr << "Error mapping pixel buffer for " << staging->Image.Asset->GetPath() << "\n";
+				stbi_image_free(staging->Image.Pixels);
+				staging->Image.Asset->m_State = TextureAsset::State::Failed;
+				m_Stats.Failed++;
+				m_PixelBuffers.push_back(staging->Buffer);
+				continue;
+			}
+
+			Staging* copy = staging.get();
+			m_Jobs.Run([copy, mapped, size]()
+			{
+				std::memcpy(mapped, copy->Image.Pixels, size);
+				stbi_image_free(copy->Image.Pixels);
+				copy->Image.Pixels = nullptr;
+			}, copy->Copy);
+			m_Staging.push_back(std::move(staging));
+		}
+
+		StartDecodes();
+	}
+
+	void TextureLoader::Upload(Staging& staging)
+	{
+		auto& image = staging.Image;
+		auto& buffer = staging.Buffer;
+
+		if (glUnmapNamedBuffer(buffer.ID) == GL_FALSE)
+		{
+			// The mapping was lost (e.g. display mode change), the contents are undefined
+			std::cerr << "Pixel buffer for " << image.Asset->GetPath() << " was corrupted\n";
+			image.Asset->m_State = TextureAsset::State::Failed;
+			m_Stats.Failed++;
+			m_PixelBuffers.push_back(buffer);
+			return;
+		}
+
+		auto texture = Texture2D::Create(image.Width, image.Height, GL_RGBA8);
+		StateCache::BindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.ID);
+		texture->SetData(nullptr);
+		StateCache::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		texture->GenerateMipmaps();
+
+		buffer.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		m_PixelBuffers.push_back(buffer);
+
+		image.Asset->m_Texture = std::move(texture);
+		image.Asset->m_State = TextureAsset::State::Ready;
+		m_Stats.Loaded++;
+		m_Stats.UploadedBytes += static_cast<size_t>(image.Width) * image.Height * 4;
+	}
+
+	TextureLoader::PixelBuffer TextureLoader::AcquirePixelBuffer(size_t size)
+	{
+		// Smallest free buffer that fits
+		auto best = m_PixelBuffers.end();
+		for (auto it = m_PixelBuffers.begin(); it != m_PixelBuffers.end(); ++it)
+		{
+			if (it->Size >= size && (best == m_PixelBuffers.end() || it->Size < best->Size) && IsSignaled(it->Fence))
+			{
+				best = it;
+			}
+		}
+
+		if (best != m_PixelBuffers.end())
+		{
+			PixelBuffer buffer = *best;
+			m_PixelBuffers.erase(best);
+			if (buffer.Fence)
+			{
+				glDeleteSync(buffer.Fence);
+				buffer.Fence = nullptr;
+			}
+			return buffer;
+		}
+
+		PixelBuffer buffer;
+		buffer.Size = (size + PixelBufferGranularity - 1) / PixelBufferGranularity * PixelBufferGranularity;
+		glCreateBuffers(1, &buffer.ID);
+		glNamedBufferData(buffer.ID, buffer.Size, nullptr, GL_STREAM_DRAW);
+		m_Stats.PixelBuffers++;
+		return buffer;
+	}
+
+	void TextureLoader::Finish()
+	{
+		Update();
+		while (!IsIdle())
+		{
+			if (!m_Staging.empty())
+			{
+				m_Jobs.Wait(m_Staging.front()->Copy);
+			}
+			else
+			{
+				m_Jobs.Wait(m_DecodeJobs);
+			}
+			Update();
+		}
+	}
+
+	bool TextureLoader::IsIdle() const
+	{
+		return m_Requests.empty() && m_Decoding == 0 && m_Ready.empty() && m_Staging.empty();
+	}
+
+	size_t TextureLoader::ReleaseUnused()
+	{
+		size_t released = 0;
+		for (auto it = m_Cache.begin(); it != m_Cache.end();)
+		{
+			// Loading assets are also held by the pipeline
+			if (it->second.use_count() == 1)
+			{
+				it = m_Cache.erase(it);
+				released++;
+			}
+			else
+			{
+				++it;
+			}
+		}
+		return released;
+	}
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+#include <glad/glad.h>
+
+#include "JobSystem.h"
+#include "Texture2D.h"
+
+// Loads image files into mipmapped RGBA8 textures without blocking the GL thread
+// Files are decoded with stb_image on the job system. Update (GL thread, once per frame) maps a pixel
+// unpack buffer for every decoded image and hands it to a job that copies the pixels in, the next
+// Update unmaps it, uploads from it and generates the mipmaps, so the GL thread never touches pixels.
+// Uploads are limited to a byte budget per Update, PBOs are reused once the fence after their upload
+// has signaled. Textures are cached by path: loading a path again returns the same handle.
+
+namespace Gl
+{
+	class TextureLoader;
+
+	class TextureAsset
+	{
+	public:
+		enum class State
+		{
+			Loading,
+			Ready,
+			Failed
+		};
+
+		State GetState() const { return m_State; }
+		bool IsReady() const { return m_State == State::Ready; }
+		const std::string& GetPath() const { return m_Path; }
+		// nullptr until ready
+		const std::shared_ptr<Texture2D>& GetTexture() const { return m_Texture; }
+
+		// Binds a 1x1 white texture until the file is loaded (or if it failed)
+		void Bind(uint32_t unit) const;
+		// The texture Bind binds
+		GLuint GetID() const { return (m_Texture ? m_Texture : m_Fallback)->GetID(); }
+	private:
+		friend class TextureLoader;
+
+		std::string m_Path;
+		State m_State{ State::Loading };
+		std::shared_ptr<Texture2D> m_Texture;
+		std::shared_ptr<Texture2D> m_Fallback;
+	};
+
+	// Refcounted, the cache keeps its own reference until ReleaseUnused
+	using TextureHandle = std::shared_ptr<TextureAsset>;
+
+	struct TextureLoaderStats
+	{
+		uint32_t Requests{ 0 };
+		uint32_t CacheHits{ 0 };
+		uint32_t Loaded{ 0 };
+		uint32_t Failed{ 0 };
+		size_t UploadedBytes{ 0 };
+		uint32_t PixelBuffers{ 0 };
+	};
+
+	class TextureLoader
+	{
+	public:
+		static constexpr size_t DefaultUploadBudget = 16 << 20;
+
+		// uploadBudget is the amount of level 0 bytes staged per Update (at least one image goes through)
+		TextureLoader(JobSystem& jobs, size_t uploadBudget = DefaultUploadBudget);
+		~TextureLoader();
+
+		TextureLoader(const TextureLoader&) = delete;
+		TextureLoader& operator=(const TextureLoader&) = delete;
+
+		// flip stores the first row of the file at the bottom, as GL expects
+		TextureHandle Load(const std::string& path, bool flip = true);
+
+		// GL thread, once per frame
+		void Update();
+		// Calls Update until every requested texture is ready or failed (loading screens, tests)
+		void Finish();
+		bool IsIdle() const;
+
+		// Drops the cached textures that aren't referenced anywhere else, returns how many
+		size_t ReleaseUnused();
+
+		size_t GetCacheSize() const { return m_Cache.size(); }
+		const TextureLoaderStats& GetStats() const { return m_Stats; }
+	private:
+		struct Decoded
+		{
+			TextureHandle Asset;
+			uint8_t* Pixels{ nullptr };
+			uint32_t Width{ 0 };
+			uint32_t Height{ 0 };
+		};
+
+		struct PixelBuffer
+		{
+			GLuint ID{ 0 };
+			size_t Size{ 0 };
+			GLsync Fence{ nullptr };
+		};
+
+		// A decoded image being copied into a mapped PBO by a job
+		struct Staging
+		{
+			Decoded Image;
+			PixelBuffer Buffer;
+			JobCounter Copy;
+		};
+
+		void StartDecodes();
+		void Upload(Staging& staging);
+		PixelBuffer AcquirePixelBuffer(size_t size);
+
+		JobSystem& m_Jobs;
+		size_t m_UploadBudget;
+		uint32_t m_MaxDecodes;
+
+		std::unordered_map<std::string, TextureHandle> m_Cache;
+		std::shared_ptr<Texture2D> m_Fallback;
+
+		// Requests wait here until a decode slot is free, so hundreds of files don't queue up at once
+		std::deque<std::pair<TextureHandle, bool>> m_Requests;
+		uint32_t m_Decoding{ 0 };
+		JobCounter m_DecodeJobs;
+
+		// Filled by the decode jobs, moved to m_Ready by Update
+		std::mutex m_DecodedMutex;
+		std::vector<Decoded> m_Decoded;
+		std::deque<Decoded> m_Ready;
+
+		std::deque<std::unique_ptr<Staging>> m_Staging;
+		std::vector<PixelBuffer> m_PixelBuffers;
+
+		TextureLoaderStats m_Stats;
+	};
+}
@@ -0,0 +1,428 @@
+#include "TransformHierarchy.h"
+
+#include <cassert>
+#include <algorithm>
+
+#include "StateCache.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define OPENGLPRJ_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	// Changed matrices closer than this are uploaded together
+	constexpr size_t UploadGap = 16 * sizeof(glm::mat4);
+
+	// Same as translate * mat4_cast(rotation) * scale
+	void ComposeLocal(const glm::vec3& t, const glm::quat& q, const glm::vec3& s, glm::mat4& out)
+	{
+		const float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+		const float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+		const float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+		out[0] = glm::vec4((1.f - 2.f * (yy + zz)) * s.x, 2.f * (xy + wz) * s.x, 2.f * (xz - wy) * s.x, 0.f);
+		out[1] = glm::vec4(2.f * (xy - wz) * s.y, (1.f - 2.f * (xx + zz)) * s.y, 2.f * (yz + wx) * s.y, 0.f);
+		out[2] = glm::vec4(2.f * (xz + wy) * s.z, 2.f * (yz - wx) * s.z, (1.f - 2.f * (xx + yy)) * s.z, 0.f);
+		out[3] = glm::vec4(t.x, t.y, t.z, 1.f);
+	}
+
+	// out = a * b, out doesn't alias a or b
+	struct ScalarMath
+	{
+		static void Multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& out)
+		{
+			for (int column = 0; column < 4; column++)
+			{
+				for (int row = 0; row < 4; row++)
+				{
+					out[column][row] = a[0][row] * b[column][0] + a[1][row] * b[column][1]
+						+ a[2][row] * b[column][2] + a[3][row] * b[column][3];
+				}
+			}
+		}
+	};
+
+#ifdef OPENGLPRJ_SSE2
+	// Every output column is the columns of a weighted by one column of b
+	struct Sse2Math
+	{
+		static void Multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& out)
+		{
+			const float* pa = &a[0][0];
+			const float* pb = &b[0][0];
+			float* po = &out[0][0];
+
+			const __m128 a0 = _mm_loadu_ps(pa);
+			const __m128 a1 = _mm_loadu_ps(pa + 4);
+			const __m128 a2 = _mm_loadu_ps(pa + 8);
+			const __m128 a3 = _mm_loadu_ps(pa + 12);
+
+			for (int column = 0; column < 4; column++)
+			{
+				const __m128 bc = _mm_loadu_ps(pb + column * 4);
+				__m128 r = _mm_mul_ps(a0, _mm_shuffle_ps(bc, bc, _MM_SHUFFLE(0, 0, 0, 0)));
+				r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_shuffle_ps(bc, bc, _MM_SHUFFLE(1, 1, 1, 1))));
+				r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_shuffle_ps(bc, bc, _MM_SHUFFLE(2, 2, 2, 2))));
+				r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_shuffle_ps(bc, bc, _MM_SHUFFLE(3, 3, 3, 3))));
+				_mm_storeu_ps(po + column * 4, r);
+			}
+		}
+	};
+#endif
+
+	struct NodeArrays
+	{
+		const uint32_t* Parents;
+		const glm::vec3* Positions;
+		const glm::quat* Rotations;
+		const glm::vec3* Scales;
+		glm::mat4* World;
+	};
+
+	// A whole subtree, the parent of its root is either outside the range and up to date or Null
+	template<typename Math>
+	void UpdateRange(const NodeArrays& nodes, uint32_t begin, uint32_t end)
+	{
+		glm::mat4 local;
+
+		for (uint32_t i = begin; i < end; i++)
+		{
+			const uint32_t parent = nodes.Parents[i];
+			if (parent == TransformHierarchy::Null)
+			{
+				ComposeLocal(nodes.Positions[i], nodes.Rotations[i], nodes.Scales[i], nodes.World[i]);
+				continue;
+			}
+
+			ComposeLocal(nodes.Positions[i], nodes.Rotations[i], nodes.Scales[i], local);
+			Math::Multiply(nodes.World[parent], local, nodes.World[i]);
+		}
+	}
+
+	template<typename T>
+	void Permute(std::vector<T>& values, const std::vector<uint32_t>& order)
+	{
+		std::vector<T> sorted(values.size());
+		for (size_t i = 0; i < order.size(); i++)
+		{
+			sorted[i] = values[order[i]];
+		}
+		values.swap(sorted);
+	}
+}
+
+TransformHierarchy::~TransformHierarchy()
+{
+	if (m_Buffer != 0)
+	{
+		glDeleteBuffers(1, &m_Buffer);
+		Gl::StateCache::OnBufferDeleted(m_Buffer);
+	}
+}
+
+void TransformHierarchy::Reserve(uint32_t count)
+{
+	m_Parents.reserve(count);
+	m_Positions.reserve(count);
+	m_Rotations.reserve(count);
+	m_Scales.reserve(count);
+	m_World.reserve(count);
+	m_SubtreeEnds.reserve(count);
+	m_Dirty.reserve(count);
+	m_Ids.reserve(count);
+	m_Indices.reserve(count);
+}
+
+TransformHierarchy::NodeId TransformHierarchy::Create(NodeId parent)
+{
+	assert(parent == Null || parent < m_Indices.size());
+
+	const NodeId id = m_Indices.size();
+	const uint32_t index = m_Parents.size();
+	const uint32_t parentIndex = parent == Null ? Null : m_Indices[parent];
+
+	// Still depth first if the parent's subtree is the last one, it and its ancestors grow by one
+	if (parentIndex != Null && !m_OrderDirty)
+	{
+		if (m_SubtreeEnds[parentIndex] == index)
+		{
+			for (uint32_t ancestor = parentIndex; ancestor != Null; ancestor = m_Parents[ancestor])
+			{
+				m_SubtreeEnds[ancestor] = index + 1;
+			}
+		}
+		else
+		{
+			m_OrderDirty = true;
+		}
+	}
+
+	m_Parents.push_back(parentIndex);
+	m_Positions.emplace_back(0.f);
+	m_Rotations.emplace_back(1.f, 0.f, 0.f, 0.f);
+	m_Scales.emplace_back(1.f);
+	m_World.emplace_back(1.f);
+	m_SubtreeEnds.push_back(index + 1);
+	m_Dirty.push_back(0);
+	m_Ids.push_back(id);
+	m_Indices.push_back(index);
+
+	MarkDirty(index);
+	return id;
+}
+
+void TransformHierarchy::SetParent(NodeId id, NodeId parent)
+{
+	assert(id < m_Indices.size() && (parent == Null || parent < m_Indices.size()));
+
+	const uint32_t index = m_Indices[id];
+	const uint32_t parentIndex = parent == Null ? Null : m_Indices[parent];
+
+	for (uint32_t ancestor = parentIndex; ancestor != Null; ancestor = m_Parents[ancestor])
+	{
+		assert(ancestor != index && "SetParent would create a cycle");
+	}
+
+	m_Parents[index] = parentIndex;
+	m_OrderDirty = true;
+}
+
+TransformHierarchy::NodeId TransformHierarchy::GetParent(NodeId id) const
+{
+	const uint32_t parentIndex = m_Parents[m_Indices[id]];
+	return parentIndex == Null ? Null : m_Ids[parentIndex];
+}
+
+void TransformHierarchy::SetPosition(NodeId id, const glm::vec3& position)
+{
+	const uint32_t index = m_Indices[id];
+	m_Positions[index] = position;
+	MarkDirty(index);
+}
+
+void TransformHierarchy::SetRotation(NodeId id, const glm::quat& rotation)
+{
+	const uint32_t index = m_Indices[id];
+	m_Rotations[index] = rotation;
+	MarkDirty(index);
+}
+
+void TransformHierarchy::SetScale(NodeId id, const glm::vec3& scale)
+{
+	const uint32_t index = m_Indices[id];
+	m_Scales[index] = scale;
+	MarkDirty(index);
+}
+
+void TransformHierarchy::SetLocal(NodeId id, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+	const uint32_t index = m_Indices[id];
+	m_Positions[index] = position;
+	m_Rotations[index] = rotation;
+	m_Scales[index] = scale;
+	MarkDirty(index);
+}
+
+void TransformHierarchy::MarkDirty(uint32_t index)
+{
+	if (!m_Dirty[index])
+	{
+		m_Dirty[index] = 1;
+		m_DirtyList.push_back(index);
+	}
+}
+
+void TransformHierarchy::Update()
+{
+	Update(GetSupportedSimdLevel());
+}
+
+void TransformHierarchy::Update(SimdLevel level)
+{
+	if (m_OrderDirty)
+	{
+		Sort();
+	}
+
+	m_Stats.Nodes = m_Parents.size();
+	m_Stats.Updated = 0;
+
+	const NodeArrays nodes{ m_Parents.data(), m_Positions.data(), m_Rotations.data(), m_Scales.data(), m_World.data() };
+	level = std::min(level, GetSupportedSimdLevel());
+
+	// In index order a dirty node inside a subtree that's already recomputed is skipped
+	std::sort(m_DirtyList.begin(), m_DirtyList.end());
+	uint32_t end = 0;
+	for (const uint32_t index : m_DirtyList)
+	{
+		m_Dirty[index] = 0;
+		if (index < end)
+		{
+			continue;
+		}
+		end = m_SubtreeEnds[index];
+
+#ifdef OPENGLPRJ_SSE2
+		if (level >= SimdLevel::Sse2)
+		{
+			UpdateRange<Sse2Math>(nodes, index, end);
+		}
+		else
+#endif
+		{
+			UpdateRange<ScalarMath>(nodes, index, end);
+		}
+
+		m_UploadRanges.Add(index * sizeof(glm::mat4), end * sizeof(glm::mat4));
+		m_Stats.Updated += end - index;
+	}
+	m_DirtyList.clear();
+}
+
+void TransformHierarchy::Sort()
+{
+	const uint32_t count = m_Parents.size();
+
+	// Children of every node, in index order
+	std::vector<uint32_t> offsets(count + 1, 0);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (m_Parents[i] != Null)
+		{
+			offsets[m_Parents[i] + 1]++;
+		}
+	}
+	for (uint32_t i = 0; i < count; i++)
+	{
+		offsets[i + 1] += offsets[i];
+	}
+
+	std::vector<uint32_t> children(offsets[count]);
+	std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (m_Parents[i] != Null)
+		{
+			children[cursor[m_Parents[i]]++] = i;
+		}
+	}
+
+	// order[new index] = old index
+	std::vector<uint32_t> order;
+	order.reserve(count);
+	std::vector<uint32_t> stack;
+	for (uint32_t root = 0; root < count; root++)
+	{
+		if (m_Parents[root] != Null)
+		{
+			continue;
+		}
+
+		stack.push_back(root);
+		while (!stack.empty())
+		{
+			const uint32_t node = stack.back();
+			stack.pop_back();
+			order.push_back(node);
+
+			for (uint32_t child = offsets[node + 1]; child > offsets[node]; child--)
+			{
+				stack.push_back(children[child - 1]);
+			}
+		}
+	}
+	assert(order.size() == count);
+
+	std::vector<uint32_t> newIndices(count);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		newIndices[order[i]] = i;
+	}
+
+	Permute(m_Parents, order);
+	for (auto& parent : m_Parents)
+	{
+		if (parent != Null)
+		{
+			parent = newIndices[parent];
+		}
+	}
+	Permute(m_Positions, order);
+	Permute(m_Rotations, order);
+	Permute(m_Scales, order);
+	Permute(m_Ids, order);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		m_Indices[m_Ids[i]] = i;
+	}
+
+	// Subtree sizes summed from the back, children come after their parent
+	for (uint32_t i = 0; i < count; i++)
+	{
+		m_SubtreeEnds[i] = 1;
+	}
+	for (uint32_t i = count; i-- > 0;)
+	{
+		if (m_Parents[i] != Null)
+		{
+			m_SubtreeEnds[m_Parents[i]] += m_SubtreeEnds[i];
+		}
+	}
+	for (uint32_t i = 0; i < count; i++)
+	{
+		m_SubtreeEnds[i] += i;
+	}
+
+	// Every world matrix moved, recompute and upload all of them
+	std::fill(m_Dirty.begin(), m_Dirty.end(), 0);
+	m_DirtyList.clear();
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (m_Parents[i] == Null)
+		{
+			MarkDirty(i);
+		}
+	}
+	m_OrderDirty = false;
+}
+
+void TransformHierarchy::Upload()
+{
+	m_Stats.Uploads = 0;
+	m_Stats.UploadedBytes = 0;
+
+	const size_t size = m_World.size() * sizeof(glm::mat4);
+	if (size == 0)
+	{
+		return;
+	}
+
+	if (m_Buffer == 0)
+	{
+		glCreateBuffers(1, &m_Buffer);
+	}
+
+	if (size > m_Capacity)
+	{
+		m_Capacity = std::max(size, m_Capacity * 2);
+		glNamedBufferData(m_Buffer, m_Capacity, nullptr, GL_DYNAMIC_DRAW);
+		m_UploadRanges.Clear();
+		m_UploadRanges.Add(0, size);
+	}
+
+	const auto* bytes = reinterpret_cast<const uint8_t*>(m_World.data());
+	for (const auto& range : m_UploadRanges.Coalesce(size, UploadGap))
+	{
+		glNamedBufferSubData(m_Buffer, range.Begin, range.End - range.Begin, bytes + range.Begin);
+		m_Stats.Uploads++;
+		m_Stats.UploadedBytes += range.End - range.Begin;
+	}
+	m_UploadRanges.Clear();
+}
+
+void TransformHierarchy::Bind(GLuint binding) const
+{
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, m_Buffer);
+}
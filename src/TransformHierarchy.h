@@ -0,0 +1,102 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "DirtyRanges.h"
+#include "SimdLevel.h"
+
+// Parent/child transforms stored as structure of arrays in depth first order, so every subtree is a
+// contiguous range that starts with its root. Changing a local transform puts the node on a dirty
+// list, Update recomputes the range of every dirty subtree front to back and never touches the
+// clean nodes, the cost follows the changed subtrees.
+// Node ids are stable. Creating nodes in depth first order (or as children of the last subtree)
+// keeps the arrays sorted, other creations and SetParent re-sort everything on the next Update.
+// Upload copies the changed world matrices into a shader storage buffer in coalesced ranges,
+// shaders index it with GetIndex (see shaders/transform.vert).
+
+struct TransformStats
+{
+	uint32_t Nodes{ 0 };
+	uint32_t Updated{ 0 };
+	uint32_t Uploads{ 0 };
+	size_t UploadedBytes{ 0 };
+};
+
+class TransformHierarchy
+{
+public:
+	using NodeId = uint32_t;
+	static constexpr uint32_t Null = ~0u;
+	static constexpr GLuint StorageBinding = 1;
+
+	TransformHierarchy() = default;
+	~TransformHierarchy();
+
+	TransformHierarchy(const TransformHierarchy&) = delete;
+	TransformHierarchy& operator=(const TransformHierarchy&) = delete;
+
+	void Reserve(uint32_t count);
+	// Identity local transform
+	NodeId Create(NodeId parent = Null);
+	void SetParent(NodeId id, NodeId parent);
+	NodeId GetParent(NodeId id) const;
+
+	void SetPosition(NodeId id, const glm::vec3& position);
+	void SetRotation(NodeId id, const glm::quat& rotation);
+	void SetScale(NodeId id, const glm::vec3& scale);
+	void SetLocal(NodeId id, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+	const glm::vec3& GetPosition(NodeId id) const { return m_Positions[m_Indices[id]]; }
+	const glm::quat& GetRotation(NodeId id) const { return m_Rotations[m_Indices[id]]; }
+	const glm::vec3& GetScale(NodeId id) const { return m_Scales[m_Indices[id]]; }
+
+	// As of the last Update
+	const glm::mat4& GetWorld(NodeId id) const { return m_World[m_Indices[id]]; }
+	// Index of the node's world matrix in GetWorldMatrices and the storage buffer, changes when re-sorted
+	uint32_t GetIndex(NodeId id) const { return m_Indices[id]; }
+	// The node's descendants are at [GetIndex(id) + 1, GetSubtreeEnd(id)), as of the last Update
+	uint32_t GetSubtreeEnd(NodeId id) const { return m_SubtreeEnds[m_Indices[id]]; }
+	const glm::mat4* GetWorldMatrices() const { return m_World.data(); }
+	uint32_t GetCount() const { return m_Parents.size(); }
+
+	void Update();
+	void Update(SimdLevel level);
+
+	// Needs a GL context, the buffer is created on the first call
+	void Upload();
+	void Bind(GLuint binding = StorageBinding) const;
+	GLuint GetBufferID() const { return m_Buffer; }
+
+	// Of the last Update and Upload
+	const TransformStats& GetStats() const { return m_Stats; }
+private:
+	void MarkDirty(uint32_t index);
+	// Depth first order, puts every root on the dirty list
+	void Sort();
+
+	// All indexed by array index
+	std::vector<uint32_t> m_Parents;
+	std::vector<glm::vec3> m_Positions;
+	std::vector<glm::quat> m_Rotations;
+	std::vector<glm::vec3> m_Scales;
+	std::vector<glm::mat4> m_World;
+	std::vector<uint32_t> m_SubtreeEnds;
+	std::vector<uint8_t> m_Dirty; // on the dirty list
+	std::vector<NodeId> m_Ids;
+
+	// Node id to array index
+	std::vector<uint32_t> m_Indices;
+
+	std::vector<uint32_t> m_DirtyList;
+	bool m_OrderDirty{ false };
+
+	DirtyRanges m_UploadRanges;
+	GLuint m_Buffer{ 0 };
+	size_t m_Capacity{ 0 };
+
+	TransformStats m_Stats;
+};
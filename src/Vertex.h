@@ -2,6 +2,8 @@
 
 #include <glm/glm.hpp>
 
+#include "VertexEncoding.h"
+
 using Vertex1f = float;
 using Vertex2f = glm::vec2;
 using Vertex3f = glm::vec3;
@@ -16,6 +18,27 @@ using Vertex1b = bool;
 
 static constexpr int VertexTypeCount = 11;
 
+// Interleaved vertex matching a { Float3 position, Float3 color } layout
+struct ColoredVertex
+{
+	Vertex3f Position;
+	Vertex3f Color;
+};
+
+// Interleaved vertex matching a { Half4 position, normalized UByte4 color } layout
+// 12 bytes instead of the 24 of ColoredVertex
+struct CompactColoredVertex
+{
+	HalfPosition Position;
+	uint32_t Color;
+
+	CompactColoredVertex() = default;
+	CompactColoredVertex(const glm::vec3& position, const glm::vec3& color)
+		: Position(position), Color(PackUnorm4x8(glm::vec4(color, 1.f)))
+	{
+	}
+};
+
 // matrices not supported as of now
 template<typename T>
 constexpr int GetVertexSize()
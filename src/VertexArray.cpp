@@ -2,6 +2,8 @@
 
 #include <assert.h>
 
+#include "StateCache.h"
+
 namespace Gl
 {
 	VertexArray::VertexArray()
@@ -12,6 +14,7 @@ namespace Gl
 	VertexArray::~VertexArray()
 	{
 		glDeleteVertexArrays(1, &m_ID);
+		StateCache::OnVertexArrayDeleted(m_ID);
 	}
 
 	std::shared_ptr<VertexArray> VertexArray::Create()
@@ -21,20 +24,13 @@ namespace Gl
 
 	void VertexArray::Bind() const
 	{
-		if (m_IndexBuffer)
-		{
-			m_IndexBuffer->Bind();
-		}
-		if (m_VertexBuffer)
-		{
-			m_VertexBuffer->Bind();
-		}
-		glBindVertexArray(m_ID);
+		// The element buffer is attached to the VAO with DSA, binding the VAO is enough
+		StateCache::BindVertexArray(m_ID);
 	}
 
 	void VertexArray::Unbind() const
 	{
-		glBindVertexArray(0);
+		StateCache::BindVertexArray(0);
 	}
 
 	void VertexArray::AddVertexBuffer(const std::shared_ptr<VertexBuffer>& buffer)
@@ -45,6 +41,8 @@ namespace Gl
 		Bind();
 		buffer->Bind();
 
+		auto& attributes = m_Attributes.emplace_back();
+
 		for (const auto& element : layout.GetElements())
 		{
 			switch (element.Type)
@@ -58,21 +56,49 @@ namespace Gl
 			case ShaderDataType::Int3:
 			case ShaderDataType::Int4:
 			case ShaderDataType::Bool:
+			case ShaderDataType::Half2:
+			case ShaderDataType::Half4:
+			case ShaderDataType::Byte4:
+			case ShaderDataType::UByte4:
+			case ShaderDataType::Short2:
+			case ShaderDataType::Short4:
+			case ShaderDataType::UShort2:
+			case ShaderDataType::UShort4:
+			case ShaderDataType::Int2_10_10_10:
+			case ShaderDataType::UInt2_10_10_10:
 			{
-				glVertexAttribPointer(m_BufferIndex,
-					element.GetComponentCount(),
-					OpenGLBaseType(element.Type),
-					element.Normalized ? GL_TRUE : GL_FALSE,
-					layout.GetStride(),
-					(const void*)element.Offset);
+				if (element.IsInteger())
+				{
+					glVertexAttribIPointer(m_BufferIndex,
+						element.GetComponentCount(),
+						OpenGLBaseType(element.Type),
+						layout.GetStride(),
+						(const void*)element.Offset);
+				}
+				else
+				{
+					glVertexAttribPointer(m_BufferIndex,
+						element.GetComponentCount(),
+						OpenGLBaseType(element.Type),
+						element.Normalized ? GL_TRUE : GL_FALSE,
+						layout.GetStride(),
+						(const void*)element.Offset);
+				}
 				glEnableVertexAttribArray(m_BufferIndex);
+				if (element.Divisor)
+				{
+					glVertexAttribDivisor(m_BufferIndex, element.Divisor);
+				}
+				attributes.push_back({ m_BufferIndex, element.Offset, layout.GetStride() });
 				m_BufferIndex++;
 				break;
 			}
 			case ShaderDataType::Mat3:
 			case ShaderDataType::Mat4:
 			{
-				uint8_t count = element.GetComponentCount();
+				// Matrices are per instance unless a divisor is given
+				const uint32_t divisor = element.Divisor ? element.Divisor : 1;
+				const uint8_t count = element.GetComponentCount();
 				for (uint8_t i = 0; i < count; i++)
 				{
 					glVertexAttribPointer(m_BufferIndex,
@@ -80,9 +106,10 @@ namespace Gl
 						OpenGLBaseType(element.Type),
 						element.Normalized ? GL_TRUE : GL_FALSE,
 						layout.GetStride(),
-						(const void*)(sizeof(float) * count * i));
+						(const void*)(element.Offset + sizeof(float) * count * i));
 					glEnableVertexAttribArray(m_BufferIndex);
-					glVertexAttribDivisor(m_BufferIndex, 1);
+					glVertexAttribDivisor(m_BufferIndex, divisor);
+					attributes.push_back({ m_BufferIndex, element.Offset + sizeof(float) * count * i, layout.GetStride() });
 					m_BufferIndex++;
 				}
 				break;
@@ -96,8 +123,25 @@ namespace Gl
 
 	void VertexArray::SetIndexBuffer(const std::shared_ptr<IndexBuffer>& buffer)
 	{
-		Bind();
-		buffer->Bind();
+		StateCache::VertexArrayElementBuffer(m_ID, buffer->GetID());
 		m_IndexBuffer = buffer;
 	}
+
+	void VertexArray::SetVertexBufferStorage(uint32_t bufIdx, GLuint buffer, size_t offset)
+	{
+		assert(bufIdx < m_Attributes.size());
+
+		// glVertexAttribPointer keeps the attribute offset in the binding with the same index
+		for (const auto& attribute : m_Attributes[bufIdx])
+		{
+			glVertexArrayVertexBuffer(m_ID, attribute.Index, buffer, offset + attribute.Offset, attribute.Stride);
+		}
+	}
+
+	void VertexArray::SetElementBuffer(GLuint buffer)
+	{
+		m_IndexBuffer.reset();
+		m_ElementBuffer = buffer;
+		StateCache::VertexArrayElementBuffer(m_ID, buffer);
+	}
 }
\ No newline at end of file
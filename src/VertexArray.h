@@ -23,6 +23,16 @@ namespace Gl
 			GL_FLOAT,	//	Mat3, 3 * float3
 			GL_FLOAT,	//	Mat4, 4 * float4
 			GL_BOOL,	//	Bool
+			GL_HALF_FLOAT,		//	Half2
+			GL_HALF_FLOAT,		//	Half4
+			GL_BYTE,			//	Byte4
+			GL_UNSIGNED_BYTE,	//	UByte4
+			GL_SHORT,			//	Short2
+			GL_SHORT,			//	Short4
+			GL_UNSIGNED_SHORT,	//	UShort2
+			GL_UNSIGNED_SHORT,	//	UShort4
+			GL_INT_2_10_10_10_REV,			//	Int2_10_10_10
+			GL_UNSIGNED_INT_2_10_10_10_REV,	//	UInt2_10_10_10
 		};
 
 		if (type == ShaderDataType::None)
@@ -44,14 +54,28 @@ namespace Gl
 
 		void Bind() const;
 		void Unbind() const;
+		GLuint GetID() const { return m_ID; }
 
 		void AddVertexBuffer(const std::shared_ptr<VertexBuffer>& buf);
 		void SetIndexBuffer(const std::shared_ptr<IndexBuffer>& buffer);
+
+		// Points the attributes of the bufIdx-th added vertex buffer at another buffer/offset (streaming)
+		void SetVertexBufferStorage(uint32_t bufIdx, GLuint buffer, size_t offset);
+		// Element buffer that isn't owned by an IndexBuffer
+		void SetElementBuffer(GLuint buffer);
 	private:
+		struct Attribute
+		{
+			uint32_t Index;
+			size_t Offset;
+			uint32_t Stride;
+		};
+
 		uint32_t m_ID;
 		uint32_t m_BufferIndex{ 0 };
+		std::vector<std::vector<Attribute>> m_Attributes; // per added vertex buffer
 		uint32_t m_Stride;
-		std::shared_ptr<VertexBuffer> m_VertexBuffer;
 		std::shared_ptr<IndexBuffer> m_IndexBuffer;
+		GLuint m_ElementBuffer{ 0 };
 	};
 }
@@ -1,13 +1,17 @@
 #include "VertexBuffer.h"
 
+#include <cassert>
+#include <algorithm>
+
 #include <glad/glad.h>
 
+#include "StateCache.h"
+
 namespace Gl
 {
 	void VertexBuffer::CreateBuffer()
 	{
 		glCreateBuffers(1, &m_BufferID);
-		glBindBuffer(GL_ARRAY_BUFFER, m_BufferID);
 	}
 
 	VertexBuffer::VertexBuffer(void* vertices, size_t size, const BufferLayout& layout, bool dynamic)
@@ -16,7 +20,8 @@ namespace Gl
 		m_Dynamic(dynamic)
 	{
 		CreateBuffer();
-		glBufferData(GL_ARRAY_BUFFER, size, vertices, dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+		glNamedBufferData(m_BufferID, size, vertices, dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+		m_Capacity = size;
 	}
 
 	VertexBuffer::VertexBuffer(std::vector<float>& vertices, const BufferLayout& layout, bool dynamic)
@@ -25,7 +30,8 @@ namespace Gl
 		m_Dynamic(dynamic)
 	{
 		CreateBuffer();
-		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), &vertices[0], dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+		glNamedBufferData(m_BufferID, vertices.size() * sizeof(float), &vertices[0], dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+		m_Capacity = vertices.size() * sizeof(float);
 	}
 
 	VertexBuffer::VertexBuffer(const BufferLayout& layout)
@@ -39,6 +45,7 @@ namespace Gl
 	VertexBuffer::~VertexBuffer()
 	{
 		glDeleteBuffers(1, &m_BufferID);
+		StateCache::OnBufferDeleted(m_BufferID);
 	}
 
 	std::shared_ptr<VertexBuffer> VertexBuffer::Create(const BufferLayout& layout)
@@ -54,30 +61,45 @@ namespace Gl
 	}
 
 
-	void VertexBuffer::SetData(void* vertices, size_t size)
+	void VertexBuffer::SetData(const void* vertices, size_t size)
 	{
 		if (!m_Dynamic) return;
-		Bind();
-		glBufferData(GL_ARRAY_BUFFER, size, vertices, GL_DYNAMIC_DRAW);
+		glNamedBufferData(m_BufferID, size, vertices, GL_DYNAMIC_DRAW);
+		m_Capacity = size;
 	}
 
-	void VertexBuffer::UpdateSubData(void* vertices, size_t size)
+	void VertexBuffer::UpdateSubData(const void* vertices, size_t offset, size_t size)
 	{
-		// TODO: Finish this
+		assert(offset + size <= m_Capacity);
+		glNamedBufferSubData(m_BufferID, offset, size, vertices);
+	}
+
+	bool VertexBuffer::EnsureCapacity(size_t size)
+	{
+		if (size <= m_Capacity)
+		{
+			return false;
+		}
+
+		m_Capacity = std::max(size, m_Capacity * 2);
+		glNamedBufferData(m_BufferID, m_Capacity, nullptr, m_Dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+		return true;
 	}
 
 	void VertexBuffer::Bind() const
 	{
-		glBindBuffer(GL_ARRAY_BUFFER, m_BufferID);
+		StateCache::BindBuffer(GL_ARRAY_BUFFER, m_BufferID);
 	}
 
 	void VertexBuffer::Unbind() const
 	{
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		StateCache::BindBuffer(GL_ARRAY_BUFFER, 0);
 	}
 
+	// Releases the storage, the buffer object stays valid for new data
 	void VertexBuffer::Clear()
 	{
-		glDeleteBuffers(1, &m_BufferID);
+		glNamedBufferData(m_BufferID, 0, nullptr, GL_DYNAMIC_DRAW);
+		m_Capacity = 0;
 	}
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <cstdint>
 #include <glad/glad.h>
 
@@ -19,16 +20,21 @@ namespace Gl
 		static std::shared_ptr<VertexBuffer> Create(void* vertices, size_t size, const BufferLayout& layout);
 
 		const BufferLayout& GetLayout() const { return m_Layout; };
+		unsigned GetID() const { return m_BufferID; }
 
-		void SetData(void* vertices, size_t size);
-		void UpdateSubData(void* vertices, size_t size);
+		void SetData(const void* vertices, size_t size);
+		// offset and size in bytes, the range has to fit in the current capacity
+		void UpdateSubData(const void* vertices, size_t offset, size_t size);
+		// Grows the storage geometrically, returns true if it was reallocated (previous contents are lost)
+		bool EnsureCapacity(size_t size);
+		size_t GetCapacity() const { return m_Capacity; }
 
 		template<typename T>
 		void SetData(std::vector<T>& vertices, size_t count)
 		{
 			if (!m_Dynamic) return;
-			Bind();
-			glBufferData(GL_ARRAY_BUFFER, count * sizeof(T), &vertices[0], GL_DYNAMIC_DRAW);
+			glNamedBufferData(m_BufferID, count * sizeof(T), &vertices[0], GL_DYNAMIC_DRAW);
+			m_Capacity = count * sizeof(T);
 		}
 
 		void Bind() const override;
@@ -40,6 +46,7 @@ namespace Gl
 
 		bool m_Dynamic{ false };
 		unsigned m_BufferID;
+		size_t m_Capacity{ 0 };
 		BufferLayout m_Layout;
 	};
 }
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include <glm/glm.hpp>
+
+// Encoders for the compact ShaderDataTypes, results are laid out the way GL reads them
+// (first component in the lowest bits/bytes on little endian machines)
+// Normalized conversions follow the GL 4.2+ rules: unorm c = round(v * (2^b - 1)),
+// snorm c = round(v * (2^(b-1) - 1)), so -1, 0 and 1 are exact for signed values.
+
+// Round to nearest even, overflows to infinity, keeps NaN
+inline uint16_t EncodeHalf(float value)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+
+	const uint32_t sign = (bits >> 16) & 0x8000;
+	const uint32_t abs = bits & 0x7fffffff;
+
+	if (abs > 0x7f800000)
+	{
+		return sign | 0x7e00;
+	}
+
+	// 65536 and up, the rounding below carries everything from 65520 into infinity
+	if (abs >= 0x47800000)
+	{
+		return sign | 0x7c00;
+	}
+
+	// Below the smallest normal half, shift the mantissa with its implicit bit into a subnormal
+	if (abs < 0x38800000)
+	{
+		if (abs < 0x33000000)
+		{
+			return sign;
+		}
+
+		const uint32_t shift = 126 - (abs >> 23);
+		const uint32_t mantissa = (abs & 0x7fffff) | 0x800000;
+		const uint32_t remainder = mantissa & ((1u << shift) - 1);
+		const uint32_t halfway = 1u << (shift - 1);
+
+		uint32_t half = mantissa >> shift;
+		if (remainder > halfway || (remainder == halfway && (half & 1)))
+		{
+			half++;
+		}
+		return sign | half;
+	}
+
+	// Rebias the exponent from 127 to 15 and drop 13 mantissa bits
+	uint32_t half = (abs >> 13) - (112 << 10);
+	const uint32_t remainder = abs & 0x1fff;
+	if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+	{
+		half++;
+	}
+	return sign | half;
+}
+
+// Exact, every half is representable as a float
+inline float DecodeHalf(uint16_t half)
+{
+	const uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+	const uint32_t exponent = (half >> 10) & 0x1f;
+	uint32_t mantissa = half & 0x3ff;
+
+	uint32_t bits;
+	if (exponent == 0x1f)
+	{
+		bits = sign | 0x7f800000 | (mantissa << 13);
+	}
+	else if (exponent != 0)
+	{
+		bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	}
+	else if (mantissa == 0)
+	{
+		bits = sign;
+	}
+	else
+	{
+		// Subnormal half, normal float: shift the leading bit into the implicit one
+		uint32_t floatExponent = 113;
+		while (!(mantissa & 0x400))
+		{
+			mantissa <<= 1;
+			floatExponent--;
+		}
+		bits = sign | (floatExponent << 23) | ((mantissa & 0x3ff) << 13);
+	}
+
+	float value;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+inline uint32_t EncodeUnorm(float value, uint32_t bits)
+{
+	const float max = static_cast<float>((1u << bits) - 1);
+	const float clamped = value < 0.f ? 0.f : (value > 1.f ? 1.f : value);
+	return static_cast<uint32_t>(std::floor(clamped * max + 0.5f));
+}
+
+// Two's complement in the low bits of the result
+inline uint32_t EncodeSnorm(float value, uint32_t bits)
+{
+	const float max = static_cast<float>((1u << (bits - 1)) - 1);
+	const float clamped = value < -1.f ? -1.f : (value > 1.f ? 1.f : value);
+	const auto encoded = static_cast<int32_t>(std::floor(clamped * max + 0.5f));
+	return static_cast<uint32_t>(encoded) & ((1u << bits) - 1);
+}
+
+// Normalized UByte4, e.g. colors
+inline uint32_t PackUnorm4x8(const glm::vec4& value)
+{
+	return EncodeUnorm(value.x, 8) | EncodeUnorm(value.y, 8) << 8 | EncodeUnorm(value.z, 8) << 16 | EncodeUnorm(value.w, 8) << 24;
+}
+
+// Normalized Byte4
+inline uint32_t PackSnorm4x8(const glm::vec4& value)
+{
+	return EncodeSnorm(value.x, 8) | EncodeSnorm(value.y, 8) << 8 | EncodeSnorm(value.z, 8) << 16 | EncodeSnorm(value.w, 8) << 24;
+}
+
+// Normalized UShort2, e.g. texture coordinates
+inline uint32_t PackUnorm2x16(const glm::vec2& value)
+{
+	return EncodeUnorm(value.x, 16) | EncodeUnorm(value.y, 16) << 16;
+}
+
+// Normalized Short2
+inline uint32_t PackSnorm2x16(const glm::vec2& value)
+{
+	return EncodeSnorm(value.x, 16) | EncodeSnorm(value.y, 16) << 16;
+}
+
+// Normalized Int2_10_10_10, e.g. normals and tangents with the handedness in w
+inline uint32_t PackSnorm1010102(const glm::vec4& value)
+{
+	return EncodeSnorm(value.x, 10) | EncodeSnorm(value.y, 10) << 10 | EncodeSnorm(value.z, 10) << 20 | EncodeSnorm(value.w, 2) << 30;
+}
+
+// Normalized UInt2_10_10_10
+inline uint32_t PackUnorm1010102(const glm::vec4& value)
+{
+	return EncodeUnorm(value.x, 10) | EncodeUnorm(value.y, 10) << 10 | EncodeUnorm(value.z, 10) << 20 | EncodeUnorm(value.w, 2) << 30;
+}
+
+// Half4 with w = 1, positions don't need more than 11 bits of mantissa when they stay in clip space range
+struct HalfPosition
+{
+	uint16_t Value[4];
+
+	HalfPosition() = default;
+	HalfPosition(const glm::vec3& position)
+		: Value{ EncodeHalf(position.x), EncodeHalf(position.y), EncodeHalf(position.z), EncodeHalf(1.f) }
+	{
+	}
+};
@@ -0,0 +1,205 @@
+#include "VertexWelder.h"
+
+#include <cmath>
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+
+#include "VertexArray.h"
+
+namespace
+{
+	constexpr uint32_t EmptySlot = 0xffffffff;
+
+	struct Slot
+	{
+		uint32_t Hash;
+		uint32_t Vertex;
+	};
+
+	uint64_t ComponentKey(const WeldStream& stream, uint32_t vertex, uint32_t component)
+	{
+		const float value = stream.Data[static_cast<size_t>(vertex) * stream.VertexLength + component];
+
+		if (!stream.Epsilons.empty() && stream.Epsilons[component] > 0.f)
+		{
+			return static_cast<uint64_t>(static_cast<int64_t>(std::floor(static_cast<double>(value) / stream.Epsilons[component] + 0.5)));
+		}
+
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	uint32_t HashVertex(const std::vector<WeldStream>& streams, uint32_t vertex)
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
+		for (const auto& stream : streams)
+		{
+			for (uint32_t c = 0; c < stream.VertexLength; c++)
+			{
+				hash = (hash ^ ComponentKey(stream, vertex, c)) * 0x100000001b3ull;
+			}
+		}
+
+		// Fold the high bits in, the table index uses the low ones
+		hash ^= hash >> 29;
+		hash *= 0xbf58476d1ce4e5b9ull;
+		hash ^= hash >> 32;
+		return static_cast<uint32_t>(hash);
+	}
+
+	bool VerticesEqual(const std::vector<WeldStream>& streams, uint32_t a, uint32_t b)
+	{
+		for (const auto& stream : streams)
+		{
+			if (stream.Epsilons.empty())
+			{
+				const float* dataA = stream.Data + static_cast<size_t>(a) * stream.VertexLength;
+				const float* dataB = stream.Data + static_cast<size_t>(b) * stream.VertexLength;
+				if (std::memcmp(dataA, dataB, stream.VertexLength * sizeof(float)) != 0)
+				{
+					return false;
+				}
+				continue;
+			}
+
+			for (uint32_t c = 0; c < stream.VertexLength; c++)
+			{
+				if (ComponentKey(stream, a, c) != ComponentKey(stream, b, c))
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+}
+
+std::vector<float> VertexWelder::LayoutEpsilons(const Gl::BufferLayout& layout, const std::vector<float>& elementEpsilons)
+{
+	std::vector<float> epsilons(layout.GetStride() / sizeof(float), 0.f);
+
+	// Compact elements are compared bit for bit, they can share a word with their neighbours
+	const auto& elements = layout.GetElements();
+	for (size_t i = 0; i < elements.size() && i < elementEpsilons.size(); i++)
+	{
+		const auto& element = elements[i];
+		if (Gl::OpenGLBaseType(element.Type) != GL_FLOAT || element.Offset % sizeof(float) != 0)
+		{
+			continue;
+		}
+
+		const size_t first = element.Offset / sizeof(float);
+		std::fill_n(epsilons.begin() + first, element.Size / sizeof(float), elementEpsilons[i]);
+	}
+
+	return epsilons;
+}
+
+std::vector<uint32_t> VertexWelder::GenerateRemap(const std::vector<WeldStream>& streams, uint32_t vertexCount, uint32_t& weldedCount)
+{
+	for (const auto& stream : streams)
+	{
+		assert(stream.Epsilons.empty() || stream.Epsilons.size() == stream.VertexLength);
+	}
+
+	// Power of two capacity at most 2/3 full
+	size_t capacity = 16;
+	while (capacity < vertexCount + vertexCount / 2)
+	{
+		capacity *= 2;
+	}
+	const size_t mask = capacity - 1;
+
+	std::vector<Slot> table(capacity, { 0, EmptySlot });
+	std::vector<uint32_t> remap(vertexCount);
+	weldedCount = 0;
+
+	for (uint32_t v = 0; v < vertexCount; v++)
+	{
+		const uint32_t hash = HashVertex(streams, v);
+		size_t slot = hash & mask;
+
+		while (true)
+		{
+			auto& entry = table[slot];
+
+			if (entry.Vertex == EmptySlot)
+			{
+				entry = { hash, v };
+				remap[v] = weldedCount++;
+				break;
+			}
+
+			if (entry.Hash == hash && VerticesEqual(streams, entry.Vertex, v))
+			{
+				remap[v] = remap[entry.Vertex];
+				break;
+			}
+
+			slot = (slot + 1) & mask;
+		}
+	}
+
+	return remap;
+}
+
+void VertexWelder::RemapStream(const WeldStream& stream, uint32_t vertexCount, const std::vector<uint32_t>& remap)
+{
+	assert(remap.size() == vertexCount);
+
+	// New vertices are numbered in order of first occurrence and never move forward, in place is safe
+	const size_t vertexSize = stream.VertexLength * sizeof(float);
+	uint32_t written = 0;
+	for (uint32_t v = 0; v < vertexCount; v++)
+	{
+		if (remap[v] == written)
+		{
+			if (v != written)
+			{
+				std::memcpy(stream.Data + static_cast<size_t>(written) * stream.VertexLength,
+					stream.Data + static_cast<size_t>(v) * stream.VertexLength, vertexSize);
+			}
+			written++;
+		}
+	}
+}
+
+WeldReport VertexWelder::Weld(const std::vector<WeldStream>& streams, uint32_t vertexCount, std::vector<uint32_t>& indices)
+{
+	WeldReport report;
+	report.VertexCount = vertexCount;
+
+	const auto remap = GenerateRemap(streams, vertexCount, report.WeldedCount);
+
+	for (const auto& stream : streams)
+	{
+		RemapStream(stream, vertexCount, remap);
+	}
+
+	if (indices.empty())
+	{
+		indices = remap;
+		return report;
+	}
+
+	for (auto& index : indices)
+	{
+		assert(index < vertexCount);
+		index = remap[index];
+	}
+
+	return report;
+}
+
+WeldReport VertexWelder::Weld(MeshData& mesh, uint32_t vertexLength, const std::vector<float>& epsilons)
+{
+	assert(mesh.Vertices.size() % vertexLength == 0);
+
+	const uint32_t vertexCount = mesh.Vertices.size() / vertexLength;
+	const auto report = Weld({ { mesh.Vertices.data(), vertexLength, epsilons } }, vertexCount, mesh.Indices);
+
+	mesh.Vertices.resize(static_cast<size_t>(report.WeldedCount) * vertexLength);
+	return report;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "Buffer.h"
+#include "MeshData.h"
+
+// Merges duplicated vertices and rewrites the indices to point at the one that's kept
+// A vertex can be spread over several interleaved float streams (one per vertex buffer), two vertices
+// are merged only when they match in all of them. Components with an epsilon are snapped to a grid of
+// that size before comparing, the rest have to be bit identical. The first vertex of every group is kept.
+// Lookups go through an open addressing table of (hash, vertex) pairs with linear probing, so most
+// probes never touch the vertex data.
+
+struct WeldStream
+{
+	float* Data;
+	uint32_t VertexLength; // floats per vertex
+	std::vector<float> Epsilons; // one per float of a vertex, empty to compare the whole stream exactly
+};
+
+struct WeldReport
+{
+	uint32_t VertexCount{ 0 };
+	uint32_t WeldedCount{ 0 };
+};
+
+class VertexWelder
+{
+public:
+	// Expands one epsilon per layout element to one per 32 bit word, missing and non float elements compare exactly
+	static std::vector<float> LayoutEpsilons(const Gl::BufferLayout& layout, const std::vector<float>& elementEpsilons);
+
+	// Old to new vertex map, new vertices are numbered in order of their first occurrence
+	static std::vector<uint32_t> GenerateRemap(const std::vector<WeldStream>& streams, uint32_t vertexCount, uint32_t& weldedCount);
+
+	// Compacts every stream in place with the remap from GenerateRemap
+	static void RemapStream(const WeldStream& stream, uint32_t vertexCount, const std::vector<uint32_t>& remap);
+
+	// Welds the streams and rewrites the indices, a mesh without indices gets them generated
+	// The streams' storage isn't resized, only the first WeldedCount vertices are valid afterwards
+	static WeldReport Weld(const std::vector<WeldStream>& streams, uint32_t vertexCount, std::vector<uint32_t>& indices);
+
+	// Welds a single stream mesh, vertexLength is in floats
+	static WeldReport Weld(MeshData& mesh, uint32_t vertexLength, const std::vector<float>& epsilons = {});
+};
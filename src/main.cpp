@@ -1,16 +1,52 @@
 #include "OpenGLPrj.hpp"
 
 #include <cstdio>
+#include <algorithm>
 #include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <cstring>
+#include <cctype>
 #include <functional>
+#include <random>
+#include <numeric>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
 #include <array>
+#include <filesystem>
 
 #include "StaticMesh.h"
 #include "DynamicMesh.h"
 #include "Shader.h"
+#include "ShaderBatch.h"
+#include "ShaderCache.h"
+#include "ShaderWatcher.h"
+#include "Benchmark.h"
+#include "Framebuffer.h"
+#include "Profiler.h"
+#include "BatchRenderer.h"
+#include "StateCache.h"
+#include "RenderQueue.h"
+#include "JobSystem.h"
+#include "MeshData.h"
+#include "Tessellation.h"
+#include "MeshOptimizer.h"
+#include "VertexWelder.h"
+#include "MeshFile.h"
+#include "MeshImporter.h"
+#include "TextureLoader.h"
+#include "FramePipeline.h"
+#include "SpriteScene.h"
+#include "QuadBatch.h"
+#include "Scene.h"
+#include "TransformHierarchy.h"
+
+#ifdef OPENGLPRJ_HEADLESS
+#include "HeadlessContext.h"
+#endif
 
 template<typename T>
 using Ptr = std::unique_ptr<T>;
@@ -28,59 +64,70 @@ float lerp(float a, float b, float t)
     return (b - a) * t + a;
 }
 
-DMeshPtr CreatePie(const glm::vec3& clr, const glm::vec2& pos, int samples, float sAngle, float eAngle, float sRadius, float eRadius)
+// Mesh building only fills MeshData and never touches GL, it runs on the job system
+// and UploadMesh creates the GL objects on the main thread afterwards
+
+const Gl::BufferLayout ColoredLayout({
+    { Gl::ShaderDataType::Float3, "position" },
+    { Gl::ShaderDataType::Float3, "color" }
+});
+
+// Same attributes as ColoredLayout in half the size, see CompactColoredVertex
+const Gl::BufferLayout CompactColoredLayout({
+    { Gl::ShaderDataType::Half4, "position" },
+    { Gl::ShaderDataType::UByte4, "color", true }
+});
+
+// Imported meshes keep position and color first so the triangle shader can draw them
+const Gl::BufferLayout ImportedMeshLayout({
+    { Gl::ShaderDataType::Float3, "position" },
+    { Gl::ShaderDataType::UByte4, "color", true },
+    { Gl::ShaderDataType::Int2_10_10_10, "normal", true },
+    { Gl::ShaderDataType::Half2, "uv" }
+});
+
+DMeshPtr UploadMesh(const Gl::BufferLayout& layout, MeshData&& data)
 {
-    auto mesh = std::make_unique<DynamicMesh>(Gl::BufferLayout({
-        { Gl::ShaderDataType::Float3, "position" },
-        { Gl::ShaderDataType::Float3, "color" }
-        }));
-
-    mesh->SetDrawType(GL_TRIANGLE_STRIP);
-
-    float angleRange = eAngle - sAngle;
-    for (int i = 0; i < samples; i++)
-    {
-        float dA = ((1.f * i) / (samples - 1)) * angleRange + sAngle;
+    auto mesh = std::make_unique<DynamicMesh>(layout);
+    mesh->SetMeshData(std::move(data));
+    mesh->Flush();
+    return mesh;
+}
 
-        float x = glm::cos(dA);
-        float y = glm::sin(dA);
+MeshData BuildPie(const glm::vec3& clr, const glm::vec2& pos, int samples, float sAngle, float eAngle, float sRadius, float eRadius)
+{
+    MeshData mesh;
+    mesh.DrawType = GL_TRIANGLE_STRIP;
 
-        mesh->AddVertex(glm::vec3{ pos.x + x * sRadius, pos.y + y * sRadius, 0.f });
-        mesh->AddVertex(clr);
-        mesh->AddVertex(glm::vec3{ pos.x + x * eRadius, pos.y + y * eRadius, 0.f });
-        mesh->AddVertex(clr);
-    }
+    auto vertices = mesh.AppendVertices<ColoredVertex>(samples * 2);
 
-    mesh->FlushVertexData();
+    const ArcParams arc{ pos, sAngle, (eAngle - sAngle) / (samples - 1), sRadius, eRadius, &clr, 1, 0.f };
+    TessellateArc(arc, 0, samples, vertices.GetData());
 
-    return std::move(mesh);
+    return mesh;
 };
 
-inline void CreateQuad(const DMeshPtr& mesh, glm::vec3& clr, std::array<glm::vec3, 4> points)
+template<typename V = ColoredVertex>
+inline void BuildQuad(MeshData& mesh, const glm::vec3& clr, std::array<glm::vec3, 4> points)
 {
-    mesh->AddVertex(points[0]);
-    auto p0 = mesh->AddVertex(clr);
-    mesh->AddVertex(points[1]);
-    auto p1 = mesh->AddVertex(clr);
-    mesh->AddVertex(points[2]);
-    auto p2 = mesh->AddVertex(clr);
-    mesh->AddVertex(points[3]);
-    auto p3 = mesh->AddVertex(clr);
-
-    mesh->ConnectVertices(p0, p1, p2);
-    mesh->ConnectVertices(p2, p3, p0);
+    static constexpr uint32_t indices[] = { 0, 1, 2, 2, 3, 0 };
+
+    auto vertices = mesh.AppendVertices<V>(4);
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        vertices.Set(i, { points[i], clr });
+    }
+
+    mesh.AddIndices(vertices.GetBaseIndex(), indices, 6);
 }
 
-DMeshPtr CreateCircle()
+// The samples are independent, chunks of them are generated in parallel
+MeshData BuildCircle(JobSystem& jobs)
 {
-    auto mesh = std::make_unique<DynamicMesh>(Gl::BufferLayout({
-        { Gl::ShaderDataType::Float3, "position" },
-        { Gl::ShaderDataType::Float3, "color" }
-    }));
+    MeshData mesh;
+    mesh.DrawType = GL_TRIANGLE_STRIP;
 
-    mesh->SetDrawType(GL_TRIANGLE_STRIP);
-
-    std::vector<glm::vec3> colors{
+    static const glm::vec3 colors[]{
         { 1.f, 0.f, 0.f },
         { 1.f, 1.f, 0.f },
         { 0.f, 1.f, 0.f },
@@ -93,49 +140,27 @@ DMeshPtr CreateCircle()
     const float radius = 0.5;
     const int samples = 360;
 
-    float clrAcc = 0;
-    const float clrStep = (1.f * colors.size() - 1) / samples;
-
-    for (int i = 0; i < samples; i++)
-    {
-        const unsigned sClrIdx = glm::floor(clrAcc);
-        const unsigned eClrIdx = glm::ceil(clrAcc);
-        const float fracClr = clrAcc - sClrIdx;
+    constexpr uint32_t colorCount = sizeof(colors) / sizeof(colors[0]);
+    const float clrStep = (1.f * colorCount - 1) / samples;
 
-        float angle = (1.f * i / (samples - 1)) * (PI * 2);
+    auto vertices = mesh.AppendVertices<ColoredVertex>(samples * 2);
 
-        glm::vec3 clr{
-            lerp(colors[sClrIdx].r, colors[eClrIdx].r, fracClr),
-            lerp(colors[sClrIdx].g, colors[eClrIdx].g, fracClr),
-            lerp(colors[sClrIdx].b, colors[eClrIdx].b, fracClr),
-        };
+    // Outer edge then the center for every sample
+    const ArcParams arc{ { 0.f, 0.f }, 0.f, PI * 2 / (samples - 1), radius, 0.f, colors, colorCount, clrStep };
 
-        mesh->AddVertex(glm::vec3{ 
-            glm::cos(angle) * radius,
-            glm::sin(angle) * radius,
-            0.f
-        });
-
-        mesh->AddVertex(clr);
-        mesh->AddVertex(glm::vec3{ 0.f, 0.f, 0.f });
-        mesh->AddVertex(clr);
-
-        clrAcc += clrStep;
-    }
-
-    mesh->FlushVertexData();
+    jobs.ParallelFor(samples, 64, [&](uint32_t begin, uint32_t end)
+    {
+        TessellateArc(arc, begin, end - begin, vertices.GetData() + begin * 2);
+    });
 
-    return std::move(mesh);
+    return mesh;
 }
 
-DMeshPtr CreateGradients()
+MeshData BuildGradients()
 {
-    auto mesh = std::make_unique<DynamicMesh>(Gl::BufferLayout({
-		{ Gl::ShaderDataType::Float3, "position" },
-		{ Gl::ShaderDataType::Float3, "color" }
-    }));
+    MeshData mesh;
 
-    static constexpr auto CreateGradient = [](const DMeshPtr& mesh, int steps, const glm::vec2& pos, const glm::vec2& size, std::array<glm::vec3, 2> clrs)
+    static constexpr auto BuildGradient = [](MeshData& mesh, int steps, const glm::vec2& pos, const glm::vec2& size, std::array<glm::vec3, 2> clrs)
     {
         const float clrStep = (clrs.size() - 1) * 1.f / steps;
 
@@ -155,7 +180,7 @@ DMeshPtr CreateGradients()
                 lerp(clrs[prevClr].b, clrs[nextClr].b, fracClr),
             };
 
-            CreateQuad(mesh, clr, {
+            BuildQuad<CompactColoredVertex>(mesh, clr, {
                 glm::vec3{ xOffset, pos.y, 0.f },
                 glm::vec3{ xOffset + xStep, pos.y, 0.f },
                 glm::vec3{ xOffset + xStep, pos.y + size.y, 0.f },
@@ -167,49 +192,42 @@ DMeshPtr CreateGradients()
         }
     };
 
-    CreateGradient(mesh, 10, { -0.8f, 0.6f }, { 1.6f, 0.2f }, {
+    BuildGradient(mesh, 10, { -0.8f, 0.6f }, { 1.6f, 0.2f }, {
         glm::vec3{ 0.f, 0.f, 0.f },
         glm::vec3{ 1.f, 0.f, 0.f }
     });
 
-    CreateGradient(mesh, 10, { -0.8f, 0.2f }, { 1.6f, 0.2f }, {
+    BuildGradient(mesh, 10, { -0.8f, 0.2f }, { 1.6f, 0.2f }, {
 		glm::vec3{ 0.f, 0.f, 0.f },
     	glm::vec3{ 0.f, 1.f, 0.f }
     });
 
-    CreateGradient(mesh, 10, { -0.8f, -0.2f }, { 1.6f, 0.2f }, {
+    BuildGradient(mesh, 10, { -0.8f, -0.2f }, { 1.6f, 0.2f }, {
 		glm::vec3{ 0.f, 0.f, 0.f },
 		glm::vec3{ 0.f, 0.f, 1.f }
     });
 
-    mesh->Flush();
-
-    return std::move(mesh);
+    return mesh;
 }
 
-std::vector<DMeshPtr> CreateLogo()
+MeshData BuildLogoBar()
 {
-    std::vector<DMeshPtr> vec;
+    MeshData mesh;
     glm::vec3 clr{ 1.f, 1.f, 1.f };
 
-    auto mesh = std::make_unique<DynamicMesh>(Gl::BufferLayout({
-        { Gl::ShaderDataType::Float3, "position" },
-        { Gl::ShaderDataType::Float3, "color" }
-    }));
-
-    CreateQuad(mesh, clr, {
+    BuildQuad(mesh, clr, {
         glm::vec3{ -0.8f, 0.8f, 0.f },
         glm::vec3{ -0.6f, 0.8f, 0.f },
         glm::vec3{ -0.6f, -0.8f, 0.f },
         glm::vec3{ -0.8f, -0.8f, 0.f },
     });
 
-    mesh->Flush();
-
-    vec.push_back(std::move(mesh));
-    vec.push_back(CreatePie({ 1.f, 1.f, 1.f }, { 0.4f, 0.f }, 60, 0.f, 2 * PI, 0.6, 0.8));
+    return mesh;
+}
 
-    return vec;
+MeshData BuildLogoPie()
+{
+    return BuildPie({ 1.f, 1.f, 1.f }, { 0.4f, 0.f }, 60, 0.f, 2 * PI, 0.6, 0.8);
 }
 
 DMeshPtr CreateCheckerTriangle()
@@ -232,68 +250,744 @@ DMeshPtr CreateCheckerTriangle()
     return std::move(mesh);
 }
 
+struct QuadInstance
+{
+    glm::vec2 Offset;
+    float Scale;
+    glm::vec3 Color;
+};
+
+const Gl::BufferLayout QuadInstanceLayout({
+    { Gl::ShaderDataType::Float2, "offset" },
+    { Gl::ShaderDataType::Float, "scale" },
+    { Gl::ShaderDataType::Float3, "color" }
+}, 1);
+
+// Offset/scale/color of every quad of the instanced scene, rows are generated in parallel
+MeshData BuildQuadInstances(JobSystem& jobs, uint32_t columns, uint32_t rows)
+{
+    MeshData instanceData;
+
+    const glm::vec2 cell{ 1.8f / columns, 1.8f / rows };
+    auto instances = instanceData.AppendVertices<QuadInstance>(columns * rows);
+
+    jobs.ParallelFor(rows, 16, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t y = begin; y < end; y++)
+        {
+            for (uint32_t x = 0; x < columns; x++)
+            {
+                const float u = (1.f * x) / columns;
+                const float v = (1.f * y) / rows;
+
+                instances.Set(y * columns + x, {
+                    { -0.9f + (x + 0.5f) * cell.x, -0.9f + (y + 0.5f) * cell.y },
+                    glm::min(cell.x, cell.y) * 0.8f,
+                    { u, v, 1.f - u }
+                });
+            }
+        }
+    });
+
+    return instanceData;
+}
+
+MeshData BuildUnitQuad()
+{
+    MeshData mesh;
+    glm::vec3 clr{ 1.f, 1.f, 1.f };
+
+    BuildQuad(mesh, clr, {
+        glm::vec3{ -0.5f, -0.5f, 0.f },
+        glm::vec3{ 0.5f, -0.5f, 0.f },
+        glm::vec3{ 0.5f, 0.5f, 0.f },
+        glm::vec3{ -0.5f, 0.5f, 0.f },
+    });
+
+    return mesh;
+}
+
+// Time of every SIMD level against the scalar reference, no GL needed
+void BenchmarkTessellation()
+{
+    static const glm::vec3 colors[]{ { 1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f }, { 0.f, 0.f, 1.f } };
+    const SimdLevel levels[]{ SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Avx2 };
+
+    printf("%-10s %-8s %12s %10s %12s\n", "samples", "kernel", "ms", "speedup", "max error");
+
+    for (uint32_t samples = 1000; samples <= 1000000; samples *= 10)
+    {
+        const ArcParams arc{ { 0.f, 0.f }, 0.f, PI * 2 / (samples - 1), 0.5f, 0.8f, colors, 3, 2.f / samples };
+
+        std::vector<ColoredVertex> reference(samples * 2);
+        std::vector<ColoredVertex> vertices(samples * 2);
+        TessellateArc(arc, 0, samples, reference.data(), SimdLevel::Scalar);
+
+        double scalarMs = 0.0;
+        for (auto level : levels)
+        {
+            if (level > GetSupportedSimdLevel())
+                continue;
+
+            // Best of enough runs to cover ~10M samples
+            const uint32_t runs = std::max(3u, 10000000 / samples);
+            double bestMs = 1e9;
+            for (uint32_t run = 0; run < runs; run++)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                TessellateArc(arc, 0, samples, vertices.data(), level);
+                const std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+                bestMs = std::min(bestMs, time.count());
+            }
+
+            if (level == SimdLevel::Scalar)
+                scalarMs = bestMs;
+
+            float maxError = 0.f;
+            const auto* expected = reinterpret_cast<const float*>(reference.data());
+            const auto* actual = reinterpret_cast<const float*>(vertices.data());
+            for (size_t i = 0; i < vertices.size() * 6; i++)
+                maxError = std::max(maxError, std::abs(expected[i] - actual[i]));
+
+            printf("%-10u %-8s %12.4f %9.2fx %12g\n", samples, GetSimdLevelName(level), bestMs, scalarMs / bestMs, maxError);
+        }
+    }
+}
+
+// 1M nodes in an 8-ary tree, a full update and then frames that turn 2% of the nodes, no GL needed
+void BenchmarkTransforms()
+{
+    const uint32_t count = 1000000, frames = 20;
+    const SimdLevel levels[]{ SimdLevel::Scalar, SimdLevel::Sse2 };
+    const glm::vec3 axis{ 0.f, 0.f, 1.f };
+
+    printf("%-8s %10s %10s %10s %12s %10s\n", "kernel", "nodes", "full ms", "frame ms", "updated", "max error");
+
+    std::vector<glm::mat4> reference;
+    for (auto level : levels)
+    {
+        if (level > GetSupportedSimdLevel())
+            continue;
+
+        // Same seed for every level, every level sees the same changes
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> random(-1.f, 1.f);
+
+        TransformHierarchy transforms;
+        transforms.Reserve(count);
+        for (uint32_t i = 0; i < count; i++) {
+            const auto node = transforms.Create(i == 0 ? TransformHierarchy::Null : (i - 1) / 8);
+            transforms.SetLocal(node, { random(rng), random(rng), 0.f }, glm::angleAxis(random(rng), axis), glm::vec3(0.9f));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        transforms.Update(level);
+        const std::chrono::duration<double, std::milli> fullTime = std::chrono::steady_clock::now() - start;
+
+        std::chrono::duration<double, std::milli> frameTime{ 0.0 };
+        uint64_t updated = 0;
+        for (uint32_t frame = 0; frame < frames; frame++) {
+            for (uint32_t i = 0; i < count / 50; i++)
+                transforms.SetRotation(rng() % count, glm::angleAxis(random(rng), axis));
+
+            start = std::chrono::steady_clock::now();
+            transforms.Update(level);
+            frameTime += std::chrono::steady_clock::now() - start;
+            updated += transforms.GetStats().Updated;
+        }
+
+        const glm::mat4* world = transforms.GetWorldMatrices();
+        if (level == SimdLevel::Scalar)
+            reference.assign(world, world + count);
+
+        float maxError = 0.f;
+        const auto* expected = reinterpret_cast<const float*>(reference.data());
+        const auto* actual = reinterpret_cast<const float*>(world);
+        for (size_t i = 0; i < size_t(count) * 16; i++)
+            maxError = std::max(maxError, std::abs(expected[i] - actual[i]));
+
+        printf("%-8s %10u %10.3f %10.3f %12llu %10g\n", GetSimdLevelName(level), count, fullTime.count(),
+            frameTime.count() / frames, static_cast<unsigned long long>(updated / frames), maxError);
+    }
+}
+
+// Grid of quads built one quad at a time like the scenes do, welded into a shared vertex grid, then
+// optimized as generated (row by row) and with the triangles shuffled
+void BenchmarkMeshOptimizer()
+{
+    printf("%-10s %-9s %10s %10s %10s %10s %10s %10s %10s\n", "triangles", "order", "vertices", "welded", "acmr", "atvr", "opt acmr", "opt atvr", "ms");
+
+    for (uint32_t size = 32; size <= 512; size *= 4)
+    {
+        MeshData grid;
+        glm::vec3 clr{ 1.f, 1.f, 1.f };
+        const float step = 2.f / size;
+        for (uint32_t y = 0; y < size; y++)
+        {
+            for (uint32_t x = 0; x < size; x++)
+            {
+                const float left = x * step - 1.f;
+                const float bottom = y * step - 1.f;
+                BuildQuad(grid, clr, {
+                    glm::vec3{ left, bottom, 0.f },
+                    glm::vec3{ left + step, bottom, 0.f },
+                    glm::vec3{ left + step, bottom + step, 0.f },
+                    glm::vec3{ left, bottom + step, 0.f },
+                });
+            }
+        }
+
+        // left + step and the next quad's left can round differently, positions are snapped to a fraction of a quad
+        const auto vertexLength = VertexWriter<ColoredVertex>::VertexLength;
+        const auto welding = VertexWelder::Weld(grid, vertexLength, VertexWelder::LayoutEpsilons(ColoredLayout, { step / 64 }));
+
+        MeshData shuffled = grid;
+        std::vector<uint32_t> triangles(shuffled.Indices.size() / 3);
+        std::iota(triangles.begin(), triangles.end(), 0);
+        std::shuffle(triangles.begin(), triangles.end(), std::mt19937(size));
+        for (uint32_t t = 0; t < triangles.size(); t++)
+            std::copy_n(&grid.Indices[triangles[t] * 3], 3, &shuffled.Indices[t * 3]);
+
+        for (auto* mesh : { &grid, &shuffled })
+        {
+            const auto start = std::chrono::steady_clock::now();
+            const auto report = MeshOptimizer::Optimize(*mesh, vertexLength);
+            const std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+
+            printf("%-10zu %-9s %10u %10u %10.3f %10.3f %10.3f %10.3f %10.3f\n", mesh->Indices.size() / 3, mesh == &grid ? "rows" : "shuffled",
+                welding.VertexCount, welding.WeldedCount, report.Before.Acmr, report.Before.Atvr, report.After.Acmr, report.After.Atvr, time.count());
+        }
+    }
+}
+
+// Imports an OBJ or PLY file and writes it as a mapped mesh file, then maps it back to check it
+bool ConvertMesh(const std::string& input, const std::string& output)
+{
+    JobSystem jobs;
+    MeshImporter importer(jobs);
+
+    MeshData mesh;
+    if (!importer.Import(input, ImportedMeshLayout, mesh))
+        return false;
+
+    const auto& stats = importer.GetStats();
+    printf("Imported %s: %u vertices, %u triangles, %.1f MB in %.1f ms (%.1f MB/s) on %u threads\n", input.c_str(),
+        stats.Vertices, stats.Triangles, stats.Bytes / 1e6, stats.Ms, stats.Bytes / 1e3 / stats.Ms, jobs.GetWorkerCount() + 1);
+
+    if (!MeshFile::Write(output, mesh, ImportedMeshLayout))
+        return false;
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto file = MeshFile::Open(output);
+    const std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+    if (!file)
+        return false;
+
+    printf("Wrote %s: %.1f MB, mapped and validated in %.3f ms (run with --mesh to time the upload)\n", output.c_str(), file->GetFileSize() / 1e6, time.count());
+    return true;
+}
+
+// Maps a converted mesh file and uploads its blobs to the GL buffers straight from the mapped pages
+SMeshPtr LoadMeshFile(const std::string& path)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const auto file = MeshFile::Open(path);
+    if (!file)
+        return nullptr;
+    const auto mapped = std::chrono::steady_clock::now();
+
+    auto mesh = file->CreateStaticMesh();
+    // The driver may copy out of the pages lazily, the time has to cover the whole upload
+    glFinish();
+    const auto uploaded = std::chrono::steady_clock::now();
+
+    const std::chrono::duration<double, std::milli> mapTime = mapped - start;
+    const std::chrono::duration<double, std::milli> uploadTime = uploaded - mapped;
+    fprintf(stderr, "Loaded %s: %.1f MB, mapped and validated in %.3f ms, uploaded in %.3f ms (%.1f MB/s)\n", path.c_str(),
+        file->GetFileSize() / 1e6, mapTime.count(), uploadTime.count(), file->GetFileSize() / 1e3 / uploadTime.count());
+    return mesh;
+}
+
+struct Options
+{
+    bool headless = false;
+    uint32_t frames = 500;
+    std::string csv;
+    std::string profileCsv;
+    bool shaderCache = true;
+    bool benchTessellation = false;
+    bool benchMeshOptimizer = false;
+    bool benchTransforms = false;
+    bool pipeline = true;
+    std::string convertInput;
+    std::string convertOutput;
+    std::string textureDir;
+    std::string meshFile;
+};
+
+Options ParseOptions(int argc, char * argv[])
+{
+    Options options;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--headless") == 0)
+            options.headless = true;
+        else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            options.frames = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--csv") == 0 && i + 1 < argc)
+            options.csv = argv[++i];
+        else if (std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
+            options.profileCsv = argv[++i];
+        else if (std::strcmp(argv[i], "--no-shader-cache") == 0)
+            options.shaderCache = false;
+        else if (std::strcmp(argv[i], "--bench-tessellation") == 0)
+            options.benchTessellation = true;
+        else if (std::strcmp(argv[i], "--bench-mesh-optimizer") == 0)
+            options.benchMeshOptimizer = true;
+        else if (std::strcmp(argv[i], "--bench-transforms") == 0)
+            options.benchTransforms = true;
+        else if (std::strcmp(argv[i], "--no-pipeline") == 0)
+            options.pipeline = false;
+        else if (std::strcmp(argv[i], "--textures") == 0 && i + 1 < argc)
+            options.textureDir = argv[++i];
+        else if (std::strcmp(argv[i], "--mesh") == 0 && i + 1 < argc)
+            options.meshFile = argv[++i];
+        else if (std::strcmp(argv[i], "--convert-mesh") == 0 && i + 2 < argc) {
+            options.convertInput = argv[++i];
+            options.convertOutput = argv[++i];
+        }
+        else
+            fprintf(stderr, "Unknown argument %s\n", argv[i]);
+    }
+
+    return options;
+}
+
 int main(int argc, char * argv[]) {
 
-    // Load GLFW and Create a Window
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-    glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
-    auto mWindow = glfwCreateWindow(mWidth, mHeight, "OpenGL", nullptr, nullptr);
-
-    // Check for Valid Context
-    if (mWindow == nullptr) { 
-        fprintf(stderr, "Failed to Create OpenGL Context");
+    const auto options = ParseOptions(argc, argv);
+
+    if (options.benchTessellation) {
+        BenchmarkTessellation();
+        return EXIT_SUCCESS;
+    }
+
+    if (options.benchMeshOptimizer) {
+        BenchmarkMeshOptimizer();
+        return EXIT_SUCCESS;
+    }
+
+    if (options.benchTransforms) {
+        BenchmarkTransforms();
+        return EXIT_SUCCESS;
+    }
+
+    if (!options.convertInput.empty())
+        return ConvertMesh(options.convertInput, options.convertOutput) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    GLFWwindow* mWindow = nullptr;
+#ifdef OPENGLPRJ_HEADLESS
+    HeadlessContext headlessContext;
+#endif
+
+    if (options.headless) {
+#ifdef OPENGLPRJ_HEADLESS
+        if (!headlessContext.Create(4, 0)) {
+            fprintf(stderr, "Failed to Create a Headless OpenGL Context");
+            return EXIT_FAILURE;
+        }
+#else
+        fprintf(stderr, "Built without EGL, headless mode is not available\n");
         return EXIT_FAILURE;
+#endif
     }
+    else {
+        // Load GLFW and Create a Window
+        glfwInit();
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+        glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
+        mWindow = glfwCreateWindow(mWidth, mHeight, "OpenGL", nullptr, nullptr);
+
+        // Check for Valid Context
+        if (mWindow == nullptr) { 
+            fprintf(stderr, "Failed to Create OpenGL Context");
+            return EXIT_FAILURE;
+        }
 
-    // Create Context and Load OpenGL Functions
-    glfwMakeContextCurrent(mWindow);
-    gladLoadGL();
+        // Create Context and Load OpenGL Functions
+        glfwMakeContextCurrent(mWindow);
+        gladLoadGL();
+    }
     fprintf(stderr, "OpenGL %s\n", glGetString(GL_VERSION));
 
-    auto shader = Gl::Shader::FromFiles("shaders/triangle.vert", "shaders/triangle.frag");
-    auto checkerShader = Gl::Shader::FromFiles("shaders/checker.vert", "shaders/checker.frag");
-
-    auto logo = CreateLogo();
-	auto gradients = CreateGradients();
-    auto circle = CreateCircle();
+    if (options.shaderCache)
+        Gl::ShaderCache::SetDirectory("shader_cache");
+
+    // Compiles in the background (when the driver supports it) while the meshes are built
+    const auto shaderLoadStart = std::chrono::steady_clock::now();
+    Gl::ShaderBatch shaderBatch;
+    auto shader = shaderBatch.Add("shaders/triangle.vert", "shaders/triangle.frag");
+    auto checkerShader = shaderBatch.Add("shaders/checker.vert", "shaders/checker.frag");
+    auto batchShader = shaderBatch.Add("shaders/batch.vert", "shaders/batch.frag");
+    auto instancedShader = shaderBatch.Add("shaders/instanced.vert", "shaders/instanced.frag");
+    auto quadShader = shaderBatch.Add("shaders/quad.vert", "shaders/quad.frag");
+    auto sceneShader = shaderBatch.Add("shaders/scene.vert", "shaders/triangle.frag");
+    auto transformShader = shaderBatch.Add("shaders/transform.vert", "shaders/triangle.frag");
+    std::chrono::duration<double, std::milli> shaderLoadTime = std::chrono::steady_clock::now() - shaderLoadStart;
+
+    // Independent meshes are built as separate jobs, the big ones also split their own work
+    const auto meshBuildStart = std::chrono::steady_clock::now();
+    JobSystem jobs;
+    JobCounter meshJobs;
+    MeshData logoBarData, logoPieData, gradientsData, circleData, quadData, quadInstanceData;
+    jobs.Run([&]() { logoBarData = BuildLogoBar(); }, meshJobs);
+    jobs.Run([&]() { logoPieData = BuildLogoPie(); }, meshJobs);
+    jobs.Run([&]() { gradientsData = BuildGradients(); }, meshJobs);
+    jobs.Run([&]() { circleData = BuildCircle(jobs); }, meshJobs);
+    jobs.Run([&]() { quadData = BuildUnitQuad(); }, meshJobs);
+    jobs.Run([&]() { quadInstanceData = BuildQuadInstances(jobs, 320, 320); }, meshJobs);
+    jobs.Wait(meshJobs);
+    const std::chrono::duration<double, std::milli> meshBuildTime = std::chrono::steady_clock::now() - meshBuildStart;
+    fprintf(stderr, "Meshes built in %.3f ms on %u threads\n", meshBuildTime.count(), jobs.GetWorkerCount() + 1);
+
+    std::vector<DMeshPtr> logo;
+    logo.push_back(UploadMesh(ColoredLayout, std::move(logoBarData)));
+    logo.push_back(UploadMesh(ColoredLayout, std::move(logoPieData)));
+    // Shared with the culling scene
+    std::shared_ptr<DynamicMesh> gradients = UploadMesh(CompactColoredLayout, std::move(gradientsData));
+    std::shared_ptr<DynamicMesh> circle = UploadMesh(ColoredLayout, std::move(circleData));
     auto checkers = CreateCheckerTriangle();
 
+    // A file written with --convert-mesh, drawn over the circle as is
+    SMeshPtr loadedMesh;
+    if (!options.meshFile.empty()) {
+        loadedMesh = LoadMeshFile(options.meshFile);
+        if (!loadedMesh)
+            return EXIT_FAILURE;
+    }
+
+    // Rebuilt every frame, the vertices go through a ring of per-frame regions instead of the mesh's own buffer
+    const auto meshStream = Gl::StreamBuffer::Create(64 * 1024);
+    auto arc = std::make_unique<DynamicMesh>(ColoredLayout);
+    arc->EnableStreaming(meshStream);
+    uint32_t arcFrame = 0;
+
+    auto quads = std::make_unique<DynamicMesh>(ColoredLayout);
+    const auto quadInstanceBuffer = quads->CreateNewVertexBuffer(QuadInstanceLayout);
+    quads->SetMeshData(std::move(quadData));
+    quads->SetVertexData(quadInstanceBuffer, std::move(quadInstanceData.Vertices));
+    quads->Flush();
+
+    const auto shaderWaitStart = std::chrono::steady_clock::now();
+    if (!shaderBatch.Wait()) {
+        fprintf(stderr, "Failed to compile shaders");
+        return EXIT_FAILURE;
+    }
+    shaderLoadTime += std::chrono::steady_clock::now() - shaderWaitStart;
+
+    const auto& loadedShaders = shaderBatch.GetShaders();
+    const bool warmCache = std::all_of(loadedShaders.begin(), loadedShaders.end(), [](const auto& s) { return s->IsFromBinaryCache(); });
+    fprintf(stderr, "Shaders loaded in %.3f ms (%s%s)\n", shaderLoadTime.count(),
+        warmCache ? "warm, binary cache" : "cold, compiled from source",
+        Gl::Shader::SupportsParallelCompile() ? ", parallel" : "");
+
+    const auto useColor = shader->GetUniform<int>("use_color");
+    const auto checkSize = checkerShader->GetUniform<float>("check_size");
+    const auto firstTransform = transformShader->GetUniform<int>("first_transform");
+
+    // Both logo meshes go out in one multi draw, the color comes from the per draw data
+    BatchRenderer logoBatch(logo[0]->GetLayout(), 1024, 4096, 16);
+    logoBatch.SetShader(batchShader);
+    const auto logoBar = logoBatch.AddMesh(*logo[0]);
+    const auto logoPie = logoBatch.AddMesh(*logo[1]);
+
+    Gl::Profiler profiler;
+    const auto circlePass = profiler.RegisterPass("circle");
+    const auto logoPass = profiler.RegisterPass("logo");
+    const auto gradientsPass = profiler.RegisterPass("gradients");
+    const auto checkerPass = profiler.RegisterPass("checker");
+    const auto instancedPass = profiler.RegisterPass("instanced");
+    const auto queuePass = profiler.RegisterPass("queue");
+    const auto spritesPass = profiler.RegisterPass("sprites");
+    const auto cullingPass = profiler.RegisterPass("culling");
+    const auto transformsPass = profiler.RegisterPass("transforms");
+
+    const std::array<const char*, 9> names{ "circle", "logo", "gradients", "checker", "instanced", "queue", "sprites", "culling", "transforms" };
+
+    // Uniforms of the programs the queue scene uses keep their last value, set them once up front
+    checkerShader->Bind();
+    checkerShader->Set(checkSize, 5.f);
+    shader->Bind();
+    shader->Set(useColor, 0);
+
+    RenderQueue renderQueue;
+
+    // Every image in the directory is loaded while the scenes keep rendering
+    Gl::TextureLoader textureLoader(jobs);
+    std::vector<Gl::TextureHandle> textures;
+    const auto textureLoadStart = std::chrono::steady_clock::now();
+    if (!options.textureDir.empty()) {
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator(options.textureDir, error)) {
+            auto extension = entry.path().extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+            if (extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp")
+                textures.push_back(textureLoader.Load(entry.path().string()));
+        }
+        if (error)
+            fprintf(stderr, "Error opening directory %s\n", options.textureDir.c_str());
+    }
+
+    const auto updateTextures = [&textureLoader, &textures, textureLoadStart]()
+    {
+        if (textureLoader.IsIdle())
+            return;
+        textureLoader.Update();
+        if (!textureLoader.IsIdle())
+            return;
+
+        const std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - textureLoadStart;
+        const auto& stats = textureLoader.GetStats();
+        fprintf(stderr, "Loaded %u of %zu textures (%.1f MB) in %.3f ms through %u pixel buffers\n",
+            stats.Loaded, textures.size(), stats.UploadedBytes / 1e6, time.count(), stats.PixelBuffers);
+    };
+
+    QuadBatch spriteBatch;
+    spriteBatch.SetShader(quadShader);
+
+    // The quads for the next frame are built on the update thread while the current ones are drawn
+    SpriteScene spriteScene(spriteBatch, textures);
+    FramePipeline spritePipeline;
+    spritePipeline.SetPipelined(options.pipeline);
+    spritePipeline.SetScene(&spriteScene);
+    float frameTime = spritePipeline.GetTimestep();
+    FramePipelineStats spriteTotals;
+    uint32_t spriteFrames = 0;
+
+    // 40k small circles and gradients over a world a hundred times the size of the view
+    const uint32_t cullingColumns = 200, cullingRows = 200;
+    const auto cullingTransform = [cullingColumns, cullingRows](uint32_t i, float t)
+    {
+        const float wobble = 0.03f * std::sin(t * 4.f + i);
+        const glm::vec3 position{ ((i % cullingColumns) - cullingColumns / 2.f) * 0.1f + wobble, ((i / cullingColumns) - cullingRows / 2.f) * 0.1f, 0.f };
+        return glm::scale(glm::translate(glm::mat4(1.f), position), glm::vec3(0.04f));
+    };
+
+    Scene cullingScene;
+    std::vector<Scene::ObjectId> cullingObjects;
+    for (uint32_t i = 0; i < cullingColumns * cullingRows; i++)
+        cullingObjects.push_back(cullingScene.Add(i % 3 ? circle : gradients, sceneShader, cullingTransform(i, 0.f)));
+    uint32_t cullingFrame = 0;
+
+    // Planets around the center, moons around the planets and dust around the moons
+    // Created level by level, the first Update sorts them depth first
+    const glm::vec3 zAxis{ 0.f, 0.f, 1.f };
+    TransformHierarchy transforms;
+    const auto sun = transforms.Create();
+    transforms.SetScale(sun, glm::vec3(0.9f));
+    std::vector<TransformHierarchy::NodeId> planets, moons;
+    for (uint32_t i = 0; i < 12; i++) {
+        const float angle = i * PI * 2 / 12;
+        planets.push_back(transforms.Create(sun));
+        transforms.SetLocal(planets.back(), { std::cos(angle) * 0.7f, std::sin(angle) * 0.7f, 0.f }, glm::angleAxis(angle, zAxis), glm::vec3(0.22f));
+    }
+    for (const auto planet : planets) {
+        for (uint32_t i = 0; i < 24; i++) {
+            const float angle = i * PI * 2 / 24;
+            moons.push_back(transforms.Create(planet));
+            transforms.SetLocal(moons.back(), { std::cos(angle) * 0.6f, std::sin(angle) * 0.6f, 0.f }, glm::angleAxis(angle, zAxis), glm::vec3(0.18f));
+        }
+    }
+    for (const auto moon : moons) {
+        for (uint32_t i = 0; i < 16; i++) {
+            const float angle = i * PI * 2 / 16;
+            const auto dust = transforms.Create(moon);
+            transforms.SetLocal(dust, { std::cos(angle) * 0.8f, std::sin(angle) * 0.8f, 0.f }, glm::quat(1.f, 0.f, 0.f, 0.f), glm::vec3(0.25f));
+        }
+    }
+    auto transformQuad = UploadMesh(ColoredLayout, BuildUnitQuad());
+    uint32_t transformFrame = 0;
+
     const std::vector<std::function<void()>> funcs{
-        [&circle, &shader]()
+        [&]()
         {
-            shader.Bind();
-            shader.SetInt("use_color", 0);
+            Gl::ProfileScope scope(profiler, circlePass);
+            shader->Bind();
+            shader->Set(useColor, 0);
         	circle->DrawArrays();
+
+            // An arc running around the circle that grows and shrinks
+            const float t = arcFrame++ * 0.03f;
+            meshStream->BeginFrame();
+            arc->SetMeshData(BuildPie({ 1.f, 1.f, 1.f }, { 0.f, 0.f }, 128, t, t + PI * (1.f + std::sin(t * 0.7f) * 0.8f), 0.55f, 0.6f));
+            arc->Flush();
+            arc->DrawArrays();
+            meshStream->EndFrame();
+
+            if (loadedMesh && loadedMesh->GetIndexCount() > 0)
+                loadedMesh->DrawIndexed();
+            else if (loadedMesh)
+                loadedMesh->DrawArrays();
         },
-        [&logo, &shader]()
+        [&]()
         {
-            shader.Bind();
-            shader.SetInt("use_color", 1);
-            shader.SetFloat3("color", { 0.f, 0.f, 0.6f });
-            logo[0]->DrawIndexed();
-
-            shader.SetFloat3("color", { 0.f, 0.6f, 0.95f });
-            logo[1]->DrawArrays();
+            Gl::ProfileScope scope(profiler, logoPass);
+            logoBatch.Begin();
+            logoBatch.Submit(logoBar, { { 0.f, 0.f, 0.6f, 1.f } });
+            logoBatch.Submit(logoPie, { { 0.f, 0.6f, 0.95f, 1.f } });
+            logoBatch.End();
         },
-        [&gradients, &shader]()
+        [&]()
         {
-            shader.Bind();
-            shader.SetInt("use_color", 0);
+            Gl::ProfileScope scope(profiler, gradientsPass);
+            shader->Bind();
+            shader->Set(useColor, 0);
 	        gradients->DrawIndexed();
         },
-        [&checkers, &checkerShader]()
+        [&]()
         {
-            checkerShader.Bind();
-            checkerShader.SetFloat("check_size", 5);
+            Gl::ProfileScope scope(profiler, checkerPass);
+            checkerShader->Bind();
+            checkerShader->Set(checkSize, 5.f);
             checkers->DrawArrays();
+        },
+        [&]()
+        {
+            Gl::ProfileScope scope(profiler, instancedPass);
+            instancedShader->Bind();
+            quads->DrawIndexedInstanced(320 * 320);
+        },
+        [&]()
+        {
+            // Submitted interleaved, drawn with one switch per program, the checkers stay on top
+            Gl::ProfileScope scope(profiler, queuePass);
+            renderQueue.Begin();
+            for (int i = 0; i < 8; i++)
+            {
+                renderQueue.SubmitArrays(*shader, *circle);
+                renderQueue.SubmitArrays(*checkerShader, *checkers, 1);
+                renderQueue.SubmitIndexed(*shader, *gradients);
+            }
+            renderQueue.End();
+        },
+        [&]()
+        {
+            // 200k spinning quads, then one per loaded texture on top
+            Gl::ProfileScope scope(profiler, spritesPass);
+            spritePipeline.Frame(frameTime);
+
+            const auto& stats = spritePipeline.GetStats();
+            spriteTotals.Steps += stats.Steps;
+            spriteTotals.UpdateMs += stats.UpdateMs;
+            spriteTotals.RenderMs += stats.RenderMs;
+            spriteTotals.WaitMs += stats.WaitMs;
+            spriteFrames++;
+        },
+        [&]()
+        {
+            // The camera circles the world while every 16th object moves, only what's around it gets submitted
+            Gl::ProfileScope scope(profiler, cullingPass);
+            const float t = cullingFrame++ * 0.01f;
+            for (uint32_t i = cullingFrame % 16; i < cullingObjects.size(); i += 16)
+                cullingScene.SetTransform(cullingObjects[i], cullingTransform(i, t));
+
+            const glm::vec3 camera{ std::cos(t) * 6.f, std::sin(t) * 6.f, 0.f };
+            renderQueue.Begin();
+            cullingScene.Submit(renderQueue, glm::translate(glm::mat4(1.f), -camera));
+            renderQueue.End();
+        },
+        [&]()
+        {
+            // One planet turns per frame, only its subtree is recomputed and uploaded
+            Gl::ProfileScope scope(profiler, transformsPass);
+            const float t = transformFrame++ * 0.01f;
+            const auto planet = planets[transformFrame % planets.size()];
+            transforms.SetRotation(planet, glm::angleAxis(t * 3.f, zAxis));
+            transforms.Update();
+            transforms.Upload();
+
+            // Everything but the sun, its descendants are the range after it
+            const uint32_t first = transforms.GetIndex(sun) + 1;
+            transforms.Bind();
+            transformShader->Bind();
+            transformShader->Set(firstTransform, static_cast<int>(first));
+            transformQuad->DrawIndexedInstanced(transforms.GetSubtreeEnd(sun) - first);
         }
     };
 
+    const auto dumpProfile = [&profiler, &options]()
+    {
+        if (options.profileCsv.empty())
+            return true;
+        profiler.Resolve();
+        return profiler.WriteCsv(options.profileCsv);
+    };
+
+    if (options.headless) {
+        Gl::Framebuffer framebuffer(mWidth, mHeight);
+        if (!framebuffer.IsComplete()) {
+            fprintf(stderr, "Offscreen framebuffer is incomplete");
+            return EXIT_FAILURE;
+        }
+        framebuffer.Bind();
+
+        Benchmark benchmark(options.frames);
+        std::vector<Gl::StateCacheStats> stateStats;
+        for (size_t i = 0; i < funcs.size(); i++) {
+            benchmark.Run(names[i], [&funcs, &profiler, &updateTextures, i]()
+            {
+                Gl::StateCache::BeginFrame();
+                profiler.BeginFrame();
+                updateTextures();
+                glClearColor(0.25f, 0.25f, 0.25f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT);
+                funcs[i]();
+                profiler.EndFrame();
+            });
+            Gl::StateCache::BeginFrame();
+            stateStats.push_back(Gl::StateCache::GetFrameStats());
+        }
+
+        benchmark.Print(std::cout);
+        for (size_t i = 0; i < stateStats.size(); i++)
+            printf("%-16s %u state changes issued, %u elided per frame\n", names[i], stateStats[i].Issued, stateStats[i].Elided);
+        const auto& spriteStats = spriteBatch.GetStats();
+        printf("sprites          %u quads in %u draw calls per frame (%u capacity, %u texture flushes)\n",
+            spriteStats.Quads, spriteStats.DrawCalls, spriteStats.CapacityFlushes, spriteStats.TextureFlushes);
+        spriteFrames = std::max(spriteFrames, 1u);
+        printf("sprites          %.3f ms update, %.3f ms render, %.3f ms waiting per frame (%s)\n",
+            spriteTotals.UpdateMs / spriteFrames, spriteTotals.RenderMs / spriteFrames, spriteTotals.WaitMs / spriteFrames,
+            spritePipeline.IsPipelined() ? "pipelined" : "serial");
+        const auto& cullingStats = cullingScene.GetStats();
+        printf("culling          %u of %u objects visible, %u culled, %u BVH nodes tested per frame\n",
+            cullingStats.Visible, cullingStats.Objects, cullingStats.Culled, cullingStats.NodesTested);
+        const auto& transformStats = transforms.GetStats();
+        printf("transforms       %u of %u nodes updated, %zu bytes in %u uploads per frame\n",
+            transformStats.Updated, transformStats.Nodes, transformStats.UploadedBytes, transformStats.Uploads);
+        if (!options.csv.empty() && !benchmark.WriteCsv(options.csv))
+            return EXIT_FAILURE;
+        if (!dumpProfile())
+            return EXIT_FAILURE;
+
+        return EXIT_SUCCESS;
+    }
+
+    // Edits to the shaders in the source tree get recompiled and swapped in while running
+    ShaderWatcher shaderWatcher(PROJECT_SOURCE_DIR "/shaders");
+    shaderWatcher.Watch(shader, PROJECT_SOURCE_DIR "/shaders/triangle.vert", PROJECT_SOURCE_DIR "/shaders/triangle.frag");
+    shaderWatcher.Watch(checkerShader, PROJECT_SOURCE_DIR "/shaders/checker.vert", PROJECT_SOURCE_DIR "/shaders/checker.frag");
+    shaderWatcher.Watch(batchShader, PROJECT_SOURCE_DIR "/shaders/batch.vert", PROJECT_SOURCE_DIR "/shaders/batch.frag");
+    shaderWatcher.Watch(instancedShader, PROJECT_SOURCE_DIR "/shaders/instanced.vert", PROJECT_SOURCE_DIR "/shaders/instanced.frag");
+    shaderWatcher.Watch(quadShader, PROJECT_SOURCE_DIR "/shaders/quad.vert", PROJECT_SOURCE_DIR "/shaders/quad.frag");
+    shaderWatcher.Watch(sceneShader, PROJECT_SOURCE_DIR "/shaders/scene.vert", PROJECT_SOURCE_DIR "/shaders/triangle.frag");
+    shaderWatcher.Watch(transformShader, PROJECT_SOURCE_DIR "/shaders/transform.vert", PROJECT_SOURCE_DIR "/shaders/triangle.frag");
+
     int idx = 0;
+    auto lastFrame = std::chrono::steady_clock::now();
 
     // Rendering Loop
     while (glfwWindowShouldClose(mWindow) == false) {
@@ -308,6 +1002,26 @@ int main(int argc, char * argv[]) {
             idx = 2;
         if (glfwGetKey(mWindow, GLFW_KEY_4) == GLFW_PRESS)
             idx = 3;
+        if (glfwGetKey(mWindow, GLFW_KEY_5) == GLFW_PRESS)
+            idx = 4;
+        if (glfwGetKey(mWindow, GLFW_KEY_6) == GLFW_PRESS)
+            idx = 5;
+        if (glfwGetKey(mWindow, GLFW_KEY_7) == GLFW_PRESS)
+            idx = 6;
+        if (glfwGetKey(mWindow, GLFW_KEY_8) == GLFW_PRESS)
+            idx = 7;
+        if (glfwGetKey(mWindow, GLFW_KEY_9) == GLFW_PRESS)
+            idx = 8;
+
+        const auto now = std::chrono::steady_clock::now();
+        frameTime = std::chrono::duration<float>(now - lastFrame).count();
+        lastFrame = now;
+
+        shaderWatcher.Update();
+
+        Gl::StateCache::BeginFrame();
+        profiler.BeginFrame();
+        updateTextures();
 
         // Background Fill Color
         glClearColor(0.25f, 0.25f, 0.25f, 1.0f);
@@ -315,12 +1029,16 @@ int main(int argc, char * argv[]) {
 
         funcs[idx]();
 
+        profiler.EndFrame();
+
         // Flip Buffers and Draw
         glfwSwapBuffers(mWindow);
         glfwPollEvents();
     }
 
+    dumpProfile();
+
     glfwDestroyWindow(mWindow);
 	glfwTerminate();
     return EXIT_SUCCESS;
-}
+}
\ No newline at end of file